@@ -19,8 +19,15 @@ EXPORTS
 	NSHasCommandHandler
 	NSHasMessageHandler
 	NSHandleMessage
+{%if module.log_handler %}
+	NSGetMessageFilter
+{% endif %}
 	NSHandleCommand
 	NSDeleteBuffer
+{% if module.commands or module.command_fallback %}
+	NSGetProtobufRuntime
+	NSHandleCommandMessage
+{% endif %}
 {% if module.channels %}
 	NSHasNotificationHandler
 	NSHandleNotification
@@ -157,10 +164,17 @@ bool {{module.name}}Module::unloadModule() {
  * @return status code
  */
 NSCAPI::nagiosReturn {{module.name}}Module::handleRAWCommand(const std::string &request, std::string &response) {
+	Plugin::QueryRequestMessage request_message;
 	Plugin::QueryResponseMessage response_message;
+	request_message.ParseFromString(request);
+	NSCAPI::nagiosReturn ret = handleCommand(request_message, response_message);
+	if (ret == NSCAPI::cmd_return_codes::isSuccess)
+		response_message.SerializeToString(&response);
+	return ret;
+}
+
+NSCAPI::nagiosReturn {{module.name}}Module::handleCommand(const Plugin::QueryRequestMessage &request_message, Plugin::QueryResponseMessage &response_message) {
 	try {
-		Plugin::QueryRequestMessage request_message;
-		request_message.ParseFromString(request);
 		nscapi::protobuf::functions::make_return_header(response_message.mutable_header(), request_message.header());
 
 		if (!impl_) {
@@ -170,7 +184,7 @@ NSCAPI::nagiosReturn {{module.name}}Module::handleRAWCommand(const std::string &
 				impl_->query_fallback(request_message, response_message);
 {% else %}
 		for (int i=0;i<request_message.payload_size();i++) {
-			Plugin::QueryRequestMessage::Request request_payload = request_message.payload(i);
+			const Plugin::QueryRequestMessage::Request &request_payload = request_message.payload(i);
 			if (!impl_) {
 				return NSCAPI::cmd_return_codes::returnIgnored;
 {% for cmd in module.commands %}
@@ -179,7 +193,6 @@ NSCAPI::nagiosReturn {{module.name}}Module::handleRAWCommand(const std::string &
 {% elif cmd.raw_mapping %}
 			} else if (request_payload.command() == "{{cmd.name|lower}}") {
 				impl_->{{cmd_name}}("{{cmd.name|lower}}", request_message, &response_message);
-				response_message.SerializeToString(&response);
 				return NSCAPI::cmd_return_codes::isSuccess;
 {% elif cmd.nagios %}
 			} else if (request_payload.command() == "{{cmd.name|lower}}") {
@@ -243,7 +256,6 @@ NSCAPI::nagiosReturn {{module.name}}Module::handleRAWCommand(const std::string &
         payload->set_result(Plugin::Common_ResultCode_UNKNOWN);
         payload->add_lines()->set_message("Failed to process command ");
 	}
-    response_message.SerializeToString(&response);
     return NSCAPI::cmd_return_codes::isSuccess;
 }
 
@@ -560,6 +572,10 @@ extern NSCAPI::boolReturn NSHasMessageHandler(unsigned int id) {
 	nscapi::message_wrapper<plugin_impl_class> wrapper(plugin_instance.get(id));
 	return wrapper.NSHasMessageHandler();
 }
+extern void NSGetMessageFilter(unsigned int, NSCAPI::log_level::level *level, const char **modules) {
+	*level = NSCAPI::log_level::{{module.log_level}};
+	*modules = "{{module.log_modules|join(',')|cstring}}";
+}
 {% else %}
 extern void NSHandleMessage(unsigned int, const char*, unsigned int) {}
 extern NSCAPI::boolReturn NSHasMessageHandler(unsigned int) { return NSCAPI::bool_return::isfalse; }
@@ -573,6 +589,13 @@ extern NSCAPI::boolReturn NSHasCommandHandler(unsigned int id) {
 	nscapi::command_wrapper<plugin_impl_class> wrapper(plugin_instance.get(id));
 	return wrapper.NSHasCommandHandler(); 
 }
+extern void NSGetProtobufRuntime(const void **messages, const void **library) {
+	nscapi::protobuf::get_runtime(messages, library);
+}
+extern NSCAPI::nagiosReturn NSHandleCommandMessage(unsigned int id, const void *request, void *response) {
+	nscapi::command_wrapper<plugin_impl_class> wrapper(plugin_instance.get(id));
+	return wrapper.NSHandleCommandMessage(*static_cast<const Plugin::QueryRequestMessage*>(request), *static_cast<Plugin::QueryResponseMessage*>(response));
+}
 {% else %}
 extern NSCAPI::nagiosReturn NSHandleCommand(unsigned int, const char*, const unsigned int, char**, unsigned int*) {  return NSCAPI::cmd_return_codes::returnIgnored; }
 extern NSCAPI::boolReturn NSHasCommandHandler(unsigned int) { return NSCAPI::api_return_codes::hasFailed; }
@@ -628,7 +651,14 @@ extern "C" int NSGetModuleVersion(int *major, int *minor, int *revision);
 extern "C" NSCAPI::boolReturn NSHasCommandHandler(unsigned int plugin_id);
 extern "C" NSCAPI::boolReturn NSHasMessageHandler(unsigned int plugin_id);
 extern "C" void NSHandleMessage(unsigned int plugin_id, const char* data, unsigned int len);
+{%if module.log_handler %}
+extern "C" void NSGetMessageFilter(unsigned int plugin_id, NSCAPI::log_level::level *level, const char **modules);
+{% endif %}
 extern "C" NSCAPI::nagiosReturn NSHandleCommand(unsigned int plugin_id, const char* request_buffer, const unsigned int request_buffer_len, char** reply_buffer, unsigned int *reply_buffer_len);
+{% if module.commands or module.command_fallback %}
+extern "C" void NSGetProtobufRuntime(const void **messages, const void **library);
+extern "C" NSCAPI::nagiosReturn NSHandleCommandMessage(unsigned int plugin_id, const void *request, void *response);
+{% endif %}
 extern "C" int NSUnloadModule(unsigned int plugin_id);
 {%if module.cli %}
 extern "C" int NSCommandLineExec(unsigned int plugin_id, const int target_mode, char *request_buffer, unsigned int request_len, char **response_buffer, unsigned int *response_len);
@@ -691,6 +721,7 @@ public:
 	bool hasCommandHandler() { return false; }
 {% endif %}
 	NSCAPI::nagiosReturn handleRAWCommand(const std::string &request, std::string &response);
+	NSCAPI::nagiosReturn handleCommand(const Plugin::QueryRequestMessage &request, Plugin::QueryResponseMessage &response);
 
 /* Add the following to {{module.name}}
 
@@ -771,6 +802,8 @@ command_fallback_raw = False
 module = None
 cli = False
 log_handler = False
+log_level = 'trace'
+log_modules = []
 channels = False
 metrics = False
 events = False
@@ -925,6 +958,16 @@ for key, value in data.iteritems():
 	elif key == "log messages":
 		if value:
 			log_handler = True
+		if type(value) is dict:
+			if 'level' in value:
+				log_level = value['level']
+				if log_level not in ['critical', 'error', 'warning', 'info', 'debug', 'trace']:
+					raise Exception('Invalid log level: %s'%log_level)
+			if 'modules' in value:
+				if type(value['modules']) is list:
+					log_modules = value['modules']
+				else:
+					log_modules = [ value['modules'] ]
 	elif key == "metrics":
 		metrics = value
 	elif key == "events":
@@ -967,6 +1010,8 @@ module.cli = cli
 module.channels = channels
 module.metrics = metrics
 module.log_handler = log_handler
+module.log_level = log_level
+module.log_modules = log_modules
 module.command_fallback = command_fallback
 module.command_fallback_raw = command_fallback_raw
 module.events = events
@@ -124,6 +124,10 @@ namespace nscapi {
 		typedef NSCAPI::nagiosReturn(*lpNSAPIExecCommand)(const char* target, const char *request, const unsigned int request_len, char ** response, unsigned int * response_len);
 		typedef NSCAPI::errorReturn(*lpNSAPINotify)(const char* channel, const char* buffer, unsigned int buffer_len, char ** result_buffer, unsigned int *result_buffer_len);
 
+		// Message objects (Plugin::QueryRequestMessage etc.) can only be passed when both sides use the same protobuf runtime.
+		typedef void(*lpNSAPIGetProtobufRuntime)(const void **messages, const void **library);
+		typedef NSCAPI::nagiosReturn(*lpNSAPIInjectMessage)(const void *request, void *response);
+
 		// TODO: investigate
 		typedef NSCAPI::boolReturn(*lpNSAPICheckLogMessages)(int);
 
@@ -134,6 +138,9 @@ namespace nscapi {
 		typedef NSCAPI::errorReturn(*lpNSCAPIEmitEvent)(const char*, int);
 
 		typedef NSCAPI::errorReturn(*lpNSAPIStorageQuery)(const char *, const unsigned int, char **, unsigned int *);
+
+		typedef void(*lpNSAPITask)(void*);
+		typedef NSCAPI::errorReturn(*lpNSAPISubmitTask)(lpNSAPITask, void*);
 		
 	}
 
@@ -149,9 +156,12 @@ namespace nscapi {
 
 		typedef NSCAPI::errorReturn(*lpHasCommandHandler)(unsigned int plugin_id);
 		typedef NSCAPI::errorReturn(*lpHandleCommand)(unsigned int plugin_id, const char* in_buffer, const unsigned int in_buffer_len, char** out_buffer, unsigned int* out_buffer_len);
+		typedef void(*lpGetProtobufRuntime)(const void **messages, const void **library);
+		typedef NSCAPI::errorReturn(*lpHandleCommandMessage)(unsigned int plugin_id, const void *request, void *response);
 
 		typedef NSCAPI::errorReturn(*lpHasMessageHandler)(unsigned int plugin_id);
 		typedef NSCAPI::errorReturn(*lpHandleMessage)(unsigned int plugin_id, const char* buffer, const unsigned int buffer_len);
+		typedef void(*lpGetMessageFilter)(unsigned int plugin_id, NSCAPI::log_level::level *level, const char **modules);
 
 		typedef NSCAPI::errorReturn(*lpHasNotificationHandler)(unsigned int plugin_id);
 		typedef NSCAPI::errorReturn(*lpHandleNotification)(unsigned int plugin_id, const char *channel, const char* buffer, unsigned int buffer_len, char **result_buffer, unsigned int *result_buffer_len);
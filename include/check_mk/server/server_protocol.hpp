@@ -101,6 +101,10 @@ namespace check_mk {
 		bool has_data() {
 			return current_state_ == connected;
 		}
+		bool is_pending() const {
+			return false;
+		}
+		void set_dispatcher(socket_helpers::server::dispatcher_type) {}
 
 		bool on_read(char *, char *) {
 			return true;
@@ -108,8 +112,8 @@ namespace check_mk {
 		void on_write() {
 			set_state(done);
 		}
-		outbound_buffer_type get_outbound() const {
-			return data_;
+		void get_outbound(socket_helpers::buffer_list &buffers) const {
+			buffers.push_back(socket_helpers::buffer_pool::get_default()->acquire_copy(data_));
 		}
 
 		socket_helpers::connection_info get_info() const {
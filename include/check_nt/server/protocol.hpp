@@ -39,7 +39,6 @@ namespace check_nt {
 	struct read_protocol : public boost::noncopyable {
 		static const bool debug_trace = false;
 
-		typedef std::vector<char> outbound_buffer_type;
 		typedef boost::array<char, socket_bufer_size>::iterator iterator_type;
 		typedef check_nt::server::handler* handler_type;
 
@@ -96,6 +95,10 @@ namespace check_nt {
 		bool has_data() {
 			return current_state_ == got_request;
 		}
+		bool is_pending() const {
+			return false;
+		}
+		void set_dispatcher(socket_helpers::server::dispatcher_type) {}
 
 		bool on_read(char *begin, char *end) {
 			while (begin != end) {
@@ -128,8 +131,8 @@ namespace check_nt {
 			set_state(done);
 		}
 
-		std::vector<char> get_outbound() const {
-			return data_;
+		void get_outbound(socket_helpers::buffer_list &buffers) const {
+			buffers.push_back(socket_helpers::buffer_pool::get_default()->acquire_copy(data_));
 		}
 
 		socket_helpers::connection_info get_info() const {
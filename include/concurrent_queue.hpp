@@ -22,6 +22,7 @@
 #include <queue>
 #include <boost/thread/condition_variable.hpp>
 #include <boost/thread/shared_mutex.hpp>
+#include <boost/thread/thread_time.hpp>
 
 template<typename T>
 class concurrent_queue {
@@ -66,4 +67,16 @@ public:
 		}
 	}
 
+	bool timed_wait_and_pop(T& popped_value, const boost::system_time &deadline) {
+		boost::mutex::scoped_lock lock(mutex_);
+		while(queue_.empty()) {
+			if (!condition_.timed_wait(lock, deadline) && queue_.empty())
+				return false;
+		}
+
+		popped_value=queue_.front();
+		queue_.pop();
+		return true;
+	}
+
 };
\ No newline at end of file
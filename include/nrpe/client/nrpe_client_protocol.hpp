@@ -67,6 +67,7 @@ namespace nrpe {
 			}
 			void prepare_request(request_type &packet) {
 				set_state(has_request);
+				responses_.clear();
 				payload_length_ = packet.get_payload_length();
 				buffer_ = packet.get_buffer();
 			}
@@ -86,6 +87,9 @@ namespace nrpe {
 			response_type get_response() {
 				return responses_;
 			}
+			static bool is_keep_alive_response(const response_type &response) {
+				return response.size() == 1 && nrpe::packet::is_keep_alive_response(response.front());
+			}
 			bool has_data() {
 				return current_state_ == has_request;
 			}
@@ -156,6 +156,16 @@ namespace nrpe {
 		static packet make_request(std::string payload, unsigned int buffer_length) {
 			return packet(nrpe::data::queryPacket, nrpe::data::version2, -1, payload, buffer_length);
 		}
+		// Asks the server to keep the connection open after each response (an NSClient++ extension, other servers reply UNKNOWN)
+		static std::string keep_alive_command() {
+			return "_NRPE_KEEPALIVE";
+		}
+		static packet make_keep_alive_request(unsigned int buffer_length) {
+			return make_request(keep_alive_command(), buffer_length);
+		}
+		static bool is_keep_alive_response(const packet &response) {
+			return response.getResult() == 0 && response.getPayload().compare(0, 10, "keep-alive") == 0;
+		}
 		static char* payload_offset(nrpe::data::packet *p) {
 			return &reinterpret_cast<char*>(p)[nrpe::data::buffer_offset];
 		}
@@ -172,26 +182,34 @@ namespace nrpe {
 			return std::string(data);
 		}
 
-		const char* create_buffer() {
-			delete[] tmpBuffer;
-			unsigned int packet_length = nrpe::length::get_packet_length(payload_length_);
-			tmpBuffer = new char[packet_length + 1];
-			memset(tmpBuffer, 0, packet_length + 1);
-			nrpe::data::packet *p = reinterpret_cast<nrpe::data::packet*>(tmpBuffer);
+		// Encodes the packet into buffer (which has to be get_packet_length() bytes)
+		void write_to(char *buffer) {
+			if (payload_.length() >= payload_length_)
+				throw nrpe::nrpe_exception("To much data cant create return packet (truncate data)");
+			unsigned int packet_length = get_packet_length();
+			memset(buffer, 0, packet_length);
+			nrpe::data::packet *p = reinterpret_cast<nrpe::data::packet*>(buffer);
 			p->result_code = swap_bytes::hton<int16_t>(result_);
 			p->packet_type = swap_bytes::hton<int16_t>(type_);
 			p->packet_version = swap_bytes::hton<int16_t>(version_);
-			if (payload_.length() >= payload_length_)
-				throw nrpe::nrpe_exception("To much data cant create return packet (truncate data)");
 			update_payload(p, payload_);
 			p->crc32_value = 0;
-			crc32_ = p->crc32_value = swap_bytes::hton<uint32_t>(calculate_crc32(tmpBuffer, packet_length));
+			crc32_ = p->crc32_value = swap_bytes::hton<uint32_t>(calculate_crc32(buffer, packet_length));
+		}
+
+		const char* create_buffer() {
+			delete[] tmpBuffer;
+			tmpBuffer = NULL;
+			unsigned int packet_length = get_packet_length();
+			tmpBuffer = new char[packet_length + 1];
+			tmpBuffer[packet_length] = 0;
+			write_to(tmpBuffer);
 			return tmpBuffer;
 		}
 
 		std::vector<char> get_buffer() {
-			const char *c = create_buffer();
-			std::vector<char> buf(c, c + get_packet_length());
+			std::vector<char> buf(get_packet_length());
+			write_to(&buf[0]);
 			return buf;
 		}
 
@@ -23,13 +23,17 @@
 
 #include <boost/tuple/tuple.hpp>
 #include <boost/noncopyable.hpp>
+#include <boost/function.hpp>
 
 #include <list>
 namespace nrpe {
 	namespace server {
 		class handler : boost::noncopyable {
 		public:
+			typedef boost::function<void(std::list<nrpe::packet>)> response_callback;
 			virtual std::list<nrpe::packet> handle(nrpe::packet packet) = 0;
+			// Handles the request (possibly on another thread) and calls the callback exactly once with the response.
+			virtual void handle_async(nrpe::packet packet, response_callback callback) = 0;
 			virtual void log_debug(std::string module, std::string file, int line, std::string msg) const = 0;
 			virtual void log_error(std::string module, std::string file, int line, std::string msg) const = 0;
 			virtual nrpe::packet create_error(std::string msg) = 0;
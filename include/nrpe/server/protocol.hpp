@@ -42,24 +42,23 @@ namespace nrpe {
 	// Connection states:
 	// on_accept
 	// on_connect	-> connected	wants_data = true
-	// on_read		-> has_more		has_data = true
-	// on_write		-> has_more		has_data = true
-	// on_write		-> last_packet	has_data = true
+	// on_read		-> pending		is_pending = true
+	// on_response	-> responding	has_data = true (all packets of the response are written at once)
 	// on_write		-> done
+	// on_write		-> connected	wants_data = true (keep-alive, after _NRPE_KEEPALIVE was accepted)
 
 	static const int socket_bufer_size = 8096;
-	struct read_protocol : public boost::noncopyable {
+	struct read_protocol : public boost::enable_shared_from_this<read_protocol>, public boost::noncopyable {
 		static const bool debug_trace = false;
 
-		typedef std::vector<char> outbound_buffer_type;
 		typedef nrpe::server::handler *handler_type;
 		typedef boost::array<char, socket_bufer_size>::iterator iterator_type;
 
 		enum state {
 			none,
 			connected,
-			has_more,
-			last_packet,
+			pending,
+			responding,
 			done
 		};
 
@@ -67,8 +66,11 @@ namespace nrpe {
 		handler_type handler_;
 		nrpe::server::parser parser_;
 		state current_state_;
-		outbound_buffer_type data_;
-		std::list<nrpe::packet> responses_;
+		socket_helpers::buffer_list outbound_;
+		socket_helpers::server::dispatcher_type dispatcher_;
+		// Data read but not yet parsed (pipelined requests wait here until the previous one is answered)
+		std::vector<char> backlog_;
+		bool keep_alive_;
 
 		static boost::shared_ptr<read_protocol> create(socket_helpers::connection_info info, handler_type handler) {
 			return boost::shared_ptr<read_protocol>(new read_protocol(info, handler));
@@ -78,7 +80,8 @@ namespace nrpe {
 			: info_(info)
 			, handler_(handler)
 			, parser_(handler->get_payload_length())
-			, current_state_(none) {}
+			, current_state_(none)
+			, keep_alive_(false) {}
 
 		inline void set_state(state new_state) {
 			current_state_ = new_state;
@@ -109,55 +112,103 @@ namespace nrpe {
 			return current_state_ == connected;
 		}
 		bool has_data() {
-			return current_state_ == has_more || current_state_ == last_packet;
+			return current_state_ == responding;
+		}
+		bool is_pending() const {
+			return current_state_ == pending;
+		}
+		void set_dispatcher(socket_helpers::server::dispatcher_type dispatcher) {
+			dispatcher_ = dispatcher;
 		}
 
 		bool on_read(char *begin, char *end) {
-			while (begin != end) {
+			backlog_.insert(backlog_.end(), begin, end);
+			return process_backlog();
+		}
+		bool process_backlog() {
+			std::vector<char>::iterator begin = backlog_.begin(), end = backlog_.end();
+			while (current_state_ == connected && begin != end) {
 				bool result;
-				iterator_type old_begin = begin;
+				std::vector<char>::iterator old_begin = begin;
 				boost::tie(result, begin) = parser_.digest(begin, end);
 				if (result) {
-					try {
-						nrpe::packet request = parser_.parse();
-						responses_ = handler_->handle(request);
-					} catch (const std::exception &e) {
-						responses_.push_back(handler_->create_error("Exception processing request: " + utf8::utf8_from_native(e.what())));
-					} catch (...) {
-						responses_.push_back(handler_->create_error("Exception processing request"));
-					}
-					queue_next();
+					backlog_.erase(backlog_.begin(), begin);
+					start_request();
 					return true;
 				} else if (begin == old_begin) {
 					log_error(__FILE__, __LINE__, "Digester failed to parse chunk, giving up.");
 					return false;
 				}
 			}
+			backlog_.erase(backlog_.begin(), begin);
 			return true;
 		}
-		bool has_more_response() const {
-			return !responses_.empty();
-		}
-		void queue_next() {
+		void start_request() {
 			try {
-				data_ = responses_.front().get_buffer();
-				responses_.pop_front();
-				if (has_more_response())
-					set_state(has_more);
-				else
-					set_state(last_packet);
+				nrpe::packet request = parser_.parse();
+				if (request.getPayload() == nrpe::packet::keep_alive_command()) {
+					std::list<nrpe::packet> responses;
+					if (info_.idle_timeout > 0) {
+						keep_alive_ = true;
+						responses.push_back(nrpe::packet::create_response(0, "keep-alive: " + str::xtos(info_.idle_timeout), request.get_payload_length()));
+					} else {
+						responses.push_back(nrpe::packet::create_response(3, "Keep-alive is not enabled", request.get_payload_length()));
+					}
+					queue_responses(responses);
+					return;
+				}
+				set_state(pending);
+				handler_->handle_async(request, boost::bind(&read_protocol::on_response, shared_from_this(), _1));
+				return;
 			} catch (const std::exception &e) {
-				log_debug(__FILE__, __LINE__, "Failed to create return package: " + utf8::utf8_from_native(e.what()));
+				queue_error("Exception processing request: " + utf8::utf8_from_native(e.what()));
+			} catch (...) {
+				queue_error("Exception processing request");
 			}
+			// We cannot trust the rest of the stream after a broken request
+			keep_alive_ = false;
+		}
+		void queue_error(std::string msg) {
+			std::list<nrpe::packet> responses;
+			responses.push_back(handler_->create_error(msg));
+			queue_responses(responses);
+		}
+		// Called by the handler (from any thread) so we hand the response over to the connection.
+		void on_response(std::list<nrpe::packet> responses) {
+			if (dispatcher_)
+				dispatcher_(boost::bind(&read_protocol::set_responses, shared_from_this(), responses));
+		}
+		void set_responses(std::list<nrpe::packet> responses) {
+			if (responses.empty())
+				responses.push_back(handler_->create_error("No response to request"));
+			queue_responses(responses);
+		}
+		// Encodes the packets straight into pooled buffers (a connection which ends up with nothing to send is closed)
+		void queue_responses(std::list<nrpe::packet> &responses) {
+			boost::shared_ptr<socket_helpers::buffer_pool> pool = socket_helpers::buffer_pool::get_default();
+			BOOST_FOREACH(nrpe::packet &p, responses) {
+				try {
+					socket_helpers::shared_buffer buffer = pool->acquire(p.get_packet_length());
+					p.write_to(&(*buffer)[0]);
+					outbound_.push_back(buffer);
+				} catch (const std::exception &e) {
+					log_error(__FILE__, __LINE__, "Failed to create return package: " + utf8::utf8_from_native(e.what()));
+				}
+			}
+			set_state(outbound_.empty() ? done : responding);
 		}
 		void on_write() {
-			if (current_state_ == last_packet)
+			if (keep_alive_) {
+				set_state(connected);
+				if (!process_backlog())
+					set_state(done);
+			} else {
 				set_state(done);
-			else
-				queue_next();
+			}
 		}
-		std::vector<char> get_outbound() const {
-			return data_;
+		void get_outbound(socket_helpers::buffer_list &buffers) {
+			buffers.insert(buffers.end(), outbound_.begin(), outbound_.end());
+			outbound_.clear();
 		}
 
 		socket_helpers::connection_info get_info() const {
@@ -39,7 +39,6 @@ namespace nsca {
 	struct read_protocol : public boost::noncopyable {
 		static const bool debug_trace = false;
 
-		typedef std::string outbound_buffer_type;
 		typedef nsca::server::handler *handler_type;
 		typedef boost::array<char, socket_bufer_size>::iterator iterator_type;
 
@@ -106,6 +105,10 @@ namespace nsca {
 		bool has_data() {
 			return current_state_ == connected;
 		}
+		bool is_pending() const {
+			return false;
+		}
+		void set_dispatcher(socket_helpers::server::dispatcher_type) {}
 
 		bool on_write() {
 			set_state(sent_iv);
@@ -139,8 +142,8 @@ namespace nsca {
 			}
 			return true;
 		}
-		std::string get_outbound() const {
-			return data_;
+		void get_outbound(socket_helpers::buffer_list &buffers) const {
+			buffers.push_back(socket_helpers::buffer_pool::get_default()->acquire_copy(data_));
 		}
 
 		socket_helpers::connection_info get_info() const {
@@ -64,15 +64,40 @@ nscapi::core_helper::storage_map nscapi::core_helper::get_storage_strings(std::s
 }
 
 bool nscapi::core_helper::put_storage(std::string context, std::string key, std::string value, bool private_data, bool binary_data) {
-	Plugin::StorageRequestMessage rrm;
-	Plugin::StorageRequestMessage::Request *payload = rrm.add_payload();
+	storage_map values;
+	values[key] = value;
+	return put_storage(context, values, private_data, binary_data);
+}
+
+// All values are sent in one request so the core can store them as a single batch.
+bool nscapi::core_helper::put_storage(std::string context, const storage_map &values, bool private_data, bool binary_data) {
+	if (values.empty())
+		return true;
+	return store(context, values, private_data, binary_data, false);
+}
+
+// Removes everything stored in the context before storing the values (in the same request).
+bool nscapi::core_helper::replace_storage(std::string context, const storage_map &values, bool private_data, bool binary_data) {
+	return store(context, values, private_data, binary_data, true);
+}
 
-	payload->set_plugin_id(plugin_id_);
-	payload->mutable_put()->mutable_entry()->set_context(context);
-	payload->mutable_put()->mutable_entry()->set_key(key);
-	payload->mutable_put()->mutable_entry()->mutable_value()->set_string_data(value);
-	payload->mutable_put()->mutable_entry()->set_private_data(private_data);
-	payload->mutable_put()->mutable_entry()->set_binary_data(binary_data);
+bool nscapi::core_helper::store(std::string context, const storage_map &values, bool private_data, bool binary_data, bool replace) {
+	Plugin::StorageRequestMessage rrm;
+	if (replace) {
+		Plugin::StorageRequestMessage::Request *payload = rrm.add_payload();
+		payload->set_plugin_id(plugin_id_);
+		payload->mutable_remove()->set_context(context);
+	}
+	BOOST_FOREACH(const storage_map::value_type &v, values) {
+		Plugin::StorageRequestMessage::Request *payload = rrm.add_payload();
+
+		payload->set_plugin_id(plugin_id_);
+		payload->mutable_put()->mutable_entry()->set_context(context);
+		payload->mutable_put()->mutable_entry()->set_key(v.first);
+		payload->mutable_put()->mutable_entry()->mutable_value()->set_string_data(v.second);
+		payload->mutable_put()->mutable_entry()->set_private_data(private_data);
+		payload->mutable_put()->mutable_entry()->set_binary_data(binary_data);
+	}
 	std::string buffer;
 	get_core()->storage_query(rrm.SerializeAsString(), buffer);
 
@@ -225,17 +250,34 @@ bool nscapi::core_helper::emit_event(const std::string module, const std::string
 * @return The return of the command
 */
 NSCAPI::nagiosReturn nscapi::core_helper::simple_query(const std::string command, const std::list<std::string> & argument, std::string & msg, std::string & perf, std::size_t max_length) {
-	std::string response;
-	simple_query(command, argument, response);
-	if (!response.empty()) {
-		try {
-			return nscapi::protobuf::functions::parse_simple_query_response(response, msg, perf, max_length);
-		} catch (std::exception &e) {
-			CORE_LOG_ERROR_EXR("Failed to extract return message: ", e);
+	Plugin::QueryRequestMessage request;
+	Plugin::QueryResponseMessage response;
+	Plugin::QueryRequestMessage::Request *payload = request.add_payload();
+	payload->set_command(command);
+	BOOST_FOREACH(const std::string &s, argument) {
+		payload->add_arguments(s);
+	}
+	try {
+		if (!query(request, response))
 			return NSCAPI::query_return_codes::returnUNKNOWN;
-		}
+		return nscapi::protobuf::functions::parse_simple_query_response(response, msg, perf, max_length);
+	} catch (std::exception &e) {
+		CORE_LOG_ERROR_EXR("Failed to extract return message: ", e);
+		return NSCAPI::query_return_codes::returnUNKNOWN;
 	}
-	return NSCAPI::query_return_codes::returnUNKNOWN;
+}
+
+/**
+* Execute a query passing the messages directly to the core when it shares our protobuf runtime.
+* Otherwise the messages are serialized.
+*/
+bool nscapi::core_helper::query(const Plugin::QueryRequestMessage &request, Plugin::QueryResponseMessage &response) {
+	if (nscapi::protobuf::is_same_runtime(get_core()->get_protobuf_runtime()))
+		return get_core()->query(request, response);
+	std::string buffer;
+	if (!get_core()->query(request.SerializeAsString(), buffer))
+		return false;
+	return response.ParseFromString(buffer);
 }
 
 bool nscapi::core_helper::simple_query(const std::string command, const std::list<std::string> & arguments, std::string & result) {
@@ -265,17 +307,7 @@ NSCAPI::nagiosReturn nscapi::core_helper::simple_query_from_nrpe(const std::stri
 	BOOST_FOREACH(std::string s, tok)
 		arglist.push_back(s);
 
-	std::string response;
-	simple_query(command, arglist, response);
-	if (!response.empty()) {
-		try {
-			return nscapi::protobuf::functions::parse_simple_query_response(response, message, perf, max_length);
-		} catch (std::exception &e) {
-			CORE_LOG_ERROR_EXR("Failed to extract return message: ", e);
-			return NSCAPI::query_return_codes::returnUNKNOWN;
-		}
-	}
-	return NSCAPI::query_return_codes::returnUNKNOWN;
+	return simple_query(command, arglist, message, perf, max_length);
 }
 
 NSCAPI::nagiosReturn nscapi::core_helper::exec_simple_command(const std::string target, const std::string command, const std::list<std::string> &argument, std::list<std::string> & result) {
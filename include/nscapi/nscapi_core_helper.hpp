@@ -42,6 +42,7 @@ namespace nscapi {
 		NSCAPI::nagiosReturn simple_query(const std::string command, const std::list<std::string> & argument, std::string & message, std::string & perf, std::size_t max_length);
 		bool simple_query(const std::string command, const std::list<std::string> & argument, std::string & result);
 		bool simple_query(const std::string command, const std::vector<std::string> & argument, std::string & result);
+		bool query(const Plugin::QueryRequestMessage &request, Plugin::QueryResponseMessage &response);
 		NSCAPI::nagiosReturn simple_query_from_nrpe(const std::string command, const std::string & buffer, std::string & message, std::string & perf, std::size_t max_length);
 
 		NSCAPI::nagiosReturn exec_simple_command(const std::string target, const std::string command, const std::list<std::string> &argument, std::list<std::string> & result);
@@ -51,6 +52,8 @@ namespace nscapi {
 
 		typedef std::map<std::string, std::string> storage_map;
 		bool put_storage(std::string context, std::string key, std::string value, bool private_data, bool binary_data);
+		bool put_storage(std::string context, const storage_map &values, bool private_data, bool binary_data);
+		bool replace_storage(std::string context, const storage_map &values, bool private_data, bool binary_data);
 		storage_map get_storage_strings(std::string context);
 
 		bool load_module(std::string name, std::string alias = "");
@@ -58,5 +61,6 @@ namespace nscapi {
 
 	private:
 		const nscapi::core_wrapper* get_core();
+		bool store(std::string context, const storage_map &values, bool private_data, bool binary_data, bool replace);
 	};
 }
\ No newline at end of file
@@ -38,6 +38,8 @@ nscapi::core_wrapper::core_wrapper()
 	, fNSAPIMessage(NULL)
 	, fNSAPISimpleMessage(NULL)
 	, fNSAPIInject(NULL)
+	, fNSAPIInjectMessage(NULL)
+	, fNSAPIGetProtobufRuntime(NULL)
 	, fNSAPIExecCommand(NULL)
 	, fNSAPIDestroyBuffer(NULL)
 	, fNSAPINotify(NULL)
@@ -50,6 +52,8 @@ nscapi::core_wrapper::core_wrapper()
 	, fNSCAPIJson2Protobuf(NULL)
 	, fNSCAPIProtobuf2Json(NULL)
 	, fNSCAPIEmitEvent(NULL)
+	, fNSAPIStorageQuery(NULL)
+	, fNSAPISubmitTask(NULL)
 {}
 nscapi::core_wrapper::~core_wrapper() {
 	delete pimpl;
@@ -190,6 +194,15 @@ bool nscapi::core_wrapper::query(const std::string & request, std::string & resu
 	}
 	return retC;
 }
+bool nscapi::core_wrapper::query(const Plugin::QueryRequestMessage &request, Plugin::QueryResponseMessage &response) const {
+	if (!fNSAPIInjectMessage)
+		throw nsclient::nsclient_exception("NSCore has not been initiated...");
+	bool retC = NSCAPI::api_ok(fNSAPIInjectMessage(&request, &response));
+	if (!retC) {
+		CORE_LOG_ERROR("Failed to execute query");
+	}
+	return retC;
+}
 
 bool nscapi::core_wrapper::exec_command(const std::string target, std::string request, std::string & result) const {
 	char *buffer = NULL;
@@ -273,6 +286,29 @@ bool nscapi::core_wrapper::storage_query(const std::string request, std::string
 	return retC;
 }
 
+namespace {
+	void run_task(void *data) {
+		boost::function<void()> *task = static_cast<boost::function<void()>*>(data);
+		try {
+			(*task)();
+		} catch (...) {
+			// Exceptions must not propagate into the core
+		}
+		delete task;
+	}
+}
+
+bool nscapi::core_wrapper::submit_task(boost::function<void()> task) const {
+	if (!fNSAPISubmitTask)
+		return false;
+	boost::function<void()> *data = new boost::function<void()>(task);
+	if (!NSCAPI::api_ok(fNSAPISubmitTask(&run_task, data))) {
+		delete data;
+		return false;
+	}
+	return true;
+}
+
 bool nscapi::core_wrapper::json_to_protobuf(const std::string &request, std::string &response) const {
 	char *buffer = NULL;
 	unsigned int buffer_size = 0;
@@ -366,6 +402,8 @@ bool nscapi::core_wrapper::load_endpoints(nscapi::core_api::lpNSAPILoader f) {
 	fNSAPIMessage = (nscapi::core_api::lpNSAPIMessage)f("NSAPIMessage");
 	fNSAPISimpleMessage = (nscapi::core_api::lpNSAPISimpleMessage)f("NSAPISimpleMessage");
 	fNSAPIInject = (nscapi::core_api::lpNSAPIInject)f("NSAPIInject");
+	fNSAPIInjectMessage = (nscapi::core_api::lpNSAPIInjectMessage)f("NSAPIInjectMessage");
+	fNSAPIGetProtobufRuntime = (nscapi::core_api::lpNSAPIGetProtobufRuntime)f("NSAPIGetProtobufRuntime");
 	fNSAPIExecCommand = (nscapi::core_api::lpNSAPIExecCommand)f("NSAPIExecCommand");
 	fNSAPIDestroyBuffer = (nscapi::core_api::lpNSAPIDestroyBuffer)f("NSAPIDestroyBuffer");
 	fNSAPINotify = (nscapi::core_api::lpNSAPINotify)f("NSAPINotify");
@@ -383,6 +421,7 @@ bool nscapi::core_wrapper::load_endpoints(nscapi::core_api::lpNSAPILoader f) {
 
 	fNSCAPIEmitEvent = (nscapi::core_api::lpNSCAPIEmitEvent)f("NSCAPIEmitEvent");
 	fNSAPIStorageQuery = (nscapi::core_api::lpNSAPIStorageQuery)f("NSAPIStorageQuery");
+	fNSAPISubmitTask = (nscapi::core_api::lpNSAPISubmitTask)f("NSAPISubmitTask");
 
 	return true;
 }
\ No newline at end of file
@@ -25,6 +25,13 @@
 #include <string>
 #include <list>
 
+#include <boost/function.hpp>
+
+namespace Plugin {
+	class QueryRequestMessage;
+	class QueryResponseMessage;
+}
+
 namespace nscapi {
 	class core_wrapper_impl;
 	class NSCAPI_EXPORT core_wrapper {
@@ -35,6 +42,8 @@ namespace nscapi {
 		nscapi::core_api::lpNSAPIMessage fNSAPIMessage;
 		nscapi::core_api::lpNSAPISimpleMessage fNSAPISimpleMessage;
 		nscapi::core_api::lpNSAPIInject fNSAPIInject;
+		nscapi::core_api::lpNSAPIInjectMessage fNSAPIInjectMessage;
+		nscapi::core_api::lpNSAPIGetProtobufRuntime fNSAPIGetProtobufRuntime;
 		nscapi::core_api::lpNSAPIExecCommand fNSAPIExecCommand;
 		nscapi::core_api::lpNSAPIDestroyBuffer fNSAPIDestroyBuffer;
 		nscapi::core_api::lpNSAPINotify fNSAPINotify;
@@ -48,6 +57,7 @@ namespace nscapi {
 		nscapi::core_api::lpNSCAPIProtobuf2Json fNSCAPIProtobuf2Json;
 		nscapi::core_api::lpNSCAPIEmitEvent fNSCAPIEmitEvent;
 		nscapi::core_api::lpNSAPIStorageQuery fNSAPIStorageQuery;
+		nscapi::core_api::lpNSAPISubmitTask fNSAPISubmitTask;
 
 	public:
 
@@ -70,6 +80,11 @@ namespace nscapi {
 		void DestroyBuffer(char**buffer) const;
 		NSCAPI::nagiosReturn query(const char *request, const unsigned int request_len, char **response, unsigned int *response_len) const;
 		bool query(const std::string & request, std::string & result) const;
+		// Passes the messages as-is which is only valid when get_protobuf_runtime() matches our own (see core_helper::query).
+		bool query(const Plugin::QueryRequestMessage &request, Plugin::QueryResponseMessage &response) const;
+		nscapi::core_api::lpNSAPIGetProtobufRuntime get_protobuf_runtime() const {
+			return fNSAPIGetProtobufRuntime;
+		}
 
 		NSCAPI::nagiosReturn exec_command(const char* target, const char *request, const unsigned int request_len, char **response, unsigned int *response_len) const;
 		bool exec_command(const std::string target, std::string request, std::string & result) const;
@@ -92,6 +107,14 @@ namespace nscapi {
 		NSCAPI::errorReturn storage_query(const char *request, const unsigned int request_len, char **response, unsigned int *response_len) const;
 		bool storage_query(const std::string request, std::string &response) const;
 
+		// Runs a task on the core worker pool (returns false if the task was not accepted so the caller has to run it itself).
+		// A task submitted from a pool task is run by the same worker if possible so use this for continuations.
+		// Modules have to wait for their tasks to finish before they are unloaded.
+		bool submit_task(boost::function<void()> task) const;
+		bool can_submit_tasks() const {
+			return fNSAPISubmitTask != NULL;
+		}
+
 		bool load_endpoints(nscapi::core_api::lpNSAPILoader f);
 		void set_alias(const std::string default_alias, const std::string alias);
 	};
@@ -35,6 +35,11 @@
 
 #include <utf8.hpp>
 
+namespace Plugin {
+	class QueryRequestMessage;
+	class QueryResponseMessage;
+}
+
 namespace nscapi {
 
 	struct module_version {
@@ -211,6 +216,21 @@ namespace nscapi {
 			} 
 			return NSCAPI::cmd_return_codes::returnIgnored; 
 		} 
+		NSCAPI::nagiosReturn NSHandleCommandMessage(const Plugin::QueryRequestMessage &request, Plugin::QueryResponseMessage &reply) {
+			try {
+				NSCAPI::nagiosReturn retCode = instance->handleCommand(request, reply);
+				if (!nscapi::plugin_helper::isMyNagiosReturn(retCode)) {
+					NSC_LOG_ERROR("A module returned an invalid return code");
+				}
+				return retCode;
+			} catch (const std::exception &e) {
+				NSC_LOG_ERROR_EXR("NSHandleCommandMessage", e);
+				return NSCAPI::cmd_return_codes::hasFailed;
+			} catch (...) {
+				NSC_LOG_ERROR_EX("NSHandleCommandMessage");
+				return NSCAPI::cmd_return_codes::hasFailed;
+			}
+		}
 		NSCAPI::boolReturn NSHasCommandHandler() { 
 			try { 
 				if (instance->hasCommandHandler())
@@ -37,3 +37,25 @@
 #else
 #include <protobuf/plugin.pb.h>
 #endif
+
+#include <google/protobuf/descriptor.h>
+
+namespace nscapi {
+	namespace protobuf {
+		// Identifies the protobuf runtime (generated messages and libprotobuf) of the calling binary.
+		// Message objects may only be shared between binaries reporting the same runtime.
+		inline void get_runtime(const void **messages, const void **library) {
+			*messages = &Plugin::QueryRequestMessage::default_instance();
+			*library = google::protobuf::DescriptorPool::generated_pool();
+		}
+		template<class T>
+		inline bool is_same_runtime(T fun) {
+			if (fun == NULL)
+				return false;
+			const void *messages = NULL, *library = NULL, *other_messages = NULL, *other_library = NULL;
+			get_runtime(&messages, &library);
+			fun(&other_messages, &other_library);
+			return messages == other_messages && library == other_library;
+		}
+	}
+}
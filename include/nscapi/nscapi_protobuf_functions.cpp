@@ -316,14 +316,16 @@ namespace nscapi {
 		int functions::parse_simple_query_response(const std::string &response, std::string &msg, std::string &perf, std::size_t max_length) {
 			Plugin::QueryResponseMessage message;
 			message.ParseFromString(response);
-
+			return parse_simple_query_response(message, msg, perf, max_length);
+		}
+		int functions::parse_simple_query_response(const Plugin::QueryResponseMessage &message, std::string &msg, std::string &perf, std::size_t max_length) {
 			if (message.payload_size() == 0 || message.payload(0).lines_size() == 0) {
 				return NSCAPI::query_return_codes::returnUNKNOWN;
 			} else if (message.payload_size() > 1 && message.payload(0).lines_size() > 1) {
 				THROW_INVALID_SIZE(message.payload_size());
 			}
 
-			Plugin::QueryResponseMessage::Response payload = message.payload().Get(0);
+			const Plugin::QueryResponseMessage::Response &payload = message.payload(0);
 			BOOST_FOREACH(const Plugin::QueryResponseMessage::Response::Line &l, payload.lines()) {
 				msg += l.message();
 				std::string tmpPerf = build_performance_data(l, max_length);
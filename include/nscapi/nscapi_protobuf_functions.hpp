@@ -133,6 +133,7 @@ namespace nscapi {
 			NSCAPI_EXPORT void append_simple_exec_request_payload(Plugin::ExecuteRequestMessage_Request *payload, std::string command, std::vector<std::string> arguments);
 			NSCAPI_EXPORT void parse_simple_query_request(std::list<std::string> &args, const std::string &request);
 			NSCAPI_EXPORT int parse_simple_query_response(const std::string &response, std::string &msg, std::string &perf, std::size_t max_length);
+			NSCAPI_EXPORT int parse_simple_query_response(const Plugin::QueryResponseMessage &message, std::string &msg, std::string &perf, std::size_t max_length);
 			NSCAPI_EXPORT void create_simple_exec_request(const std::string &module, const std::string &command, const std::list<std::string> & args, std::string &request);
 			NSCAPI_EXPORT void create_simple_exec_request(const std::string &module, const std::string &command, const std::vector<std::string> & args, std::string &request);
 			NSCAPI_EXPORT int parse_simple_exec_response(const std::string &response, std::list<std::string> &result);
@@ -48,6 +48,7 @@ namespace nsclient {
 			bool is_no_std_err() const {
 				return no_std_err_;
 			}
+			virtual void flush() {}
 			virtual bool shutdown() {
 				is_running_ = false;
 				return true;
@@ -21,6 +21,8 @@
 
 #include <nsclient/logger/logger.hpp>
 
+#include <nscapi/nscapi_protobuf.hpp>
+
 #include <boost/shared_ptr.hpp>
 
 #include <string>
@@ -34,8 +36,12 @@ namespace nsclient {
 			log_driver_interface() {}
 			virtual ~log_driver_interface() {}
 			virtual void do_log(const std::string data) = 0;
+			// Logs a single entry without creating a serialized message.
+			virtual void do_log(const ::Plugin::LogEntry::Entry::Level level, const std::string &sender, const char* file, const int line, const std::string &message) = 0;
 			virtual void synch_configure() = 0;
 			virtual void asynch_configure() = 0;
+			// Writes out any messages the driver is holding on to.
+			virtual void flush() = 0;
 
 			virtual void set_config(const std::string &key) = 0;
 			virtual void set_config(const boost::shared_ptr<log_driver_interface> other) = 0;
@@ -28,7 +28,7 @@ void nsclient::logging::log_message_factory::log_fatal(std::string message) {
 	std::cout << message << "\n";
 }
 
-std::string create_message(const std::string &module, ::Plugin::LogEntry::Entry::Level level, const char* file, const int line, const std::string &logMessage) {
+std::string nsclient::logging::log_message_factory::create_message(const ::Plugin::LogEntry::Entry::Level level, const std::string &module, const char* file, const int line, const std::string &logMessage) {
 	std::string str;
 	try {
 		::Plugin::LogEntry message;
@@ -47,20 +47,20 @@ std::string create_message(const std::string &module, ::Plugin::LogEntry::Entry:
 	return str;
 }
 std::string nsclient::logging::log_message_factory::create_critical(const std::string &module, const char* file, const int line, const std::string &message) {
-	return create_message(module, ::Plugin::LogEntry_Entry_Level_LOG_CRITICAL, file, line, message);
+	return create_message(::Plugin::LogEntry_Entry_Level_LOG_CRITICAL, module, file, line, message);
 }
 std::string nsclient::logging::log_message_factory::create_error(const std::string &module, const char* file, const int line, const std::string &message) {
-	return create_message(module, ::Plugin::LogEntry_Entry_Level_LOG_ERROR, file, line, message);
+	return create_message(::Plugin::LogEntry_Entry_Level_LOG_ERROR, module, file, line, message);
 }
 std::string nsclient::logging::log_message_factory::create_warning(const std::string &module, const char* file, const int line, const std::string &message) {
-	return create_message(module, ::Plugin::LogEntry_Entry_Level_LOG_WARNING, file, line, message);
+	return create_message(::Plugin::LogEntry_Entry_Level_LOG_WARNING, module, file, line, message);
 }
 std::string nsclient::logging::log_message_factory::create_info(const std::string &module, const char* file, const int line, const std::string &message) {
-	return create_message(module, ::Plugin::LogEntry_Entry_Level_LOG_INFO, file, line, message);
+	return create_message(::Plugin::LogEntry_Entry_Level_LOG_INFO, module, file, line, message);
 }
 std::string nsclient::logging::log_message_factory::create_debug(const std::string &module, const char* file, const int line, const std::string &message) {
-	return create_message(module, ::Plugin::LogEntry_Entry_Level_LOG_DEBUG, file, line, message);
+	return create_message(::Plugin::LogEntry_Entry_Level_LOG_DEBUG, module, file, line, message);
 }
 std::string nsclient::logging::log_message_factory::create_trace(const std::string &module, const char* file, const int line, const std::string &message) {
-	return create_message(module, ::Plugin::LogEntry_Entry_Level_LOG_TRACE, file, line, message);
+	return create_message(::Plugin::LogEntry_Entry_Level_LOG_TRACE, module, file, line, message);
 }
@@ -19,6 +19,8 @@
 
 #pragma once
 
+#include <nscapi/nscapi_protobuf.hpp>
+
 #include <string>
 
 namespace nsclient {
@@ -27,7 +29,8 @@ namespace nsclient {
 		struct log_message_factory {
 
 			static void log_fatal(std::string message);
-			
+
+			static std::string create_message(const ::Plugin::LogEntry::Entry::Level level, const std::string &module, const char* file, const int line, const std::string &message);
 			static std::string create_critical(const std::string &module, const char* file, const int line, const std::string &message);
 			static std::string create_error(const std::string &module, const char* file, const int line, const std::string &message);
 			static std::string create_warning(const std::string &module, const char* file, const int line, const std::string &message);
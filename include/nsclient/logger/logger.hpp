@@ -19,8 +19,11 @@
 
 #pragma once
 
+#include <NSCAPI.h>
+
 #include <boost/shared_ptr.hpp>
 
+#include <set>
 #include <string>
 
 #define LOG_CRITICAL_CORE(msg) { get_logger()->critical("core", __FILE__, __LINE__, msg);}
@@ -38,11 +41,31 @@
 
 namespace nsclient {
 	namespace logging {
+		// The entries a subscriber wants: the level and everything more severe from the given senders (or all senders if none are given).
+		struct log_filter {
+			NSCAPI::log_level::level level;
+			std::set<std::string> modules;
+
+			log_filter() : level(NSCAPI::log_level::trace) {}
+			bool matches(const NSCAPI::log_level::level entry_level, const std::string &sender) const {
+				return entry_level <= level && (modules.empty() || modules.find(sender) != modules.end());
+			}
+		};
+
 		struct logging_subscriber {
 			virtual void on_log_message(std::string &payload) = 0;
+			// Read once when subscribing.
+			virtual log_filter get_log_filter() { return log_filter(); }
 		};
 		typedef boost::shared_ptr<logging_subscriber> logging_subscriber_instance;
 
+		// Passes entries from the log thread on to the subscribers.
+		struct log_dispatcher {
+			virtual void on_log_entry(const NSCAPI::log_level::level level, const std::string &sender, const std::string &file, const int line, const std::string &message) = 0;
+			// Called when there are no more entries for now so batched entries are delivered.
+			virtual void deliver_log_entries() = 0;
+		};
+
 		struct log_interface {
 			virtual void trace(const std::string &module, const char* file, const int line, const std::string &message) = 0;
 			virtual void debug(const std::string &module, const char* file, const int line, const std::string &message) = 0;
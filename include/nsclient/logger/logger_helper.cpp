@@ -72,9 +72,42 @@ std::string nsclient::logging::logger_helper::render_log_level_long(::Plugin::Lo
 	}
 }
 
+void render_console_entry(std::stringstream &ss, const bool oneline, const ::Plugin::LogEntry::Entry::Level level, const std::string &sender, const char* file, const int line, const std::string &message) {
+	if (oneline) {
+		std::string tmp = message;
+		str::utils::replace(tmp, "\n", "\n    -    ");
+		ss << file
+			<< "("
+			<< line
+			<< "): "
+			<< nsclient::logging::logger_helper::render_log_level_long(level)
+			<< ": "
+			<< tmp
+			<< "\n";
+	} else {
+		ss << str::format::lpad(nsclient::logging::logger_helper::render_log_level_short(level), 1)
+			<< " " << str::format::rpad(sender, 10)
+			<< " " + message
+			<< "\n";
+		if (level == ::Plugin::LogEntry_Entry_Level_LOG_ERROR) {
+			ss << "                    "
+				<< file
+				<< ":"
+				<< line << "\n";
+		}
+	}
+}
+
+std::pair<bool, std::string> render_console_result(const std::stringstream &ss) {
+#ifdef WIN32
+	return std::make_pair(false, utf8::to_encoding(ss.str(), ""));
+#else
+	return std::make_pair(false, ss.str());
+#endif
+}
+
 std::pair<bool, std::string> nsclient::logging::logger_helper::render_console_message(const bool oneline, const std::string &data) {
 	std::stringstream ss;
-	bool is_error = false;
 	try {
 		Plugin::LogEntry message;
 		if (!message.ParseFromString(data)) {
@@ -84,37 +117,11 @@ std::pair<bool, std::string> nsclient::logging::logger_helper::render_console_me
 
 		for (int i = 0; i < message.entry_size(); i++) {
 			const ::Plugin::LogEntry::Entry &msg = message.entry(i);
-			std::string tmp = msg.message();
-			str::utils::replace(tmp, "\n", "\n    -    ");
-			if (oneline) {
-				ss << msg.file()
-					<< "("
-					<< msg.line()
-					<< "): "
-					<< render_log_level_long(msg.level())
-					<< ": "
-					<< tmp
-					<< "\n";
-			} else {
-				if (i > 0)
-					ss << " -- ";
-				ss << str::format::lpad(render_log_level_short(msg.level()), 1)
-					<< " " << str::format::rpad(msg.sender(), 10)
-					<< " " + msg.message()
-					<< "\n";
-				if (msg.level() == ::Plugin::LogEntry_Entry_Level_LOG_ERROR) {
-					ss << "                    "
-						<< msg.file()
-						<< ":"
-						<< msg.line() << "\n";
-				}
-			}
+			if (i > 0 && !oneline)
+				ss << " -- ";
+			render_console_entry(ss, oneline, msg.level(), msg.sender(), msg.file().c_str(), msg.line(), msg.message());
 		}
-#ifdef WIN32
-		return std::make_pair(is_error, utf8::to_encoding(ss.str(), ""));
-#else
-		return std::make_pair(is_error, ss.str());
-#endif
+		return render_console_result(ss);
 	} catch (std::exception &e) {
 		log_fatal("Failed to parse data from: " + str::format::strip_ctrl_chars(data) + ": " + e.what());
 	} catch (...) {
@@ -123,6 +130,12 @@ std::pair<bool, std::string> nsclient::logging::logger_helper::render_console_me
 	return std::make_pair(true, "ERROR");
 }
 
+std::pair<bool, std::string> nsclient::logging::logger_helper::render_console_message(const bool oneline, const ::Plugin::LogEntry::Entry::Level level, const std::string &sender, const char* file, const int line, const std::string &message) {
+	std::stringstream ss;
+	render_console_entry(ss, oneline, level, sender, file, line, message);
+	return render_console_result(ss);
+}
+
 std::string nsclient::logging::logger_helper::get_formated_date(std::string format) {
 	std::stringstream ss;
 	boost::posix_time::time_facet *facet = new boost::posix_time::time_facet(format.c_str());
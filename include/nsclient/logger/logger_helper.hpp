@@ -30,6 +30,7 @@ namespace nsclient {
 			static std::string get_formated_date(std::string format);
 			static void log_fatal(std::string message);
 			static std::pair<bool, std::string> render_console_message(const bool oneline, const std::string &data);
+			static std::pair<bool, std::string> render_console_message(const bool oneline, const ::Plugin::LogEntry::Entry::Level level, const std::string &sender, const char* file, const int line, const std::string &message);
  			static std::string render_log_level_short(::Plugin::LogEntry::Entry::Level l);
  			static std::string render_log_level_long(::Plugin::LogEntry::Entry::Level l);
 		};
@@ -19,10 +19,13 @@
 
 #pragma once
 
+#include <cctype>
+
 #include <boost/shared_ptr.hpp>
 #include <boost/function.hpp>
 #include <boost/foreach.hpp>
 #include <boost/unordered_set.hpp>
+#include <boost/optional.hpp>
 
 #include <parsers/expression/expression.hpp>
 #include <parsers/perfconfig/perfconfig.hpp>
@@ -112,6 +115,26 @@ namespace modern_filter {
 		}
 	};
 
+	// Renders a syntax for the current object the first time (if ever) it is needed.
+	template<class Tfactory>
+	struct lazy_text_renderer {
+		const filter_text_renderer<Tfactory> &renderer;
+		boost::shared_ptr<Tfactory> context;
+		boost::optional<std::string> value;
+		const std::string empty;
+
+		lazy_text_renderer(const filter_text_renderer<Tfactory> &renderer, boost::shared_ptr<Tfactory> context) : renderer(renderer), context(context) {}
+
+		const std::string& render() {
+			if (!value)
+				value = renderer.render(context);
+			return *value;
+		}
+		const std::string& render_if(bool needed) {
+			return needed ? render() : empty;
+		}
+	};
+
 	template<class Tfactory>
 	struct filter_hash_renderer {
 		struct my_entry {
@@ -245,6 +268,17 @@ namespace modern_filter {
 		}
 	};
 
+	template<class Tobject, class Tfactory>
+	struct batch_object_binder : public parsers::where::batch_binder {
+		const std::vector<boost::shared_ptr<Tobject> > &records;
+		boost::shared_ptr<Tfactory> context;
+
+		batch_object_binder(const std::vector<boost::shared_ptr<Tobject> > &records, boost::shared_ptr<Tfactory> context) : records(records), context(context) {}
+		void bind(std::size_t row) {
+			context->set_object(records[row]);
+		}
+	};
+
 	class error_handler_impl : public parsers::where::error_handler_interface {
 		std::string error;
 		bool debug_;
@@ -487,74 +521,171 @@ namespace modern_filter {
 		}
 		match_result match(object_type record) {
 			context->set_object(record);
-			bool matched_filter = false;
-			bool matched_bound = false;
 			// done should be set if we want to bail out after the first hit!
 			// I.e. mode==first (mode==all)
 			summary.count();
-			if (!engine_filter || engine_filter->match(context, true)) {
-				matched_filter = true;
-				if (fetch_hash_) {
-					records_.push_back(renderer_hash.render(context));
+			if (!engine_filter || engine_filter->match(context, true))
+				return process_match();
+			if (should_log_debug())
+				log_debug("Filter did not match: " + renderer_detail.render(context));
+			return match_result(false, false);
+		}
+
+		// Matches a batch of records: the filter is evaluated for all records at once and only the records passing it are
+		// rendered and checked against the crit/warn/ok expressions (in order).
+		// Since all records are counted before filtering a filter referencing the summary sees the count for the entire batch.
+		match_result match_batch(const std::vector<object_type> &records) {
+			match_result ret;
+			if (records.empty())
+				return ret;
+			parsers::where::batch_rows matched;
+			for (std::size_t i = 0; i < records.size(); ++i)
+				summary.count();
+			if (engine_filter) {
+				parsers::where::batch_rows rows(records.size());
+				for (std::size_t i = 0; i < records.size(); ++i)
+					rows[i] = i;
+				batch_object_binder<Tobject, Tfactory> binder(records, context);
+				engine_filter->match_batch(context, binder, rows, matched, true);
+			}
+			std::size_t next = 0;
+			for (std::size_t i = 0; i < records.size(); ++i) {
+				context->set_object(records[i]);
+				if (!engine_filter || (next < matched.size() && matched[next] == i)) {
+					next++;
+					ret.append(process_match());
+				} else if (should_log_debug()) {
+					log_debug("Filter did not match: " + renderer_detail.render(context));
 				}
-				std::string current = renderer_detail.render(context);
-				std::string perf_alias = renderer_perf.render(context);
-				bool second_unique_match = false;
-				if (has_unique_index) {
-					std::string tmp = renderer_unqiue.render(context);
-					second_unique_match = unique_index.find(tmp) != unique_index.end();
-					if (!second_unique_match)
-						unique_index.emplace(tmp);
+			}
+			return ret;
+		}
+
+		// Evaluates only the filter expression for a batch of records appending the rows which passed it to matched.
+		// Used by workers selecting records which are then evaluated in order on the filter owning the summary (see replay_batch).
+		void filter_batch(const std::vector<object_type> &records, parsers::where::batch_rows &matched) {
+			parsers::where::batch_rows rows(records.size());
+			for (std::size_t i = 0; i < records.size(); ++i)
+				rows[i] = i;
+			if (!engine_filter) {
+				matched.insert(matched.end(), rows.begin(), rows.end());
+				return;
+			}
+			batch_object_binder<Tobject, Tfactory> binder(records, context);
+			engine_filter->match_batch(context, binder, rows, matched, true);
+		}
+
+		// Counts a batch of count records and processes the ones which passed filter_batch (in order).
+		// Gives the same result as match_batch as long as the filter expression does not depend on the summary.
+		match_result replay_batch(std::size_t count, const std::vector<object_type> &matched) {
+			match_result ret;
+			for (std::size_t i = 0; i < count; ++i)
+				summary.count();
+			BOOST_FOREACH(const object_type &record, matched) {
+				context->set_object(record);
+				ret.append(process_match());
+			}
+			return ret;
+		}
+
+		// Copies the filter expression to another (empty) filter to be used with filter_batch.
+		// The copy gets its own engine and context since neither is thread safe.
+		bool copy_filter(modern_filters &other) const {
+			if (!engine_filter)
+				return true;
+			std::vector<std::string> filter;
+			BOOST_FOREACH(const parsers::where::engine_filter &f, engine_filter->filters_)
+				filter.push_back(f.filter_string);
+			other.engine_filter.reset(new parsers::where::engine(filter, other.get_error_handler(error_handler_ && error_handler_->is_debug())));
+			return other.engine_filter->validate(other.context);
+		}
+
+		// True if any of the filter expressions refer to one of the summary variables (count, total, ...).
+		// Names inside strings are counted as well which only means some filters are treated as using the summary when they do not.
+		bool filter_uses_summary() {
+			if (!engine_filter)
+				return false;
+			BOOST_FOREACH(const parsers::where::engine_filter &f, engine_filter->filters_) {
+				const std::string &str = f.filter_string;
+				for (std::string::size_type pos = 0; pos < str.size();) {
+					if (!std::isalpha(static_cast<unsigned char>(str[pos])) && str[pos] != '_') {
+						pos++;
+						continue;
+					}
+					std::string::size_type end = pos;
+					while (end < str.size() && (std::isalnum(static_cast<unsigned char>(str[end])) || str[end] == '_'))
+						end++;
+					if (summary.has_variable(str.substr(pos, end - pos)))
+						return true;
+					pos = end;
 				}
+			}
+			return false;
+		}
+
+		// The current object has passed the filter.
+		match_result process_match() {
+			bool matched_bound = false;
+			if (fetch_hash_) {
+				records_.push_back(renderer_hash.render(context));
+			}
+			lazy_text_renderer<Tfactory> current(renderer_detail, context);
+			bool second_unique_match = false;
+			if (has_unique_index) {
+				std::string tmp = renderer_unqiue.render(context);
+				second_unique_match = unique_index.find(tmp) != unique_index.end();
+				if (!second_unique_match)
+					unique_index.emplace(tmp);
+			}
 
+			if (!leaf_performance_data.empty()) {
+				std::string perf_alias = renderer_perf.render(context);
 				BOOST_FOREACH(const typename leaf_performance_entry_type::value_type &entry, leaf_performance_data) {
 					parsers::where::perf_list_type perf = entry.second.current_value->get_performance_data(context, perf_alias, entry.second.warn_value, entry.second.crit_value, entry.second.minimum_value, entry.second.maximum_value);
 					if (perf.size() > 0)
 						performance_instance_data.insert(performance_instance_data.end(), perf.begin(), perf.end());
 				}
+			}
+			if (second_unique_match)
+				summary.matched_unique();
+			else
+				summary.matched(current.render_if(summary.needs_match_line()));
+			if (engine_crit && engine_crit->match(context, true)) {
+				if (should_log_debug()) log_debug("Crit match: " + current.render());
 				if (second_unique_match)
-					summary.matched_unique();
+					summary.matched_crit_unique();
 				else
-					summary.matched(current);
-				if (engine_crit && engine_crit->match(context, true)) {
-					if (should_log_debug()) log_debug("Crit match: " + current);
-					if (second_unique_match)
-						summary.matched_crit_unique();
-					else
-						summary.matched_crit(current);
-					nscapi::plugin_helper::escalteReturnCodeToCRIT(summary.returnCode);
-					matched_bound = true;
-				} else if (engine_warn && engine_warn->match(context, true)) {
-					if (should_log_debug()) log_debug("Warn match: " + current);
-					if (second_unique_match)
-						summary.matched_warn_unique();
-					else
-						summary.matched_warn(current);
-					nscapi::plugin_helper::escalteReturnCodeToWARN(summary.returnCode);
-					matched_bound = true;
-				} else if (engine_ok && engine_ok->match(context, true)) {
-					if (should_log_debug()) log_debug("Ok match: " + current);
-					// TODO: Unsure of this, should this not re-set matched?
-					// What is matched for?
-					if (second_unique_match)
-						summary.matched_ok_unique();
-					else
-						summary.matched_ok(current);
-					matched_bound = true;
-				} else {
-					if (should_log_debug()) log_debug("Crit/warn/ok did not match: " + current);
-					if (second_unique_match)
-						summary.matched_ok_unique();
-					else
-						summary.matched_ok(current);
-				}
-				if (matched_bound) {
-					has_matched = true;
-				}
-			} else if (should_log_debug()) {
-				log_debug("Filter did not match: " + renderer_detail.render(context));
+					summary.matched_crit(current.render_if(summary.needs_crit_line()));
+				nscapi::plugin_helper::escalteReturnCodeToCRIT(summary.returnCode);
+				matched_bound = true;
+			} else if (engine_warn && engine_warn->match(context, true)) {
+				if (should_log_debug()) log_debug("Warn match: " + current.render());
+				if (second_unique_match)
+					summary.matched_warn_unique();
+				else
+					summary.matched_warn(current.render_if(summary.needs_warn_line()));
+				nscapi::plugin_helper::escalteReturnCodeToWARN(summary.returnCode);
+				matched_bound = true;
+			} else if (engine_ok && engine_ok->match(context, true)) {
+				if (should_log_debug()) log_debug("Ok match: " + current.render());
+				// TODO: Unsure of this, should this not re-set matched?
+				// What is matched for?
+				if (second_unique_match)
+					summary.matched_ok_unique();
+				else
+					summary.matched_ok(current.render_if(summary.needs_ok_line()));
+				matched_bound = true;
+			} else {
+				if (should_log_debug()) log_debug("Crit/warn/ok did not match: " + current.render());
+				if (second_unique_match)
+					summary.matched_ok_unique();
+				else
+					summary.matched_ok(current.render_if(summary.needs_ok_line()));
+			}
+			if (matched_bound) {
+				has_matched = true;
 			}
-			return match_result(matched_filter, matched_bound);
+			return match_result(true, matched_bound);
 		}
 
 		bool match_post() {
@@ -589,6 +720,12 @@ namespace modern_filter {
 
 		void end_match() {
 			context->remove_object();
+			if (should_log_debug()) {
+				if (engine_filter && engine_filter->has_regex_statistics()) log_debug("Filter " + engine_filter->get_regex_statistics());
+				if (engine_warn && engine_warn->has_regex_statistics()) log_debug("Warning " + engine_warn->get_regex_statistics());
+				if (engine_crit && engine_crit->has_regex_statistics()) log_debug("Critical " + engine_crit->get_regex_statistics());
+				if (engine_ok && engine_ok->has_regex_statistics()) log_debug("Ok " + engine_ok->get_regex_statistics());
+			}
 			BOOST_FOREACH(const typename leaf_performance_entry_type::value_type &entry, leaf_performance_data) {
 				parsers::where::perf_list_type perf = entry.second.current_value->get_performance_data(context, "TODO", entry.second.warn_value, entry.second.crit_value, entry.second.minimum_value, entry.second.maximum_value);
 				if (perf.size() > 0)
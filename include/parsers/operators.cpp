@@ -28,6 +28,7 @@
 #include <parsers/operators.hpp>
 #include <parsers/helpers.hpp>
 #include <parsers/where/helpers.hpp>
+#include <parsers/where/regex_cache.hpp>
 
 namespace parsers {
 	namespace where {
@@ -92,9 +93,9 @@ namespace parsers {
 					return do_eval_string(type, errors, lhs, rhs);
 				};
 
-				virtual value_container do_eval_float(value_type type, evaluation_context errors, const value_container left, const value_container right) const = 0;
-				virtual value_container do_eval_int(value_type type, evaluation_context errors, const value_container left, const value_container right) const = 0;
-				virtual value_container do_eval_string(value_type type, evaluation_context errors, const value_container left, const value_container right) const = 0;
+				virtual value_container do_eval_float(value_type type, evaluation_context errors, const value_container &left, const value_container &right) const = 0;
+				virtual value_container do_eval_int(value_type type, evaluation_context errors, const value_container &left, const value_container &right) const = 0;
+				virtual value_container do_eval_string(value_type type, evaluation_context errors, const value_container &left, const value_container &right) const = 0;
 			};
 
 			struct eval_helper {
@@ -146,71 +147,71 @@ namespace parsers {
 			};
 
 			struct operator_eq : public even_simpler_bool_binary_operator_impl {
-				value_container do_eval_int(value_type, evaluation_context errors, const value_container lhs, const value_container rhs) const {
+				value_container do_eval_int(value_type, evaluation_context errors, const value_container &lhs, const value_container &rhs) const {
 					return value_container::create_int(lhs.get_int() == rhs.get_int(), lhs.is_unsure | rhs.is_unsure);
 				}
-				value_container do_eval_float(value_type, evaluation_context errors, const value_container lhs, const value_container rhs) const {
+				value_container do_eval_float(value_type, evaluation_context errors, const value_container &lhs, const value_container &rhs) const {
 					return value_container::create_int(lhs.get_float() == rhs.get_float(), lhs.is_unsure | rhs.is_unsure);
 				}
-				value_container do_eval_string(value_type, evaluation_context errors, const value_container lhs, const value_container rhs) const {
-					return value_container::create_int(lhs.get_string() == rhs.get_string(), lhs.is_unsure | rhs.is_unsure);
+				value_container do_eval_string(value_type, evaluation_context errors, const value_container &lhs, const value_container &rhs) const {
+					return value_container::create_int(lhs.get_string_ref() == rhs.get_string_ref(), lhs.is_unsure | rhs.is_unsure);
 				};
 			};
 			struct operator_ne : public even_simpler_bool_binary_operator_impl {
-				value_container do_eval_int(value_type, evaluation_context errors, const value_container lhs, const value_container rhs) const {
+				value_container do_eval_int(value_type, evaluation_context errors, const value_container &lhs, const value_container &rhs) const {
 					return value_container::create_int(lhs.get_int() != rhs.get_int(), lhs.is_unsure | rhs.is_unsure);
 				}
-				value_container do_eval_float(value_type, evaluation_context errors, const value_container lhs, const value_container rhs) const {
+				value_container do_eval_float(value_type, evaluation_context errors, const value_container &lhs, const value_container &rhs) const {
 					return value_container::create_int(lhs.get_float() != rhs.get_float(), lhs.is_unsure | rhs.is_unsure);
 				}
-				value_container do_eval_string(value_type, evaluation_context errors, const value_container lhs, const value_container rhs) const {
-					return value_container::create_int(lhs.get_string() != rhs.get_string(), lhs.is_unsure | rhs.is_unsure);
+				value_container do_eval_string(value_type, evaluation_context errors, const value_container &lhs, const value_container &rhs) const {
+					return value_container::create_int(lhs.get_string_ref() != rhs.get_string_ref(), lhs.is_unsure | rhs.is_unsure);
 				};
 			};
 			struct operator_gt : public even_simpler_bool_binary_operator_impl {
-				value_container do_eval_int(value_type, evaluation_context errors, const value_container lhs, const value_container rhs) const {
+				value_container do_eval_int(value_type, evaluation_context errors, const value_container &lhs, const value_container &rhs) const {
 					return value_container::create_int(lhs.get_int() > rhs.get_int(), lhs.is_unsure | rhs.is_unsure);
 				}
-				value_container do_eval_float(value_type, evaluation_context errors, const value_container lhs, const value_container rhs) const {
+				value_container do_eval_float(value_type, evaluation_context errors, const value_container &lhs, const value_container &rhs) const {
 					return value_container::create_int(lhs.get_float() > rhs.get_float(), lhs.is_unsure | rhs.is_unsure);
 				}
-				value_container do_eval_string(value_type, evaluation_context errors, const value_container lhs, const value_container rhs) const {
-					return value_container::create_int(lhs.get_string() > rhs.get_string(), lhs.is_unsure | rhs.is_unsure);
+				value_container do_eval_string(value_type, evaluation_context errors, const value_container &lhs, const value_container &rhs) const {
+					return value_container::create_int(lhs.get_string_ref() > rhs.get_string_ref(), lhs.is_unsure | rhs.is_unsure);
 				};
 			};
 			struct operator_lt : public even_simpler_bool_binary_operator_impl {
-				value_container do_eval_int(value_type, evaluation_context errors, const value_container lhs, const value_container rhs) const {
+				value_container do_eval_int(value_type, evaluation_context errors, const value_container &lhs, const value_container &rhs) const {
 					return value_container::create_int(lhs.get_int() < rhs.get_int(), lhs.is_unsure | rhs.is_unsure);
 				}
-				value_container do_eval_float(value_type, evaluation_context errors, const value_container lhs, const value_container rhs) const {
+				value_container do_eval_float(value_type, evaluation_context errors, const value_container &lhs, const value_container &rhs) const {
 					if (lhs.get_float() < rhs.get_float())
 						return value_container::create_int(true, lhs.is_unsure | rhs.is_unsure);
 					return value_container::create_int(false, rhs.is_unsure);
 				}
-				value_container do_eval_string(value_type, evaluation_context errors, const value_container lhs, const value_container rhs) const {
-					return value_container::create_int(lhs.get_string() < rhs.get_string(), lhs.is_unsure | rhs.is_unsure);
+				value_container do_eval_string(value_type, evaluation_context errors, const value_container &lhs, const value_container &rhs) const {
+					return value_container::create_int(lhs.get_string_ref() < rhs.get_string_ref(), lhs.is_unsure | rhs.is_unsure);
 				};
 			};
 			struct operator_le : public even_simpler_bool_binary_operator_impl {
-				value_container do_eval_int(value_type, evaluation_context errors, const value_container lhs, const value_container rhs) const {
+				value_container do_eval_int(value_type, evaluation_context errors, const value_container &lhs, const value_container &rhs) const {
 					return value_container::create_int(lhs.get_int() <= rhs.get_int(), lhs.is_unsure | rhs.is_unsure);
 				}
-				value_container do_eval_float(value_type, evaluation_context errors, const value_container lhs, const value_container rhs) const {
+				value_container do_eval_float(value_type, evaluation_context errors, const value_container &lhs, const value_container &rhs) const {
 					return value_container::create_int(lhs.get_float() <= rhs.get_float(), lhs.is_unsure | rhs.is_unsure);
 				}
-				value_container do_eval_string(value_type, evaluation_context errors, const value_container lhs, const value_container rhs) const {
-					return value_container::create_int(lhs.get_string() <= rhs.get_string(), lhs.is_unsure | rhs.is_unsure);
+				value_container do_eval_string(value_type, evaluation_context errors, const value_container &lhs, const value_container &rhs) const {
+					return value_container::create_int(lhs.get_string_ref() <= rhs.get_string_ref(), lhs.is_unsure | rhs.is_unsure);
 				};
 			};
 			struct operator_ge : public even_simpler_bool_binary_operator_impl {
-				value_container do_eval_int(value_type, evaluation_context errors, const value_container lhs, const value_container rhs) const {
+				value_container do_eval_int(value_type, evaluation_context errors, const value_container &lhs, const value_container &rhs) const {
 					return value_container::create_int(lhs.get_int() >= rhs.get_int(), lhs.is_unsure | rhs.is_unsure);
 				}
-				value_container do_eval_float(value_type, evaluation_context errors, const value_container lhs, const value_container rhs) const {
+				value_container do_eval_float(value_type, evaluation_context errors, const value_container &lhs, const value_container &rhs) const {
 					return value_container::create_int(lhs.get_float() >= rhs.get_float(), lhs.is_unsure | rhs.is_unsure);
 				}
-				value_container do_eval_string(value_type, evaluation_context errors, const value_container lhs, const value_container rhs) const {
-					return value_container::create_int(lhs.get_string() >= rhs.get_string(), lhs.is_unsure | rhs.is_unsure);
+				value_container do_eval_string(value_type, evaluation_context errors, const value_container &lhs, const value_container &rhs) const {
+					return value_container::create_int(lhs.get_string_ref() >= rhs.get_string_ref(), lhs.is_unsure | rhs.is_unsure);
 				};
 			};
 
@@ -253,8 +254,8 @@ namespace parsers {
 						errors->error("invalid type");
 						return value_container::create_nil();
 					}
-					std::string s1 = boost::algorithm::to_lower_copy(lhs.get_string());
-					std::string s2 = boost::algorithm::to_lower_copy(rhs.get_string());
+					std::string s1 = boost::algorithm::to_lower_copy(lhs.get_string_ref());
+					std::string s2 = boost::algorithm::to_lower_copy(rhs.get_string_ref());
 					if (s1.size() == 0 && s2.size() == 0)
 						return value_container::create_int(1, lhs.is_unsure || rhs.is_unsure);
 					if (s1.size() == 0 || s2.size() == 0)
@@ -264,7 +265,12 @@ namespace parsers {
 					return value_container::create_int(s2.find(s1) != std::string::npos, lhs.is_unsure || rhs.is_unsure);
 				}
 			};
-			struct operator_regexp : public simple_bool_binary_operator_impl {
+			// Operators are bound once per node so patterns are kept in a small LRU for the life time of the expression.
+			struct regexp_operator_impl : public simple_bool_binary_operator_impl {
+				bool negate;
+				mutable regex_cache cache;
+				regexp_operator_impl(bool negate) : negate(negate), cache(8) {}
+
 				value_container eval_int(value_type type, evaluation_context errors, const node_type left, const node_type right) const {
 					errors->error("Like not supported on numbers...");
 					return value_container::create_nil();
@@ -280,11 +286,12 @@ namespace parsers {
 						errors->error("invalid type");
 						return value_container::create_nil();
 					}
-					std::string str = lhs.get_string();
-					std::string regexp = rhs.get_string();
+					const std::string &str = lhs.get_string_ref();
+					const std::string &regexp = rhs.get_string_ref();
 					try {
-						boost::regex re(regexp);
-						return value_container::create_int(boost::regex_match(str, re), lhs.is_unsure || rhs.is_unsure);
+						regex_cache::regex_type re = cache.get(regexp);
+						bool result = boost::regex_match(str, *re);
+						return value_container::create_int(negate ? !result : result, lhs.is_unsure || rhs.is_unsure);
 					} catch (const boost::bad_expression e) {
 						errors->error("Invalid syntax in regular expression:" + regexp);
 						return value_container::create_nil();
@@ -294,35 +301,11 @@ namespace parsers {
 					}
 				}
 			};
-			struct operator_not_regexp : public simple_bool_binary_operator_impl {
-				value_container eval_int(value_type type, evaluation_context errors, const node_type left, const node_type right) const {
-					errors->error("Like not supported on numbers...");
-					return value_container::create_nil();
-				};
-				value_container eval_float(value_type type, evaluation_context errors, const node_type left, const node_type right) const {
-					errors->error("Like not supported on numbers...");
-					return value_container::create_nil();
-				};
-				value_container eval_string(value_type type, evaluation_context errors, const node_type left, const node_type right) const {
-					value_container lhs = left->get_value(errors, type_string);
-					value_container rhs = right->get_value(errors, type_string);
-					if (!lhs.is(type_string) || !rhs.is(type_string)) {
-						errors->error("invalid type");
-						return value_container::create_nil();
-					}
-					std::string str = lhs.get_string();
-					std::string regexp = rhs.get_string();
-					try {
-						boost::regex re(regexp);
-						return value_container::create_int(!boost::regex_match(str, re), lhs.is_unsure || rhs.is_unsure);
-					} catch (const boost::bad_expression e) {
-						errors->error("Invalid syntax in regular expression:" + regexp);
-						return value_container::create_nil();
-					} catch (...) {
-						errors->error("Invalid syntax in regular expression:" + regexp);
-						return value_container::create_nil();
-					}
-				}
+			struct operator_regexp : public regexp_operator_impl {
+				operator_regexp() : regexp_operator_impl(false) {}
+			};
+			struct operator_not_regexp : public regexp_operator_impl {
+				operator_not_regexp() : regexp_operator_impl(true) {}
 			};
 			struct operator_not_like : public simple_bool_binary_operator_impl {
 				value_container eval_int(value_type type, evaluation_context errors, const node_type left, const node_type right) const {
@@ -340,8 +323,8 @@ namespace parsers {
 						errors->error("invalid type");
 						return value_container::create_nil();
 					}
-					std::string s1 = boost::algorithm::to_lower_copy(lhs.get_string());
-					std::string s2 = boost::algorithm::to_lower_copy(rhs.get_string());
+					std::string s1 = boost::algorithm::to_lower_copy(lhs.get_string_ref());
+					std::string s2 = boost::algorithm::to_lower_copy(rhs.get_string_ref());
 					if (s1.size() == 0 && s2.size() == 0)
 						return value_container::create_int(0, lhs.is_unsure || rhs.is_unsure);
 					if (s1.size() == 0 || s2.size() == 0)
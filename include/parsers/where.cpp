@@ -29,6 +29,8 @@
 // #include <boost/fusion/include/io.hpp>
 // #include <boost/function.hpp>
 
+#include <boost/foreach.hpp>
+
 #include <parsers/where.hpp>
 #include <parsers/where/node.hpp>
 
@@ -101,7 +103,25 @@ namespace parsers {
 			return resulting_tree->require_object(context);
 		}
 
+		bool parser::compile(evaluation_context context, regex_cache_type cache) {
+			return program.compile(resulting_tree, context, cache);
+		}
+
 		value_container parser::evaluate(evaluation_context context) {
+			if (!program.is_compiled())
+				return evaluate_tree(context);
+			try {
+				return program.execute(context);
+			} catch (const std::exception &e) {
+				context->error(std::string("Evaluate exception: ") + e.what());
+				return value_container::create_nil();
+			} catch (...) {
+				context->error("Evaluate exception: " + result_as_tree());
+				return value_container::create_nil();
+			}
+		}
+
+		value_container parser::evaluate_tree(evaluation_context context) {
 			try {
 				node_type result = resulting_tree->evaluate(context);
 				return result->get_value(context, type_int);
@@ -114,11 +134,39 @@ namespace parsers {
 			}
 		}
 
+		std::size_t parser::evaluate_batch(evaluation_context context, batch_binder &binder, const batch_rows &rows, batch_rows &matched) {
+			if (program.is_compiled()) {
+				const std::size_t first = matched.size();
+				try {
+					return program.execute_batch(context, binder, rows, matched);
+				} catch (const std::exception &e) {
+					context->error(std::string("Evaluate exception: ") + e.what());
+				} catch (...) {
+					context->error("Evaluate exception: " + result_as_tree());
+				}
+				matched.resize(first);
+				return 0;
+			}
+			std::size_t unsure = 0;
+			BOOST_FOREACH(std::size_t row, rows) {
+				binder.bind(row);
+				value_container v = evaluate_tree(context);
+				if (v.is_unsure)
+					unsure++;
+				if (v.is_true())
+					matched.push_back(row);
+			}
+			return unsure;
+		}
+
 		std::string parser::result_as_tree() const {
 			return resulting_tree->to_string();
 		}
 		std::string parser::result_as_tree(evaluation_context context) const {
 			return resulting_tree->to_string(context);
 		}
+		std::string parser::result_as_program() const {
+			return program.to_string();
+		}
 	}
 }
\ No newline at end of file
@@ -20,20 +20,26 @@
 #pragma once
 
 #include <parsers/where/node.hpp>
+#include <parsers/where/compiler.hpp>
 
 namespace parsers {
 	namespace where {
 		struct parser {
 			node_type resulting_tree;
+			compiled_program program;
 			std::string rest;
 			bool parse(object_factory factory, std::string expr);
 			bool derive_types(object_converter converter);
 			bool static_eval(evaluation_context context);
 			bool bind(object_converter context);
+			bool compile(evaluation_context context, regex_cache_type cache = regex_cache_type());
 			value_container evaluate(evaluation_context context);
+			value_container evaluate_tree(evaluation_context context);
+			std::size_t evaluate_batch(evaluation_context context, batch_binder &binder, const batch_rows &rows, batch_rows &matched);
 			bool collect_perfkeys(evaluation_context context, performance_collector &boundries);
 			std::string result_as_tree() const;
 			std::string result_as_tree(evaluation_context context) const;
+			std::string result_as_program() const;
 			bool require_object(evaluation_context context) const;
 		};
 	}
@@ -18,8 +18,10 @@
  */
 
 #include <sstream>
+#include <algorithm>
 
 #include <parsers/where/binary_op.hpp>
+#include <parsers/where/compiler.hpp>
 #include <parsers/where/helpers.hpp>
 #include <parsers/operators.hpp>
 
@@ -29,7 +31,9 @@ namespace parsers {
 			return true;
 		}
 		node_type binary_op::evaluate(evaluation_context errors) const {
-			op_factory::bin_op_type impl = op_factory::get_binary_operator(op, left, right);
+			op_factory::bin_op_type impl = bound_impl;
+			if (!impl)
+				impl = op_factory::get_binary_operator(op, left, right);
 			if (is_int() || is_string()) {
 				return impl->evaluate(errors, left, right);
 			}
@@ -37,7 +41,10 @@ namespace parsers {
 			return factory::create_false();
 		}
 		bool binary_op::bind(object_converter errors) {
-			return left->bind(errors) && right->bind(errors);
+			if (!left->bind(errors) || !right->bind(errors))
+				return false;
+			bound_impl = op_factory::get_binary_operator(op, left, right);
+			return true;
 		}
 
 		value_container binary_op::get_value(evaluation_context errors, value_type type) const {
@@ -100,5 +107,98 @@ namespace parsers {
 		bool binary_op::static_evaluate(evaluation_context errors) const {
 			return left->static_evaluate(errors) && right->static_evaluate(errors);
 		}
+
+		// Resolves the operand type the same way simple_bool_binary_operator_impl does at runtime.
+		value_type binary_op::get_operand_type() const {
+			value_type ltype = left->get_type();
+			value_type rtype = right->get_type();
+			if (helpers::type_is_int(ltype) && helpers::type_is_int(rtype))
+				return type_int;
+			if (helpers::type_is_float(ltype) && helpers::type_is_float(rtype))
+				return type_float;
+			if ((ltype != rtype) && (rtype != type_tbd))
+				return type_invalid;
+			if (helpers::type_is_int(ltype))
+				return type_int;
+			if (helpers::type_is_float(ltype))
+				return type_float;
+			if (ltype == type_string)
+				return type_string;
+			return type_invalid;
+		}
+
+		bool binary_op::compile(compiled_program &program, evaluation_context context, value_type type, std::size_t &slot) const {
+			// Anything but the integer result or an operator which reports errors at runtime is left to the tree.
+			if (type != type_int || !(is_int() || is_string()))
+				return false;
+			if (program.fold_constant(this, context, type, slot))
+				return true;
+			std::size_t lhs = 0, rhs = 0;
+			if (op == op_and || op == op_or || op == op_binand || op == op_binor) {
+				if (!helpers::type_is_int(left->get_type()) || !helpers::type_is_int(right->get_type()))
+					return false;
+				// and/or are commutative (including the unsure flag) so the cheaper operand is evaluated first
+				node_type first = left, second = right;
+				if (right->get_cost() < left->get_cost())
+					std::swap(first, second);
+				if (!first->compile(program, context, type_int, lhs))
+					lhs = program.emit_load(first.get(), type_int);
+				if (program.is_constant(lhs) && !program.get_slot(lhs).is_unsure && !program.get_slot(lhs).is_nil) {
+					bool value = program.get_slot(lhs).i_value != 0;
+					bool is_and = op == op_and || op == op_binand;
+					// false and x, true or x
+					if (value != is_and) {
+						slot = program.add_constant(value_container::create_int(value, false));
+						return true;
+					}
+					// true and x, false or x (only when x is already a boolean)
+					if (second->get_type() == type_bool) {
+						if (!second->compile(program, context, type_int, slot))
+							slot = program.emit_load(second.get(), type_int);
+						return true;
+					}
+				}
+				slot = program.add_slot();
+				std::size_t jump = program.emit_short_circuit(op, lhs, slot);
+				if (!second->compile(program, context, type_int, rhs))
+					rhs = program.emit_load(second.get(), type_int);
+				program.emit_logical(op, lhs, rhs, slot);
+				program.patch_jump(jump);
+				return true;
+			}
+			value_type operand_type = get_operand_type();
+			if (operand_type == type_invalid)
+				return false;
+			if (op == op_like || op == op_not_like || op == op_regexp || op == op_not_regexp) {
+				if (operand_type != type_string)
+					return false;
+			} else if (op != op_eq && op != op_ne && op != op_gt && op != op_lt && op != op_ge && op != op_le) {
+				return false;
+			}
+			if (!left->compile(program, context, operand_type, lhs))
+				lhs = program.emit_load(left.get(), operand_type);
+			if (!right->compile(program, context, operand_type, rhs))
+				rhs = program.emit_load(right.get(), operand_type);
+			if (op == op_like || op == op_not_like)
+				slot = program.emit_like(op, lhs, rhs);
+			else if (op == op_regexp || op == op_not_regexp)
+				slot = program.emit_regexp(op, lhs, rhs);
+			else
+				slot = program.emit_compare(op, operand_type, lhs, rhs);
+			return true;
+		}
+
+		std::size_t binary_op::get_cost() const {
+			std::size_t cost = left->get_cost() + right->get_cost();
+			if (op == op_regexp || op == op_not_regexp)
+				return cost + 32;
+			if (op == op_like || op == op_not_like)
+				return cost + 8;
+			if (op == op_in || op == op_nin)
+				return cost + 4;
+			if (op == op_and || op == op_or || op == op_binand || op == op_binor)
+				return cost;
+			return cost + (left->get_type() == type_string ? 2 : 1);
+		}
 	}
 }
\ No newline at end of file
@@ -43,12 +43,16 @@ namespace parsers {
 			virtual bool find_performance_data(evaluation_context context, performance_collector &collector);
 			virtual bool static_evaluate(evaluation_context contxt) const;
 			virtual bool require_object(evaluation_context contxt) const;
+			virtual bool compile(compiled_program &program, evaluation_context context, value_type type, std::size_t &slot) const;
+			virtual std::size_t get_cost() const;
 
 		private:
 			binary_op() {}
+			value_type get_operand_type() const;
 			operators op;
 			node_type left;
 			node_type right;
+			boost::shared_ptr<binary_operator_impl> bound_impl;
 		};
 	}
 }
\ No newline at end of file
@@ -0,0 +1,698 @@
+/*
+ * Copyright (C) 2004-2016 Michael Medin
+ *
+ * This file is part of NSClient++ - https://nsclient.org
+ *
+ * NSClient++ is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * NSClient++ is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with NSClient++.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <sstream>
+#include <functional>
+
+#include <boost/algorithm/string.hpp>
+#include <boost/foreach.hpp>
+
+#include <str/xtos.hpp>
+
+#include <parsers/where/compiler.hpp>
+#include <parsers/where/helpers.hpp>
+
+namespace parsers {
+	namespace where {
+
+		namespace compiler_impl {
+			template<class T>
+			inline bool compare(operators op, const T &lhs, const T &rhs) {
+				switch (op) {
+				case op_eq: return lhs == rhs;
+				case op_ne: return lhs != rhs;
+				case op_gt: return lhs > rhs;
+				case op_lt: return lhs < rhs;
+				case op_ge: return lhs >= rhs;
+				case op_le: return lhs <= rhs;
+				default: return false;
+				}
+			}
+
+			inline bool like(const std::string &lhs, const std::string &rhs) {
+				std::string s1 = boost::algorithm::to_lower_copy(lhs);
+				std::string s2 = boost::algorithm::to_lower_copy(rhs);
+				if (s1.size() == 0 && s2.size() == 0)
+					return true;
+				if (s1.size() == 0 || s2.size() == 0)
+					return false;
+				if (s1.size() > s2.size())
+					return s1.find(s2) != std::string::npos;
+				return s2.find(s1) != std::string::npos;
+			}
+
+			inline void set_bool(compiled_slot &slot, bool value, bool is_unsure) {
+				slot.i_value = value ? 1 : 0;
+				slot.is_unsure = is_unsure;
+				slot.is_nil = false;
+			}
+
+			inline long long get_int(const compiled_slot &slot) {
+				if (slot.is_nil)
+					throw filter_exception("Type is not int");
+				return slot.i_value;
+			}
+
+			// The comparison loops run over the selected rows only, operands are read with the column stride so constants are never broadcast.
+			template<class T, class Cmp>
+			inline void compare_loop(const batch_rows &active, const std::vector<T> &lhs, std::size_t ls, const std::vector<T> &rhs, std::size_t rs, std::vector<long long> &target, Cmp cmp) {
+				const T *l = &lhs[0];
+				const T *r = &rhs[0];
+				long long *t = &target[0];
+				const std::size_t count = active.size();
+				for (std::size_t i = 0; i < count; ++i) {
+					const std::size_t row = active[i];
+					t[row] = cmp(l[row * ls], r[row * rs]) ? 1 : 0;
+				}
+			}
+
+			template<class T>
+			inline void compare_rows(operators op, const batch_rows &active, const std::vector<T> &lhs, std::size_t ls, const std::vector<T> &rhs, std::size_t rs, std::vector<long long> &target) {
+				switch (op) {
+				case op_eq: compare_loop(active, lhs, ls, rhs, rs, target, std::equal_to<T>()); break;
+				case op_ne: compare_loop(active, lhs, ls, rhs, rs, target, std::not_equal_to<T>()); break;
+				case op_gt: compare_loop(active, lhs, ls, rhs, rs, target, std::greater<T>()); break;
+				case op_lt: compare_loop(active, lhs, ls, rhs, rs, target, std::less<T>()); break;
+				case op_ge: compare_loop(active, lhs, ls, rhs, rs, target, std::greater_equal<T>()); break;
+				case op_le: compare_loop(active, lhs, ls, rhs, rs, target, std::less_equal<T>()); break;
+				default:
+					BOOST_FOREACH(std::size_t row, active) {
+						target[row] = 0;
+					}
+				}
+			}
+
+			inline void set_bool(compiled_column &column, std::size_t row, bool value, bool is_unsure) {
+				column.i_values[row] = value ? 1 : 0;
+				column.is_unsure[row] = is_unsure;
+				column.is_nil[row] = false;
+			}
+
+			inline bool is_and(operators op) {
+				return op == op_and || op == op_binand;
+			}
+
+			std::string type_to_string(value_type type) {
+				if (type == type_float)
+					return "float";
+				if (type == type_string)
+					return "string";
+				return "int";
+			}
+		}
+
+		void compiled_program::reset() {
+			slots_.clear();
+			code_.clear();
+			constants_.clear();
+			result_ = 0;
+			folded_ = 0;
+			compiled_ = false;
+		}
+
+		bool compiled_program::compile(node_type root, evaluation_context context, regex_cache_type cache) {
+			reset();
+			regex_cache_ = cache ? cache : regex_cache_type(new regex_cache());
+			// Constants and plain values are never evaluated at the root so we leave those to the tree.
+			if (!root || !root->can_evaluate())
+				return false;
+			try {
+				std::size_t slot = 0;
+				if (!root->compile(*this, context, type_int, slot)) {
+					reset();
+					return false;
+				}
+				result_ = slot;
+				compiled_ = true;
+				return true;
+			} catch (const std::exception &e) {
+				context->error(std::string("Failed to compile expression: ") + e.what());
+			} catch (...) {
+				context->error("Failed to compile expression");
+			}
+			reset();
+			return false;
+		}
+
+		std::size_t compiled_program::add_slot() {
+			slots_.push_back(compiled_slot());
+			constants_.push_back(false);
+			return slots_.size() - 1;
+		}
+
+		std::size_t compiled_program::add_constant(const value_container &value) {
+			std::size_t slot = add_slot();
+			compiled_slot &s = slots_[slot];
+			s.is_unsure = value.is_unsure;
+			s.is_nil = value.is_nil();
+			if (value.is(type_int))
+				s.i_value = value.get_int();
+			else if (value.is(type_float))
+				s.f_value = value.get_float();
+			else if (value.is(type_string))
+				s.s_value = value.get_string_ref();
+			constants_[slot] = true;
+			return slot;
+		}
+
+		bool compiled_program::fold_constant(const any_node *node, evaluation_context context, value_type type, std::size_t &slot) {
+			if (!node->static_evaluate(context))
+				return false;
+			value_container value = node->get_value(context, type);
+			if (context->has_error() || !value.is(type)) {
+				// Leave it to the tree so the error is reported when evaluated
+				context->clear();
+				return false;
+			}
+			slot = add_constant(value);
+			folded_++;
+			return true;
+		}
+
+		std::size_t compiled_program::emit_load(const any_node *node, value_type type) {
+			compiled_instruction ins(compiled_instruction::code_load);
+			ins.node = node;
+			ins.type = type;
+			ins.target = add_slot();
+			code_.push_back(ins);
+			return ins.target;
+		}
+
+		std::size_t compiled_program::emit_compare(operators op, value_type type, std::size_t lhs, std::size_t rhs) {
+			compiled_instruction ins(compiled_instruction::code_compare);
+			ins.op = op;
+			ins.type = type;
+			ins.lhs = lhs;
+			ins.rhs = rhs;
+			ins.target = add_slot();
+			code_.push_back(ins);
+			return ins.target;
+		}
+
+		std::size_t compiled_program::emit_like(operators op, std::size_t lhs, std::size_t rhs) {
+			compiled_instruction ins(compiled_instruction::code_like);
+			ins.op = op;
+			ins.type = type_string;
+			ins.lhs = lhs;
+			ins.rhs = rhs;
+			ins.target = add_slot();
+			code_.push_back(ins);
+			return ins.target;
+		}
+
+		std::size_t compiled_program::emit_regexp(operators op, std::size_t lhs, std::size_t rhs) {
+			compiled_instruction ins(compiled_instruction::code_regexp);
+			ins.op = op;
+			ins.type = type_string;
+			ins.lhs = lhs;
+			ins.rhs = rhs;
+			if (constants_[rhs] && !slots_[rhs].is_nil) {
+				try {
+					ins.regex = regex_cache_->compile(slots_[rhs].s_value);
+				} catch (...) {
+					// Invalid patterns are reported for each evaluation (same as the tree)
+				}
+			}
+			ins.target = add_slot();
+			code_.push_back(ins);
+			return ins.target;
+		}
+
+		std::size_t compiled_program::emit_not(std::size_t lhs) {
+			compiled_instruction ins(compiled_instruction::code_not);
+			ins.lhs = lhs;
+			ins.target = add_slot();
+			code_.push_back(ins);
+			return ins.target;
+		}
+
+		std::size_t compiled_program::emit_short_circuit(operators op, std::size_t lhs, std::size_t target) {
+			compiled_instruction ins(compiled_instruction::code_short_circuit);
+			ins.op = op;
+			ins.lhs = lhs;
+			ins.target = target;
+			code_.push_back(ins);
+			return code_.size() - 1;
+		}
+
+		void compiled_program::emit_logical(operators op, std::size_t lhs, std::size_t rhs, std::size_t target) {
+			compiled_instruction ins(compiled_instruction::code_logical);
+			ins.op = op;
+			ins.lhs = lhs;
+			ins.rhs = rhs;
+			ins.target = target;
+			code_.push_back(ins);
+		}
+
+		void compiled_program::patch_jump(std::size_t instruction) {
+			code_[instruction].jump = code_.size();
+		}
+
+		value_container compiled_program::execute(evaluation_context context) {
+			const std::size_t end = code_.size();
+			std::size_t pc = 0;
+			while (pc < end) {
+				const compiled_instruction &ins = code_[pc++];
+				compiled_slot &target = slots_[ins.target];
+				switch (ins.code) {
+				case compiled_instruction::code_load:
+					{
+						value_container v = ins.node->get_value(context, ins.type);
+						target.is_unsure = v.is_unsure;
+						target.is_nil = !v.is(ins.type);
+						if (target.is_nil)
+							break;
+						if (ins.type == type_int)
+							target.i_value = v.get_int();
+						else if (ins.type == type_float)
+							target.f_value = v.get_float();
+						else
+							v.swap_string(target.s_value);
+					}
+					break;
+
+				case compiled_instruction::code_compare:
+					{
+						const compiled_slot &lhs = slots_[ins.lhs];
+						const compiled_slot &rhs = slots_[ins.rhs];
+						if (lhs.is_nil || rhs.is_nil) {
+							context->error("invalid type");
+							compiler_impl::set_bool(target, false, false);
+						} else if (ins.type == type_int) {
+							compiler_impl::set_bool(target, compiler_impl::compare(ins.op, lhs.i_value, rhs.i_value), lhs.is_unsure || rhs.is_unsure);
+						} else if (ins.type == type_float) {
+							bool result = compiler_impl::compare(ins.op, lhs.f_value, rhs.f_value);
+							// Mirrors operator_lt which only carries the right hand uncertainty on a miss
+							if (ins.op == op_lt && !result)
+								compiler_impl::set_bool(target, result, rhs.is_unsure);
+							else
+								compiler_impl::set_bool(target, result, lhs.is_unsure || rhs.is_unsure);
+						} else {
+							compiler_impl::set_bool(target, compiler_impl::compare(ins.op, lhs.s_value, rhs.s_value), lhs.is_unsure || rhs.is_unsure);
+						}
+					}
+					break;
+
+				case compiled_instruction::code_like:
+					{
+						const compiled_slot &lhs = slots_[ins.lhs];
+						const compiled_slot &rhs = slots_[ins.rhs];
+						if (lhs.is_nil || rhs.is_nil) {
+							context->error("invalid type");
+							compiler_impl::set_bool(target, false, false);
+						} else {
+							bool result = compiler_impl::like(lhs.s_value, rhs.s_value);
+							if (ins.op == op_not_like)
+								result = !result;
+							compiler_impl::set_bool(target, result, lhs.is_unsure || rhs.is_unsure);
+						}
+					}
+					break;
+
+				case compiled_instruction::code_regexp:
+					{
+						const compiled_slot &lhs = slots_[ins.lhs];
+						const compiled_slot &rhs = slots_[ins.rhs];
+						if (lhs.is_nil || rhs.is_nil) {
+							context->error("invalid type");
+							compiler_impl::set_bool(target, false, false);
+							break;
+						}
+						try {
+							regex_cache::regex_type re = ins.regex ? ins.regex : regex_cache_->get(rhs.s_value);
+							bool result = boost::regex_match(lhs.s_value, *re);
+							if (ins.op == op_not_regexp)
+								result = !result;
+							compiler_impl::set_bool(target, result, lhs.is_unsure || rhs.is_unsure);
+						} catch (...) {
+							context->error("Invalid syntax in regular expression:" + rhs.s_value);
+							compiler_impl::set_bool(target, false, false);
+						}
+					}
+					break;
+
+				case compiled_instruction::code_not:
+					{
+						// Mirrors operator_not which drops the uncertainty and treats nil as false
+						const compiled_slot &lhs = slots_[ins.lhs];
+						compiler_impl::set_bool(target, lhs.is_nil || !lhs.i_value, false);
+					}
+					break;
+
+				case compiled_instruction::code_short_circuit:
+					{
+						const compiled_slot &lhs = slots_[ins.lhs];
+						long long value = compiler_impl::get_int(lhs);
+						if (lhs.is_unsure)
+							break;
+						if (ins.op == op_and || ins.op == op_binand) {
+							if (!value) {
+								compiler_impl::set_bool(target, false, false);
+								pc = ins.jump;
+							}
+						} else if (value) {
+							compiler_impl::set_bool(target, true, false);
+							pc = ins.jump;
+						}
+					}
+					break;
+
+				case compiled_instruction::code_logical:
+					{
+						const compiled_slot &lhs = slots_[ins.lhs];
+						const compiled_slot &rhs = slots_[ins.rhs];
+						long long lhsi = compiler_impl::get_int(lhs);
+						long long rhsi = compiler_impl::get_int(rhs);
+						if (ins.op == op_and || ins.op == op_binand) {
+							if (!rhsi && !rhs.is_unsure)
+								compiler_impl::set_bool(target, false, false);
+							else
+								compiler_impl::set_bool(target, lhsi && rhsi, lhs.is_unsure || rhs.is_unsure);
+						} else {
+							if (rhsi && !rhs.is_unsure)
+								compiler_impl::set_bool(target, true, false);
+							else
+								compiler_impl::set_bool(target, lhsi || rhsi, lhs.is_unsure || rhs.is_unsure);
+						}
+					}
+					break;
+				}
+			}
+			const compiled_slot &result = slots_[result_];
+			return value_container::create_int(result.i_value, result.is_unsure);
+		}
+
+		void compiled_program::prepare_batch(std::size_t rows) {
+			columns_.resize(slots_.size());
+			for (std::size_t i = 0; i < slots_.size(); ++i) {
+				compiled_column &column = columns_[i];
+				if (constants_[i]) {
+					const compiled_slot &slot = slots_[i];
+					column.stride = 0;
+					column.i_values.assign(1, slot.i_value);
+					column.f_values.assign(1, slot.f_value);
+					column.s_values.assign(1, slot.s_value);
+					column.is_unsure.assign(1, slot.is_unsure);
+					column.is_nil.assign(1, slot.is_nil);
+				} else {
+					column.stride = 1;
+					column.i_values.resize(rows);
+					column.f_values.resize(rows);
+					column.is_unsure.resize(rows);
+					column.is_nil.resize(rows);
+				}
+			}
+			BOOST_FOREACH(const compiled_instruction &ins, code_) {
+				if (ins.code == compiled_instruction::code_load && ins.type == type_string)
+					columns_[ins.target].s_values.resize(rows);
+			}
+		}
+
+		// Evaluates the program for a batch of rows one instruction at a time.
+		// Short circuits narrow the set of active rows until the jump target is reached so the expensive
+		// operands (string matching) only run for the rows which are still undecided.
+		// Rows which fail (where execute would throw) are dropped and reported the same way evaluate does.
+		std::size_t compiled_program::execute_batch(evaluation_context context, batch_binder &binder, const batch_rows &rows, batch_rows &matched) {
+			const std::size_t count = rows.size();
+			if (count == 0)
+				return 0;
+			prepare_batch(count);
+
+			batch_rows active(count);
+			for (std::size_t i = 0; i < count; ++i)
+				active[i] = i;
+			std::vector<char> aborted(count, false);
+			bool has_aborted = false;
+			typedef std::pair<std::size_t, batch_rows> scope_type;
+			std::vector<scope_type> scopes;
+
+			const std::size_t end = code_.size();
+			std::size_t pc = 0;
+			while (pc < end) {
+				while (!scopes.empty() && scopes.back().first <= pc) {
+					active.swap(scopes.back().second);
+					scopes.pop_back();
+					if (has_aborted) {
+						batch_rows::iterator last = active.begin();
+						BOOST_FOREACH(std::size_t row, active) {
+							if (!aborted[row])
+								*last++ = row;
+						}
+						active.erase(last, active.end());
+					}
+				}
+				if (active.empty()) {
+					if (scopes.empty())
+						break;
+					pc = scopes.back().first;
+					continue;
+				}
+				const compiled_instruction &ins = code_[pc++];
+				compiled_column &target = columns_[ins.target];
+				switch (ins.code) {
+				case compiled_instruction::code_load:
+					{
+						batch_rows::iterator last = active.begin();
+						BOOST_FOREACH(std::size_t row, active) {
+							try {
+								binder.bind(rows[row]);
+								value_container v = ins.node->get_value(context, ins.type);
+								target.is_unsure[row] = v.is_unsure;
+								target.is_nil[row] = !v.is(ins.type);
+								if (!target.is_nil[row]) {
+									if (ins.type == type_int)
+										target.i_values[row] = v.get_int();
+									else if (ins.type == type_float)
+										target.f_values[row] = v.get_float();
+									else
+										v.swap_string(target.s_values[row]);
+								}
+								*last++ = row;
+							} catch (const std::exception &e) {
+								context->error(std::string("Evaluate exception: ") + e.what());
+								aborted[row] = has_aborted = true;
+							}
+						}
+						active.erase(last, active.end());
+					}
+					break;
+
+				case compiled_instruction::code_compare:
+					{
+						const compiled_column &lhs = columns_[ins.lhs];
+						const compiled_column &rhs = columns_[ins.rhs];
+						if (ins.type == type_int)
+							compiler_impl::compare_rows(ins.op, active, lhs.i_values, lhs.stride, rhs.i_values, rhs.stride, target.i_values);
+						else if (ins.type == type_float)
+							compiler_impl::compare_rows(ins.op, active, lhs.f_values, lhs.stride, rhs.f_values, rhs.stride, target.i_values);
+						else
+							compiler_impl::compare_rows(ins.op, active, lhs.s_values, lhs.stride, rhs.s_values, rhs.stride, target.i_values);
+						// Same flags as execute (including the float less than quirk)
+						const bool rhs_only_on_miss = ins.type == type_float && ins.op == op_lt;
+						BOOST_FOREACH(std::size_t row, active) {
+							const std::size_t l = row * lhs.stride, r = row * rhs.stride;
+							if (lhs.is_nil[l] || rhs.is_nil[r]) {
+								context->error("invalid type");
+								compiler_impl::set_bool(target, row, false, false);
+							} else if (rhs_only_on_miss && !target.i_values[row]) {
+								target.is_unsure[row] = rhs.is_unsure[r];
+								target.is_nil[row] = false;
+							} else {
+								target.is_unsure[row] = lhs.is_unsure[l] || rhs.is_unsure[r];
+								target.is_nil[row] = false;
+							}
+						}
+					}
+					break;
+
+				case compiled_instruction::code_like:
+					{
+						const compiled_column &lhs = columns_[ins.lhs];
+						const compiled_column &rhs = columns_[ins.rhs];
+						BOOST_FOREACH(std::size_t row, active) {
+							const std::size_t l = row * lhs.stride, r = row * rhs.stride;
+							if (lhs.is_nil[l] || rhs.is_nil[r]) {
+								context->error("invalid type");
+								compiler_impl::set_bool(target, row, false, false);
+								continue;
+							}
+							bool result = compiler_impl::like(lhs.s_values[l], rhs.s_values[r]);
+							if (ins.op == op_not_like)
+								result = !result;
+							compiler_impl::set_bool(target, row, result, lhs.is_unsure[l] || rhs.is_unsure[r]);
+						}
+					}
+					break;
+
+				case compiled_instruction::code_regexp:
+					{
+						const compiled_column &lhs = columns_[ins.lhs];
+						const compiled_column &rhs = columns_[ins.rhs];
+						BOOST_FOREACH(std::size_t row, active) {
+							const std::size_t l = row * lhs.stride, r = row * rhs.stride;
+							if (lhs.is_nil[l] || rhs.is_nil[r]) {
+								context->error("invalid type");
+								compiler_impl::set_bool(target, row, false, false);
+								continue;
+							}
+							try {
+								regex_cache::regex_type re = ins.regex ? ins.regex : regex_cache_->get(rhs.s_values[r]);
+								bool result = boost::regex_match(lhs.s_values[l], *re);
+								if (ins.op == op_not_regexp)
+									result = !result;
+								compiler_impl::set_bool(target, row, result, lhs.is_unsure[l] || rhs.is_unsure[r]);
+							} catch (...) {
+								context->error("Invalid syntax in regular expression:" + rhs.s_values[r]);
+								compiler_impl::set_bool(target, row, false, false);
+							}
+						}
+					}
+					break;
+
+				case compiled_instruction::code_not:
+					{
+						const compiled_column &lhs = columns_[ins.lhs];
+						BOOST_FOREACH(std::size_t row, active) {
+							const std::size_t l = row * lhs.stride;
+							compiler_impl::set_bool(target, row, lhs.is_nil[l] || !lhs.i_values[l], false);
+						}
+					}
+					break;
+
+				case compiled_instruction::code_short_circuit:
+					{
+						const compiled_column &lhs = columns_[ins.lhs];
+						const bool decides_on = !compiler_impl::is_and(ins.op);
+						batch_rows undecided;
+						undecided.reserve(active.size());
+						BOOST_FOREACH(std::size_t row, active) {
+							const std::size_t l = row * lhs.stride;
+							if (lhs.is_nil[l]) {
+								context->error("Evaluate exception: Type is not int");
+								aborted[row] = has_aborted = true;
+							} else if (!lhs.is_unsure[l] && (lhs.i_values[l] != 0) == decides_on) {
+								compiler_impl::set_bool(target, row, decides_on, false);
+							} else {
+								undecided.push_back(row);
+							}
+						}
+						scopes.push_back(scope_type(ins.jump, batch_rows()));
+						scopes.back().second.swap(active);
+						active.swap(undecided);
+					}
+					break;
+
+				case compiled_instruction::code_logical:
+					{
+						const compiled_column &lhs = columns_[ins.lhs];
+						const compiled_column &rhs = columns_[ins.rhs];
+						const bool is_and = compiler_impl::is_and(ins.op);
+						batch_rows::iterator last = active.begin();
+						BOOST_FOREACH(std::size_t row, active) {
+							const std::size_t l = row * lhs.stride, r = row * rhs.stride;
+							if (lhs.is_nil[l] || rhs.is_nil[r]) {
+								context->error("Evaluate exception: Type is not int");
+								aborted[row] = has_aborted = true;
+								continue;
+							}
+							const long long lhsi = lhs.i_values[l], rhsi = rhs.i_values[r];
+							const bool unsure = lhs.is_unsure[l] || rhs.is_unsure[r];
+							if (is_and) {
+								if (!rhsi && !rhs.is_unsure[r])
+									compiler_impl::set_bool(target, row, false, false);
+								else
+									compiler_impl::set_bool(target, row, lhsi && rhsi, unsure);
+							} else {
+								if (rhsi && !rhs.is_unsure[r])
+									compiler_impl::set_bool(target, row, true, false);
+								else
+									compiler_impl::set_bool(target, row, lhsi || rhsi, unsure);
+							}
+							*last++ = row;
+						}
+						active.erase(last, active.end());
+					}
+					break;
+				}
+			}
+
+			const compiled_column &result = columns_[result_];
+			std::size_t unsure = 0;
+			for (std::size_t row = 0; row < count; ++row) {
+				if (aborted[row])
+					continue;
+				const std::size_t r = row * result.stride;
+				if (result.is_unsure[r])
+					unsure++;
+				if (!result.is_nil[r] && result.i_values[r] == 1)
+					matched.push_back(rows[row]);
+			}
+			return unsure;
+		}
+
+		std::string compiled_program::slot_to_string(std::size_t slot) const {
+			if (!constants_[slot])
+				return "s" + str::xtos(slot);
+			const compiled_slot &s = slots_[slot];
+			if (s.is_nil)
+				return "nil";
+			if (!s.s_value.empty())
+				return "'" + s.s_value + "'";
+			if (s.f_value != 0.0 && static_cast<double>(s.i_value) != s.f_value)
+				return str::xtos(s.f_value);
+			return str::xtos(s.i_value);
+		}
+
+		std::string compiled_program::to_string() const {
+			if (!compiled_)
+				return "<not compiled>";
+			std::stringstream ss;
+			for (std::size_t i = 0; i < code_.size(); ++i) {
+				const compiled_instruction &ins = code_[i];
+				ss << i << ": ";
+				switch (ins.code) {
+				case compiled_instruction::code_load:
+					ss << slot_to_string(ins.target) << " = load(" << compiler_impl::type_to_string(ins.type) << ") " << ins.node->to_string();
+					break;
+				case compiled_instruction::code_compare:
+				case compiled_instruction::code_like:
+				case compiled_instruction::code_regexp:
+					ss << slot_to_string(ins.target) << " = " << slot_to_string(ins.lhs) << " " << helpers::operator_to_string(ins.op) << "(" << compiler_impl::type_to_string(ins.type) << ") " << slot_to_string(ins.rhs);
+					if (ins.regex)
+						ss << " (precompiled)";
+					break;
+				case compiled_instruction::code_not:
+					ss << slot_to_string(ins.target) << " = not " << slot_to_string(ins.lhs);
+					break;
+				case compiled_instruction::code_short_circuit:
+					ss << "if " << slot_to_string(ins.lhs) << " decides " << helpers::operator_to_string(ins.op) << ": " << slot_to_string(ins.target) << " = " << slot_to_string(ins.lhs) << ", goto " << ins.jump;
+					break;
+				case compiled_instruction::code_logical:
+					ss << slot_to_string(ins.target) << " = " << slot_to_string(ins.lhs) << " " << helpers::operator_to_string(ins.op) << " " << slot_to_string(ins.rhs);
+					break;
+				}
+				ss << "\n";
+			}
+			ss << "return " << slot_to_string(result_);
+			if (folded_ > 0)
+				ss << " (" << folded_ << " constant expressions folded)";
+			return ss.str();
+		}
+	}
+}
@@ -0,0 +1,133 @@
+/*
+ * Copyright (C) 2004-2016 Michael Medin
+ *
+ * This file is part of NSClient++ - https://nsclient.org
+ *
+ * NSClient++ is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * NSClient++ is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with NSClient++.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include <parsers/where/node.hpp>
+#include <parsers/where/regex_cache.hpp>
+#include <parsers/where/dll_defines.hpp>
+
+namespace parsers {
+	namespace where {
+
+		// A typed register used by the compiled program.
+		// Constants are stored in slots which are never written to during execution.
+		struct compiled_slot {
+			long long i_value;
+			double f_value;
+			std::string s_value;
+			bool is_unsure;
+			bool is_nil;
+
+			compiled_slot() : i_value(0), f_value(0.0), is_unsure(false), is_nil(false) {}
+		};
+
+		struct compiled_instruction {
+			enum opcode {
+				code_load,			// target <- node->get_value(type) (variables and sub trees we cannot lower)
+				code_compare,		// target <- lhs <op> rhs
+				code_like,			// target <- lhs (not) like rhs
+				code_regexp,		// target <- lhs (not) regexp rhs (using regex when the pattern is constant)
+				code_not,			// target <- not lhs
+				code_short_circuit,	// if lhs decides the and/or: target <- lhs and jump
+				code_logical		// target <- lhs and/or rhs
+			};
+			opcode code;
+			operators op;
+			value_type type;
+			std::size_t target;
+			std::size_t lhs;
+			std::size_t rhs;
+			std::size_t jump;
+			const any_node *node;
+			regex_cache::regex_type regex;
+
+			compiled_instruction(opcode code) : code(code), op(op_eq), type(type_int), target(0), lhs(0), rhs(0), jump(0), node(NULL) {}
+		};
+
+		// Column storage for a slot when evaluating a batch (constants use a stride of 0 so they are never broadcast).
+		struct compiled_column {
+			std::vector<long long> i_values;
+			std::vector<double> f_values;
+			std::vector<std::string> s_values;
+			std::vector<char> is_unsure;
+			std::vector<char> is_nil;
+			std::size_t stride;
+
+			compiled_column() : stride(1) {}
+		};
+
+		// Binds the object for a given row in a batch (rows are whatever index the caller uses for its objects).
+		struct batch_binder {
+			virtual ~batch_binder() {}
+			virtual void bind(std::size_t row) = 0;
+		};
+		typedef std::vector<std::size_t> batch_rows;
+
+		// A flat, allocation free representation of a typed and bound expression tree.
+		// The program refers to nodes in the tree it was compiled from so it must not outlive it.
+		struct NSCAPI_EXPORT compiled_program {
+			typedef std::vector<compiled_slot> slot_list;
+			typedef std::vector<compiled_instruction> code_list;
+
+			compiled_program() : result_(0), folded_(0), compiled_(false) {}
+
+			bool compile(node_type root, evaluation_context context, regex_cache_type cache = regex_cache_type());
+			bool is_compiled() const { return compiled_; }
+			void reset();
+
+			value_container execute(evaluation_context context);
+			std::size_t execute_batch(evaluation_context context, batch_binder &binder, const batch_rows &rows, batch_rows &matched);
+
+			std::size_t add_slot();
+			std::size_t add_constant(const value_container &value);
+			bool fold_constant(const any_node *node, evaluation_context context, value_type type, std::size_t &slot);
+			bool is_constant(std::size_t slot) const { return constants_[slot]; }
+			const compiled_slot& get_slot(std::size_t slot) const { return slots_[slot]; }
+			std::size_t emit_load(const any_node *node, value_type type);
+			std::size_t emit_compare(operators op, value_type type, std::size_t lhs, std::size_t rhs);
+			std::size_t emit_like(operators op, std::size_t lhs, std::size_t rhs);
+			std::size_t emit_regexp(operators op, std::size_t lhs, std::size_t rhs);
+			std::size_t emit_not(std::size_t lhs);
+			std::size_t emit_short_circuit(operators op, std::size_t lhs, std::size_t target);
+			void emit_logical(operators op, std::size_t lhs, std::size_t rhs, std::size_t target);
+			void patch_jump(std::size_t instruction);
+
+			std::string to_string() const;
+
+		private:
+			std::string slot_to_string(std::size_t slot) const;
+			void prepare_batch(std::size_t rows);
+
+			typedef std::vector<compiled_column> column_list;
+
+			slot_list slots_;
+			code_list code_;
+			std::vector<bool> constants_;
+			regex_cache_type regex_cache_;
+			column_list columns_;
+			std::size_t result_;
+			std::size_t folded_;
+			bool compiled_;
+		};
+	}
+}
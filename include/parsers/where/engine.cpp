@@ -18,6 +18,7 @@
  */
 #include <str/utils.hpp>
 #include <str/format.hpp>
+#include <str/xtos.hpp>
 
 #include <parsers/where/engine.hpp>
 #include <boost/foreach.hpp>
@@ -25,7 +26,7 @@
 namespace parsers {
 	namespace where {
 
-		bool engine_filter::validate(error_handler error, object_factory context, bool perf_collection, parsers::where::performance_collector &boundries) {
+		bool engine_filter::validate(error_handler error, object_factory context, bool perf_collection, parsers::where::performance_collector &boundries, regex_cache_type regex_cache) {
 			if (error->is_debug())
 				error->log_debug("Parsing: " + filter_string);
 
@@ -57,6 +58,18 @@ namespace parsers {
 			if (error->is_debug())
 				error->log_debug("Static evaluation succeeded: " + ast_parser.result_as_tree());
 
+			if (ast_parser.compile(context, regex_cache)) {
+				if (error->is_debug())
+					error->log_debug("Optimised plan: " + ast_parser.result_as_program());
+			} else {
+				if (context->has_error()) {
+					error->log_error("Compilation failed: " + context->get_error());
+					return false;
+				}
+				if (error->is_debug())
+					error->log_debug("Compilation not possible, using tree evaluation: " + ast_parser.result_as_tree());
+			}
+
 			if (perf_collection) {
 				if (!ast_parser.collect_perfkeys(context, boundries) || context->has_error()) {
 					error->log_error("Collection of perfkeys failed: " + context->get_error());
@@ -95,14 +108,31 @@ namespace parsers {
 			return v.is_true();
 		}
 
-
+		void engine_filter::match_batch(error_handler error, execution_context_type context, batch_binder &binder, const batch_rows &rows, batch_rows &matched, bool expect_object) {
+			if (expect_object != require_object(context))
+				return;
+			std::size_t unsure = ast_parser.evaluate_batch(context, binder, rows, matched);
+			if (context->has_error()) {
+				error->log_error(context->get_error() + ": " + ast_parser.result_as_tree(context));
+			}
+			if (context->has_warn()) {
+				error->log_warning(context->get_warn() + ": " + ast_parser.result_as_tree(context));
+			}
+			if (context->has_debug()) {
+				error->log_debug(context->get_debug() + ": " + ast_parser.result_as_tree(context));
+			}
+			context->clear();
+			if (unsure > 0) {
+				error->log_warning("Ignoring " + str::xtos(unsure) + " unsure results: " + ast_parser.result_as_tree(context));
+			}
+		}
 
 
 		std::string engine_filter::to_string() const {
 			return filter_string;
 		}
 
-		engine::engine(std::vector<std::string> filter, error_handler error) : error(error) {
+		engine::engine(std::vector<std::string> filter, error_handler error) : error(error), regex_cache_(new regex_cache()) {
 			BOOST_FOREACH(const std::string &s, filter) {
 				filters_.push_back(engine_filter(s));
 			}
@@ -118,7 +148,7 @@ namespace parsers {
 
 		bool engine::validate(object_factory context) {
 			BOOST_FOREACH(engine_filter &f, filters_) {
-				if (!f.validate(error, context, perf_collection, boundries))
+				if (!f.validate(error, context, perf_collection, boundries, regex_cache_))
 					return false;
 			}
 			return true;
@@ -132,6 +162,38 @@ namespace parsers {
 			return false;
 		}
 
+		void engine::match_batch(execution_context_type context, batch_binder &binder, const batch_rows &rows, batch_rows &matched, bool expect_object) {
+			if (filters_.size() == 1) {
+				filters_.front().match_batch(error, context, binder, rows, matched, expect_object);
+				return;
+			}
+			// Each filter only sees the rows none of the previous filters matched
+			batch_rows remaining = rows, hits;
+			BOOST_FOREACH(engine_filter &f, filters_) {
+				if (remaining.empty())
+					break;
+				hits.clear();
+				f.match_batch(error, context, binder, remaining, hits, expect_object);
+				if (hits.empty())
+					continue;
+				batch_rows::iterator last = remaining.begin(), hit = hits.begin();
+				BOOST_FOREACH(std::size_t row, remaining) {
+					if (hit != hits.end() && *hit == row)
+						++hit;
+					else
+						*last++ = row;
+				}
+				remaining.erase(last, remaining.end());
+			}
+			batch_rows::const_iterator next = remaining.begin();
+			BOOST_FOREACH(std::size_t row, rows) {
+				if (next != remaining.end() && *next == row)
+					++next;
+				else
+					matched.push_back(row);
+			}
+		}
+
 		std::string engine::to_string() const {
 			std::string ret = "";
 			BOOST_FOREACH(const engine_filter &f, filters_) {
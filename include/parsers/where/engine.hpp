@@ -45,11 +45,12 @@ namespace parsers {
 
 			engine_filter(const std::string filter_string) : filter_string(filter_string) {}
 
-			bool validate(error_handler error, object_factory context, bool perf_collection, parsers::where::performance_collector &boundries);
+			bool validate(error_handler error, object_factory context, bool perf_collection, parsers::where::performance_collector &boundries, regex_cache_type regex_cache);
 
 			bool require_object(execution_context_type context);
 
 			bool match(error_handler error, execution_context_type context, bool expect_object);
+			void match_batch(error_handler error, execution_context_type context, batch_binder &binder, const batch_rows &rows, batch_rows &matched, bool expect_object);
 
 			std::string to_string() const;
 
@@ -67,6 +68,7 @@ namespace parsers {
 			parsers::where::performance_collector boundries;
 			error_handler error;
 			boost::optional<bool> requires_object;
+			regex_cache_type regex_cache_;
 
 			engine(std::vector<std::string> filter, error_handler error);
 
@@ -77,9 +79,14 @@ namespace parsers {
 			bool validate(object_factory context);
 
 			bool match(execution_context_type context, bool expect_object);
+			// Appends the rows matching any of the filters to matched (in the order of rows).
+			void match_batch(execution_context_type context, batch_binder &binder, const batch_rows &rows, batch_rows &matched, bool expect_object);
 
 			std::string get_subject() { return "TODO"; }
 
+			bool has_regex_statistics() const { return regex_cache_->get_compiles() > 0; }
+			std::string get_regex_statistics() const { return regex_cache_->to_string(); }
+
 			std::string to_string() const;
 		};
 	}
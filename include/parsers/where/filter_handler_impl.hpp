@@ -426,8 +426,15 @@ namespace parsers {
 			std::string list_warn;
 			std::string list_problem;
 			NSCAPI::nagiosReturn returnCode;
+			// Lists are only collected when something (syntax or filter) references them
+			bool collect_match;
+			bool collect_ok;
+			bool collect_warn;
+			bool collect_crit;
+			bool collect_problem;
 
-			generic_summary() : count_match(0), count_ok(0), count_warn(0), count_crit(0), count_total(0), returnCode(NSCAPI::query_return_codes::returnOK) {}
+			generic_summary() : count_match(0), count_ok(0), count_warn(0), count_crit(0), count_total(0), returnCode(NSCAPI::query_return_codes::returnOK)
+				, collect_match(false), collect_ok(false), collect_warn(false), collect_crit(false), collect_problem(false) {}
 
 			void move_hits_crit() {
 				list_crit = list_match;
@@ -439,14 +446,30 @@ namespace parsers {
 			}
 			void reset() {
 				count_match = count_ok = count_warn = count_crit = count_total = 0;
-				list_match = list_ok = list_warn = list_crit = "";
+				list_match = list_ok = list_warn = list_crit = list_problem = "";
 				returnCode = NSCAPI::query_return_codes::returnOK;
 			}
 			void count() {
 				count_total++;
 			}
-			void matched(std::string &line) {
-				str::format::append_list(list_match, line);
+			bool needs_match_line() const {
+				return collect_match;
+			}
+			bool needs_ok_line() const {
+				return collect_ok;
+			}
+			bool needs_warn_line() const {
+				return collect_warn || collect_problem;
+			}
+			bool needs_crit_line() const {
+				return collect_crit || collect_problem;
+			}
+			bool needs_lines() const {
+				return collect_match || collect_ok || collect_warn || collect_crit || collect_problem;
+			}
+			void matched(const std::string &line) {
+				if (collect_match)
+					str::format::append_list(list_match, line);
 				count_match++;
 			}
 			void matched_unique() {
@@ -455,18 +478,23 @@ namespace parsers {
 			bool has_matched() const {
 				return count_match > 0;
 			}
-			void matched_ok(std::string &line) {
-				str::format::append_list(list_ok, line);
+			void matched_ok(const std::string &line) {
+				if (collect_ok)
+					str::format::append_list(list_ok, line);
 				count_ok++;
 			}
-			void matched_warn(std::string &line) {
-				str::format::append_list(list_warn, line);
-				str::format::append_list(list_problem, line);
+			void matched_warn(const std::string &line) {
+				if (collect_warn)
+					str::format::append_list(list_warn, line);
+				if (collect_problem)
+					str::format::append_list(list_problem, line);
 				count_warn++;
 			}
-			void matched_crit(std::string &line) {
-				str::format::append_list(list_crit, line);
-				str::format::append_list(list_problem, line);
+			void matched_crit(const std::string &line) {
+				if (collect_crit)
+					str::format::append_list(list_crit, line);
+				if (collect_problem)
+					str::format::append_list(list_problem, line);
 				count_crit++;
 			}
 			void matched_ok_unique() {
@@ -708,6 +736,20 @@ namespace parsers {
 				return node_type(new summary_int_variable_node<parsers::where::evaluation_context_impl<TObject> >(key, boost::bind(&generic_summary<TObject>::get_count_crit, _1)));
 			if (key == "problem_count")
 				return node_type(new summary_int_variable_node<parsers::where::evaluation_context_impl<TObject> >(key, boost::bind(&generic_summary<TObject>::get_count_problem, _1)));
+			// move_hits_* copies the match list into the crit/warn/problem lists
+			if (key == "list" || key == "match_list" || key == "lines")
+				collect_match = true;
+			else if (key == "ok_list")
+				collect_ok = true;
+			else if (key == "warn_list")
+				collect_warn = collect_match = true;
+			else if (key == "crit_list")
+				collect_crit = collect_match = true;
+			else if (key == "problem_list")
+				collect_problem = collect_match = true;
+			else if (key == "detail_list")
+				collect_ok = collect_warn = collect_crit = collect_match = true;
+
 			if (key == "list" || key == "match_list" || key == "lines")
 				return node_type(new summary_string_variable_node<parsers::where::evaluation_context_impl<TObject> >(key, boost::bind(&generic_summary<TObject>::get_list_match, _1)));
 			if (key == "ok_list")
@@ -96,6 +96,14 @@ namespace parsers {
 					return "|";
 				if (identifier == op_like)
 					return "like";
+				if (identifier == op_ne)
+					return "!=";
+				if (identifier == op_not_like)
+					return "not like";
+				if (identifier == op_regexp)
+					return "regexp";
+				if (identifier == op_not_regexp)
+					return "not regexp";
 				return "?";
 			}
 
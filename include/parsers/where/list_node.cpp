@@ -109,10 +109,19 @@ namespace parsers {
 			return false;
 		}
 		bool list_node::static_evaluate(evaluation_context errors) const {
+			bool ret = true;
 			BOOST_FOREACH(const node_type n, value_) {
-				n->static_evaluate(errors);
+				if (!n->static_evaluate(errors))
+					ret = false;
 			}
-			return true;
+			return ret;
+		}
+		std::size_t list_node::get_cost() const {
+			std::size_t ret = 0;
+			BOOST_FOREACH(const node_type n, value_) {
+				ret += n->get_cost();
+			}
+			return ret;
 		}
 		bool list_node::require_object(evaluation_context errors) const {
 			BOOST_FOREACH(const node_type n, value_) {
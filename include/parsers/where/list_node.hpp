@@ -55,6 +55,7 @@ namespace parsers {
 			bool find_performance_data(evaluation_context context, performance_collector &collector);
 			bool static_evaluate(evaluation_context context) const;
 			bool require_object(evaluation_context context) const;
+			std::size_t get_cost() const;
 		};
 	}
 }
\ No newline at end of file
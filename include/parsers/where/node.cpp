@@ -34,21 +34,21 @@
 namespace parsers {
 	namespace where {
 		std::string value_container::get_string() const {
-			if (i_value)
-				return str::xtos(*i_value);
-			if (f_value)
-				return str::xtos(*f_value);
-			if (s_value)
-				return *s_value;
+			if (kind_ == kind_int)
+				return str::xtos(number_.i);
+			if (kind_ == kind_float)
+				return str::xtos(number_.f);
+			if (kind_ == kind_string)
+				return string_;
 			throw filter_exception("Type is not string");
 		}
 		std::string value_container::get_string(std::string def) const {
-			if (i_value)
-				return str::xtos(*i_value);
-			if (f_value)
-				return str::xtos(*f_value);
-			if (s_value)
-				return *s_value;
+			if (kind_ == kind_int)
+				return str::xtos(number_.i);
+			if (kind_ == kind_float)
+				return str::xtos(number_.f);
+			if (kind_ == kind_string)
+				return string_;
 			return def;
 		}
 
@@ -252,13 +252,13 @@ namespace parsers {
 			return node_type(new int_value(1));
 		}
 
-		parsers::where::node_type factory::create_num(value_container value) {
+		parsers::where::node_type factory::create_num(const value_container &value) {
 			if (value.is(type_int))
 				return node_type(new int_value(value.get_int(0), value.is_unsure));
 			if (value.is(type_float))
 				return node_type(new float_value(value.get_float(0.0), value.is_unsure));
 			if (value.is(type_string))
-				return node_type(new string_value(value.get_string(0), value.is_unsure));
+				return node_type(new string_value(value.get_string_ref(), value.is_unsure));
 			return node_type(new int_value(0));
 		}
 	}
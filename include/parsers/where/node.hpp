@@ -22,6 +22,7 @@
 #include <string>
 #include <list>
 #include <map>
+#include <algorithm>
 
 #include <boost/shared_ptr.hpp>
 #include <boost/optional.hpp>
@@ -95,22 +96,51 @@ namespace parsers {
 			type_custom_4 = 4096 + 4
 		};
 
+		// A single (tagged) value: nil, int, float or string.
+		// Numbers are stored inline so only string values touch the string member.
 		struct NSCAPI_EXPORT value_container {
-			boost::optional<long long> i_value;
-			boost::optional<double> f_value;
-			boost::optional<std::string> s_value;
+			enum value_kind {
+				kind_nil,
+				kind_int,
+				kind_float,
+				kind_string
+			};
+		private:
+			value_kind kind_;
+			union {
+				long long i;
+				double f;
+			} number_;
+			std::string string_;
+		public:
 			bool is_unsure;
 
-			value_container() : is_unsure(false) {}
-			value_container(bool is_unsure) : is_unsure(is_unsure) {}
-			value_container(const value_container &other) : is_unsure(other.is_unsure) {
-				set_value(other);
+			value_container() : kind_(kind_nil), is_unsure(false) {
+				number_.i = 0;
+			}
+			value_container(bool is_unsure) : kind_(kind_nil), is_unsure(is_unsure) {
+				number_.i = 0;
+			}
+			value_container(const value_container &other) : kind_(other.kind_), number_(other.number_), is_unsure(other.is_unsure) {
+				if (kind_ == kind_string)
+					string_ = other.string_;
 			}
 			value_container& operator=(const value_container &other) {
+				kind_ = other.kind_;
+				number_ = other.number_;
 				is_unsure = other.is_unsure;
-				set_value(other);
+				if (kind_ == kind_string)
+					string_ = other.string_;
+				else
+					string_.clear();
 				return *this;
 			}
+			void swap(value_container &other) {
+				std::swap(kind_, other.kind_);
+				std::swap(number_, other.number_);
+				std::swap(is_unsure, other.is_unsure);
+				string_.swap(other.string_);
+			}
 			static value_container create_int(long long value, bool is_unsure = false) {
 				value_container ret(is_unsure);
 				ret.set_int(value);
@@ -128,81 +158,82 @@ namespace parsers {
 			}
 			static value_container create_string(std::string value, bool is_unsure = false) {
 				value_container ret(is_unsure);
-				ret.set_string(value);
+				ret.swap_string(value);
 				return ret;
 			}
 			static value_container create_nil(bool is_unsure = false) {
 				value_container ret(is_unsure);
 				return ret;
 			}
-			void set_string(std::string value) {
-				s_value = value;
+			void set_string(const std::string &value) {
+				kind_ = kind_string;
+				string_ = value;
 			}
-			void set_string(const value_container &value) {
-				s_value = *value.s_value;
+			// Exchanges the string value with value (avoids copying strings we own)
+			void swap_string(std::string &value) {
+				kind_ = kind_string;
+				string_.swap(value);
 			}
 			void set_int(long long value) {
-				i_value = value;
-			}
-			void set_int(const value_container &value) {
-				i_value = *value.i_value;
+				kind_ = kind_int;
+				number_.i = value;
 			}
 			void set_float(double value) {
-				f_value = value;
+				kind_ = kind_float;
+				number_.f = value;
 			}
-			void set_float(const value_container &value) {
-				f_value = *value.f_value;
+			value_kind get_kind() const {
+				return kind_;
 			}
-			void set_value(const value_container &value) {
-				if (value.i_value)
-					set_int(value);
-				if (value.f_value)
-					set_float(value);
-				if (value.s_value)
-					set_string(value);
+			bool is_nil() const {
+				return kind_ == kind_nil;
 			}
 			long long get_int() const {
-				if (i_value)
-					return static_cast<long long>(*i_value);
-				if (f_value)
-					return static_cast<long long>(*f_value);
+				if (kind_ == kind_int)
+					return number_.i;
+				if (kind_ == kind_float)
+					return static_cast<long long>(number_.f);
 				throw filter_exception("Type is not int");
 			}
 			double get_float() const {
-				if (i_value)
-					return static_cast<double>(*i_value);
-				if (f_value)
-					return static_cast<double>(*f_value);
+				if (kind_ == kind_int)
+					return static_cast<double>(number_.i);
+				if (kind_ == kind_float)
+					return number_.f;
 				throw filter_exception("Type is not float");
 			}
 			long long get_int(long long def) const {
-				if (i_value)
-					return *i_value;
-				if (f_value)
-					return *f_value;
+				if (kind_ == kind_int)
+					return number_.i;
+				if (kind_ == kind_float)
+					return static_cast<long long>(number_.f);
 				return def;
 			}
 			double get_float(double def) const {
-				if (i_value)
-					return *i_value;
-				if (f_value)
-					return *f_value;
+				if (kind_ == kind_int)
+					return static_cast<double>(number_.i);
+				if (kind_ == kind_float)
+					return number_.f;
 				return def;
 			}
 			bool is_true() const {
-				if (i_value)
-					return *i_value == 1;
+				if (kind_ == kind_int)
+					return number_.i == 1;
 				return false;
 			}
 			std::string get_string() const;
 			std::string get_string(std::string def) const;
+			// Only valid for string values (check with is(type_string) first)
+			const std::string& get_string_ref() const {
+				return string_;
+			}
 			bool is(int type) const {
 				if (type == type_int)
-					return i_value.is_initialized();
+					return kind_ == kind_int;
 				if (type == type_float)
-					return f_value.is_initialized();
+					return kind_ == kind_float;
 				if (type == type_string)
-					return s_value.is_initialized();
+					return kind_ == kind_string;
 				return false;
 			}
 		};
@@ -224,6 +255,7 @@ namespace parsers {
 		typedef boost::shared_ptr<evaluation_context_interface> evaluation_context;
 
 		struct any_node;
+		struct compiled_program;
 		typedef boost::shared_ptr<any_node> node_type;
 		typedef std::list<std::string> variable_list_type;
 
@@ -358,6 +390,16 @@ namespace parsers {
 			virtual bool require_object(evaluation_context errors) const = 0;
 			virtual bool bind(object_converter errors) = 0;
 
+			// Lowers the (typed and bound) node into a compiled program returning the slot holding the result.
+			// Nodes which cannot be lowered return false and are evaluated by the tree interpreter instead.
+			virtual bool compile(compiled_program &program, evaluation_context context, value_type type, std::size_t &slot) const {
+				return false;
+			}
+			// Rough relative cost of evaluating the node (used to run cheap and/or operands first).
+			virtual std::size_t get_cost() const {
+				return get_type() == type_string ? 4 : 1;
+			}
+
 			// Performance data functions
 			virtual bool find_performance_data(evaluation_context context, performance_collector &collector) = 0;
 			virtual perf_list_type get_performance_data(object_factory context, std::string alias, node_type warn, node_type crit, node_type minimum, node_type maximum) {
@@ -390,7 +432,7 @@ namespace parsers {
 			static NSCAPI_EXPORT node_type create_variable(object_factory factory, const std::string &name);
 			static NSCAPI_EXPORT node_type create_false();
 			static NSCAPI_EXPORT node_type create_true();
-			static NSCAPI_EXPORT node_type create_num(value_container value);
+			static NSCAPI_EXPORT node_type create_num(const value_container &value);
 		};
 	}
 }
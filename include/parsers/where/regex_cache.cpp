@@ -0,0 +1,57 @@
+/*
+ * Copyright (C) 2004-2016 Michael Medin
+ *
+ * This file is part of NSClient++ - https://nsclient.org
+ *
+ * NSClient++ is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * NSClient++ is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with NSClient++.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <str/xtos.hpp>
+
+#include <parsers/where/regex_cache.hpp>
+
+namespace parsers {
+	namespace where {
+
+		regex_cache::regex_type regex_cache::compile(const std::string &pattern) {
+			regex_type re(new boost::regex(pattern));
+			compiles_++;
+			return re;
+		}
+
+		regex_cache::regex_type regex_cache::get(const std::string &pattern) {
+			index_type::iterator it = index_.find(pattern);
+			if (it != index_.end()) {
+				hits_++;
+				entries_.splice(entries_.begin(), entries_, it->second);
+				return it->second->second;
+			}
+			regex_type re = compile(pattern);
+			if (max_size_ == 0)
+				return re;
+			entries_.push_front(entry_type(pattern, re));
+			index_[pattern] = entries_.begin();
+			if (entries_.size() > max_size_) {
+				index_.erase(entries_.back().first);
+				entries_.pop_back();
+				evictions_++;
+			}
+			return re;
+		}
+
+		std::string regex_cache::to_string() const {
+			return "regex cache: " + str::xtos(hits_) + " hits, " + str::xtos(compiles_) + " compiles, " + str::xtos(evictions_) + " evictions, " + str::xtos(entries_.size()) + " cached";
+		}
+	}
+}
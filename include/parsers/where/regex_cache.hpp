@@ -0,0 +1,66 @@
+/*
+ * Copyright (C) 2004-2016 Michael Medin
+ *
+ * This file is part of NSClient++ - https://nsclient.org
+ *
+ * NSClient++ is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * NSClient++ is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with NSClient++.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <string>
+#include <list>
+
+#include <boost/shared_ptr.hpp>
+#include <boost/regex.hpp>
+#include <boost/unordered_map.hpp>
+
+#include <parsers/where/dll_defines.hpp>
+
+namespace parsers {
+	namespace where {
+
+		// Bounded LRU of compiled regular expressions.
+		// Not thread safe: each engine owns its own cache.
+		struct NSCAPI_EXPORT regex_cache {
+			typedef boost::shared_ptr<const boost::regex> regex_type;
+
+			regex_cache(std::size_t max_size = 32) : max_size_(max_size), hits_(0), compiles_(0), evictions_(0) {}
+
+			// Compiles a pattern (used for constant patterns which are owned by the caller). Throws boost::regex_error.
+			regex_type compile(const std::string &pattern);
+			// Returns a cached pattern compiling (and caching) it if missing. Throws boost::regex_error.
+			regex_type get(const std::string &pattern);
+
+			std::size_t size() const { return entries_.size(); }
+			unsigned long long get_hits() const { return hits_; }
+			unsigned long long get_compiles() const { return compiles_; }
+			unsigned long long get_evictions() const { return evictions_; }
+			std::string to_string() const;
+
+		private:
+			typedef std::pair<std::string, regex_type> entry_type;
+			typedef std::list<entry_type> entry_list;
+			typedef boost::unordered_map<std::string, entry_list::iterator> index_type;
+
+			std::size_t max_size_;
+			entry_list entries_;
+			index_type index_;
+			unsigned long long hits_;
+			unsigned long long compiles_;
+			unsigned long long evictions_;
+		};
+		typedef boost::shared_ptr<regex_cache> regex_cache_type;
+	}
+}
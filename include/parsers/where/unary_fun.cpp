@@ -21,6 +21,7 @@
 
 #include <parsers/where/unary_fun.hpp>
 #include <parsers/where/helpers.hpp>
+#include <parsers/where/compiler.hpp>
 
 #include <boost/foreach.hpp>
 
@@ -96,6 +97,14 @@ namespace parsers {
 			return subject->require_object(context);
 		}
 
+		bool unary_fun::compile(compiled_program &program, evaluation_context context, value_type type, std::size_t &slot) const {
+			// Unit conversions of constants (i.e. 5m, -7d) are computed once
+			return program.fold_constant(this, context, type, slot);
+		}
+		std::size_t unary_fun::get_cost() const {
+			return subject->get_cost() + 2;
+		}
+
 		bool unary_fun::is_transparent(value_type) const {
 			if (name == "neg")
 				return true;
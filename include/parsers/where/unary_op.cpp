@@ -18,6 +18,7 @@
  */
 
 #include <parsers/where/unary_op.hpp>
+#include <parsers/where/compiler.hpp>
 #include <parsers/operators.hpp>
 #include <parsers/where/helpers.hpp>
 
@@ -69,5 +70,20 @@ namespace parsers {
 		bool unary_op::require_object(evaluation_context errors) const {
 			return subject->require_object(errors);
 		}
+		bool unary_op::compile(compiled_program &program, evaluation_context context, value_type type, std::size_t &slot) const {
+			if (program.fold_constant(this, context, type, slot))
+				return true;
+			// Only boolean not is lowered (the numeric and date negations are left to the tree)
+			if (op != op_not || type != type_int || subject->get_type() != type_bool)
+				return false;
+			std::size_t lhs = 0;
+			if (!subject->compile(program, context, type_int, lhs))
+				lhs = program.emit_load(subject.get(), type_int);
+			slot = program.emit_not(lhs);
+			return true;
+		}
+		std::size_t unary_op::get_cost() const {
+			return subject->get_cost() + 1;
+		}
 	}
 }
\ No newline at end of file
@@ -40,6 +40,8 @@ namespace parsers {
 			virtual bool find_performance_data(evaluation_context context, performance_collector &collector);
 			virtual bool static_evaluate(evaluation_context context) const;
 			virtual bool require_object(evaluation_context context) const;
+			virtual bool compile(compiled_program &program, evaluation_context context, value_type type, std::size_t &slot) const;
+			virtual std::size_t get_cost() const;
 
 		private:
 			unary_op() {}
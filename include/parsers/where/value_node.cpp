@@ -20,6 +20,7 @@
 #include <str/xtos.hpp>
 
 #include <parsers/where/value_node.hpp>
+#include <parsers/where/compiler.hpp>
 
 namespace parsers {
 	namespace where {
@@ -56,6 +57,12 @@ namespace parsers {
 			collector.set_candidate_value(shared_from_this());
 			return false;
 		}
+		bool string_value::compile(compiled_program &program, evaluation_context context, value_type type, std::size_t &slot) const {
+			if (type != type_string)
+				return false;
+			slot = program.add_constant(get_value(context, type));
+			return true;
+		}
 		value_container int_value::get_value(evaluation_context errors, value_type type) const {
 			if (type == type_float) {
 				return value_container::create_float(value_, is_unsure_);
@@ -79,6 +86,12 @@ namespace parsers {
 			collector.set_candidate_value(shared_from_this());
 			return false;
 		}
+		bool int_value::compile(compiled_program &program, evaluation_context context, value_type type, std::size_t &slot) const {
+			if (type != type_int && type != type_float && type != type_string)
+				return false;
+			slot = program.add_constant(get_value(context, type));
+			return true;
+		}
 		value_container float_value::get_value(evaluation_context errors, value_type type) const {
 			if (type == type_float) {
 				return value_container::create_float(value_, is_unsure_);
@@ -99,5 +112,11 @@ namespace parsers {
 			collector.set_candidate_value(shared_from_this());
 			return false;
 		}
+		bool float_value::compile(compiled_program &program, evaluation_context context, value_type type, std::size_t &slot) const {
+			if (type != type_int && type != type_float)
+				return false;
+			slot = program.add_constant(get_value(context, type));
+			return true;
+		}
 	}
-}
\ No newline at end of file
+}
@@ -59,6 +59,9 @@ namespace parsers {
 			virtual bool require_object(evaluation_context context) const {
 				return false;
 			}
+			virtual std::size_t get_cost() const {
+				return 0;
+			}
 		};
 
 		struct string_value : public node_value_impl<std::string>, boost::enable_shared_from_this<string_value> {
@@ -73,6 +76,7 @@ namespace parsers {
 				return type_string;
 			}
 			bool find_performance_data(evaluation_context context, performance_collector &collector);
+			bool compile(compiled_program &program, evaluation_context context, value_type type, std::size_t &slot) const;
 		};
 		struct int_value : public node_value_impl<long long>, boost::enable_shared_from_this<int_value> {
 			int_value(const long long &value, bool is_unsure = false) : node_value_impl<long long>(value, type_int, is_unsure) {}
@@ -92,6 +96,7 @@ namespace parsers {
 				return type_int;
 			}
 			bool find_performance_data(evaluation_context context, performance_collector &collector);
+			bool compile(compiled_program &program, evaluation_context context, value_type type, std::size_t &slot) const;
 		};
 		struct float_value : public node_value_impl<double>, boost::enable_shared_from_this<float_value> {
 			float_value(const double &value, bool is_unsure = false) : node_value_impl<double>(value, type_float, is_unsure) {}
@@ -112,6 +117,7 @@ namespace parsers {
 				return type_float;
 			}
 			bool find_performance_data(evaluation_context context, performance_collector &collector);
+			bool compile(compiled_program &program, evaluation_context context, value_type type, std::size_t &slot) const;
 		};
 	}
 }
\ No newline at end of file
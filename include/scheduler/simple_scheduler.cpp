@@ -43,6 +43,9 @@ namespace simple_scheduler {
 	volatile boost::uint32_t metric_count = 0;
 	volatile boost::uint32_t metric_max_time = 0;
 	volatile boost::uint32_t metric_start = 0;
+	volatile boost::uint32_t metric_lag_time = 0;
+	volatile boost::uint32_t metric_lag_count = 0;
+	volatile boost::uint32_t metric_lag_max = 0;
 	using namespace boost::interprocess::ipcdetail;
 	inline void my_atomic_add(volatile boost::uint32_t *mem, boost::uint32_t value) {
 		boost::uint32_t old, c(atomic_read32(mem));
@@ -50,6 +53,12 @@ namespace simple_scheduler {
 			c = old;
 		}
 	}
+	inline void my_atomic_max(volatile boost::uint32_t *mem, boost::uint32_t value) {
+		boost::uint32_t old, c(atomic_read32(mem));
+		while (c < value && (old = atomic_cas32(mem, value, c)) != c) {
+			c = old;
+		}
+	}
 #else
 	volatile int metric_executed = 0;
 	volatile int metric_compleated = 0;
@@ -58,11 +67,70 @@ namespace simple_scheduler {
 	volatile long long metric_count = 0;
 	volatile long long metric_max_time = 0;
 	volatile int metric_start = 0;
+	volatile int metric_lag_time = 0;
+	volatile int metric_lag_count = 0;
+	volatile int metric_lag_max = 0;
 	int atomic_inc32(volatile int *i) { return 0;  }
 	int atomic_read32(volatile int *i) { return 0; }
 	void my_atomic_add(volatile int *i, int j) { }
+	void my_atomic_max(volatile int *i, int j) { }
 #endif
 
+	boost::uint64_t timer_wheel::get_tick(boost::posix_time::ptime time) const {
+		boost::int64_t offset = (time - start_).total_microseconds();
+		if (offset < 0)
+			return 0;
+		return offset / resolution_;
+	}
+
+	void timer_wheel::add(const schedule_instance &instance, boost::posix_time::ptime now) {
+		if (size_ == 0) {
+			// Nothing was scheduled so the wheel has not been advanced while we were idle
+			boost::uint64_t now_tick = get_tick(now);
+			if (now_tick > current_)
+				current_ = now_tick;
+		}
+		// Round up so nothing runs before its time (a cron schedule would otherwise find the same time again)
+		boost::uint64_t tick = get_tick(instance.time + boost::posix_time::microseconds(resolution_ - 1));
+		if (tick < current_)
+			tick = current_;
+		entry e;
+		e.instance = instance;
+		e.rounds = (tick - current_) / slots_.size();
+		slots_[tick % slots_.size()].push_back(e);
+		size_++;
+	}
+
+	void timer_wheel::advance(boost::posix_time::ptime now, std::list<schedule_instance> &due) {
+		boost::uint64_t target = get_tick(now);
+		while (current_ <= target && size_ > 0) {
+			slot_type &slot = slots_[current_ % slots_.size()];
+			for (slot_type::iterator it = slot.begin(); it != slot.end();) {
+				if (it->rounds == 0) {
+					due.push_back(it->instance);
+					it = slot.erase(it);
+					size_--;
+				} else {
+					it->rounds--;
+					++it;
+				}
+			}
+			current_++;
+		}
+		if (size_ == 0 && current_ <= target)
+			current_ = target + 1;
+	}
+
+	boost::posix_time::ptime timer_wheel::next_tick() const {
+		// Skip empty slots so we only wake up when something might be due (or once per revolution)
+		boost::uint64_t tick = current_;
+		for (; tick < current_ + slots_.size(); tick++) {
+			if (!slots_[tick % slots_.size()].empty())
+				break;
+		}
+		return start_ + boost::posix_time::microseconds(tick * resolution_);
+	}
+
 	bool scheduler::has_metrics() const {
 #if BOOST_VERSION >= 105300
 		return true;
@@ -85,7 +153,18 @@ namespace simple_scheduler {
 		return thread_count_;
 	}
 	std::size_t scheduler::get_metric_ql() {
-		return queue_.size();
+		boost::mutex::scoped_lock l(queue_mutex_);
+		return wheel_.size() + ready_.size();
+	}
+	int scheduler::get_metric_lag() const {
+		boost::uint32_t c = atomic_read32(&metric_lag_count);
+		if (c == 0) {
+			return 0;
+		}
+		return atomic_read32(&metric_lag_time) / c;
+	}
+	int scheduler::get_metric_max_lag() const {
+		return atomic_read32(&metric_lag_max);
 	}
 	int scheduler::get_avg_time() const {
 		boost::uint32_t t = atomic_read32(&metric_time);
@@ -125,6 +204,7 @@ namespace simple_scheduler {
 		running_ = false;
 		stop_requested_ = true;
 		has_watchdog_ = false;
+		has_timer_ = false;
 		threads_.interruptThreads();
 	}
 	void scheduler::stop() {
@@ -132,8 +212,15 @@ namespace simple_scheduler {
 		running_ = false;
 		stop_requested_ = true;
 		has_watchdog_ = false;
+		has_timer_ = false;
 		threads_.interruptThreads();
 		threads_.waitForThreads();
+		{
+			// Instances handed to the executor refer to us so we have to wait for them
+			boost::unique_lock<boost::mutex> lock(queue_mutex_);
+			while (in_flight_ > 0)
+				in_flight_cond_.wait(lock);
+		}
 		log_trace(__FILE__, __LINE__, "Thread pool contains: " + str::xtos(threads_.threadCount()));
 	}
 
@@ -147,6 +234,16 @@ namespace simple_scheduler {
 		reschedule(item, now());
 		return item.id;
 	}
+	int scheduler::add_task(std::string tag, boost::posix_time::time_duration duration, boost::posix_time::time_duration phase) {
+		task item(tag, duration, phase);
+		{
+			boost::mutex::scoped_lock l(mutex_);
+			item.id = ++schedule_id_;
+			tasks_[item.id] = item;
+		}
+		reschedule(item, now());
+		return item.id;
+	}
 	int scheduler::add_task(std::string tag, cron_parser::schedule schedule) {
 		task item(tag, schedule);
 		{
@@ -159,8 +256,10 @@ namespace simple_scheduler {
 	}
 	void scheduler::remove_task(int id) {
 		boost::mutex::scoped_lock l(mutex_);
+		// Instances already in the wheel are dropped when they are due.
 		tasks_list_type::iterator it = tasks_.find(id);
-		tasks_.erase(it);
+		if (it != tasks_.end())
+			tasks_.erase(it);
 	}
 	scheduler::op_task_object scheduler::get_task(int id) {
 		boost::mutex::scoped_lock l(mutex_);
@@ -178,19 +277,24 @@ namespace simple_scheduler {
 
 
 	void scheduler::watch_dog(int id) {
-		schedule_queue_type::value_type instance;
 		bool maximum_threads_reached = false;
 		while (!stop_requested_) {
 			try {
 				try {
-					instance = queue_.top();
-					if (instance) {
-						boost::posix_time::time_duration off = now() - (*instance).time;
+					boost::optional<boost::posix_time::ptime> oldest;
+					{
+						boost::mutex::scoped_lock l(queue_mutex_);
+						if (!ready_.empty())
+							oldest = ready_.front().time;
+					}
+					if (oldest) {
+						boost::posix_time::time_duration off = now() - *oldest;
 						if (off.total_seconds() > 5) {
-							if (thread_count_ < 10) {
+							if (thread_count_ < max_threads_) {
 								thread_count_++;
+								start_threads();
 							}  else if (!maximum_threads_reached) {
-								log_error(__FILE__, __LINE__, "Auto-scaling of scheduler failed (maximum of 10 threads reached) you need to manually configure threads to resolve items running slow");
+								log_error(__FILE__, __LINE__, "Auto-scaling of scheduler failed (maximum of " + str::xtos(max_threads_) + " threads reached) you need to manually configure threads to resolve items running slow");
 								maximum_threads_reached = true;
 							}
 						}
@@ -215,68 +319,62 @@ namespace simple_scheduler {
 		log_trace(__FILE__, __LINE__, "Terminating thread: " + str::xtos(id));
 	}
 
-	void scheduler::thread_proc(int id) {
+	void scheduler::timer_proc(int id) {
 		try {
-			schedule_queue_type::value_type instance;
 			while (!stop_requested_) {
-				instance = queue_.pop();
-				if (!instance) {
-					boost::unique_lock<boost::mutex> lock(idle_thread_mutex_);
-					idle_thread_cond_.wait(lock);
-					continue;
-				}
-
-				try {
-					boost::posix_time::time_duration off = now() - (*instance).time;
-					if (off.total_seconds() > error_threshold_) {
-						log_error(__FILE__, __LINE__, "Ran scheduled item " + str::xtos(instance->schedule_id) + " " + str::xtos(off.total_seconds()) + " seconds to late from thread " + str::xtos(id));
-					}
-					boost::thread::sleep((*instance).time);
-				} catch (const boost::thread_interrupted &) {
-					if (!queue_.push(*instance))
-						log_error(__FILE__, __LINE__, "Failed to push item");
-					if (stop_requested_) {
-						log_trace(__FILE__, __LINE__, "Terminating thread: " + str::xtos(id));
-						return;
-					}
-					continue;
-				} catch (...) {
-					if (!queue_.push(*instance)) {
-						atomic_inc32(&metric_errors);
-						log_error(__FILE__, __LINE__, "Failed to push item");
+				std::list<schedule_instance> due;
+				{
+					boost::unique_lock<boost::mutex> lock(queue_mutex_);
+					if (wheel_.empty())
+						timer_cond_.wait(lock);
+					else
+						timer_cond_.timed_wait(lock, wheel_.next_tick());
+					wheel_.advance(now(), due);
+					if (executor_) {
+						for (std::list<schedule_instance>::iterator it = due.begin(); it != due.end();) {
+							in_flight_++;
+							if (executor_(boost::bind(&scheduler::execute_shared, this, *it))) {
+								it = due.erase(it);
+							} else {
+								// The pool is not running (i.e. the core is shutting down) so the item stays queued until we are stopped
+								in_flight_--;
+								++it;
+							}
+						}
 					}
-					continue;
+					ready_.insert(ready_.end(), due.begin(), due.end());
 				}
+				if (due.size() == 1)
+					ready_cond_.notify_one();
+				else if (!due.empty())
+					ready_cond_.notify_all();
+			}
+		} catch (const boost::thread_interrupted &e) {
+		} catch (const std::exception &e) {
+			atomic_inc32(&metric_errors);
+			log_error(__FILE__, __LINE__, "Exception in scheduler timer (thread will be killed): " + utf8::utf8_from_native(e.what()));
+		} catch (...) {
+			atomic_inc32(&metric_errors);
+			log_error(__FILE__, __LINE__, "Exception in scheduler timer (thread will be killed)");
+		}
+		log_trace(__FILE__, __LINE__, "Terminating thread: " + str::xtos(id));
+	}
 
-				boost::posix_time::ptime now_time = now();
-				atomic_inc32(&metric_executed);
-				op_task_object item = get_task((*instance).schedule_id);
-				if (item) {
-					try {
-						bool to_reschedule = false;
-						if (handler_) {
-							to_reschedule = handler_->handle_schedule(*item);
-						}
-						boost::posix_time::time_duration duration = now() - now_time;
-
-						my_atomic_add(&metric_time, duration.total_milliseconds());
-						atomic_inc32(&metric_count);
-						if (to_reschedule) {
-							reschedule(*item, now_time);
-							atomic_inc32(&metric_compleated);
-						} else {
-							atomic_inc32(&metric_errors);
-							log_trace(__FILE__, __LINE__, "Abandoning: " + item->to_string());
-						}
-					} catch (...) {
-						atomic_inc32(&metric_errors);
-						log_error(__FILE__, __LINE__, "UNKNOWN ERROR RUNING TASK: " + item->tag);
-						reschedule(*item, now_time);
-					}
-				} else {
-					atomic_inc32(&metric_errors);
-					log_error(__FILE__, __LINE__, "Task not found: " + str::xtos(instance->schedule_id));
+	void scheduler::thread_proc(int id) {
+		try {
+			while (!stop_requested_) {
+				schedule_instance instance;
+				{
+					boost::unique_lock<boost::mutex> lock(queue_mutex_);
+					while (ready_.empty() && !stop_requested_)
+						ready_cond_.wait(lock);
+					if (stop_requested_)
+						break;
+					instance = ready_.front();
+					ready_.pop_front();
 				}
+
+				execute(instance, id);
 			}
 		} catch (const boost::thread_interrupted &e) {
 		} catch (const std::exception &e) {
@@ -289,7 +387,60 @@ namespace simple_scheduler {
 		log_trace(__FILE__, __LINE__, "Terminating thread: " + str::xtos(id));
 	}
 
+	void scheduler::execute(const schedule_instance &instance, int id) {
+		boost::posix_time::ptime now_time = now();
+		boost::posix_time::time_duration off = now_time - instance.time;
+		if (!off.is_negative()) {
+			my_atomic_add(&metric_lag_time, off.total_milliseconds());
+			atomic_inc32(&metric_lag_count);
+			my_atomic_max(&metric_lag_max, off.total_milliseconds());
+		}
+		if (off.total_seconds() > error_threshold_) {
+			log_error(__FILE__, __LINE__, "Ran scheduled item " + str::xtos(instance.schedule_id) + " " + str::xtos(off.total_seconds()) + " seconds to late from thread " + str::xtos(id));
+		}
+
+		op_task_object item = get_task(instance.schedule_id);
+		if (!item) {
+			log_trace(__FILE__, __LINE__, "Dropping removed task: " + str::xtos(instance.schedule_id));
+			return;
+		}
+		atomic_inc32(&metric_executed);
+		try {
+			bool to_reschedule = false;
+			if (handler_) {
+				to_reschedule = handler_->handle_schedule(*item);
+			}
+			boost::posix_time::time_duration duration = now() - now_time;
+
+			my_atomic_add(&metric_time, duration.total_milliseconds());
+			atomic_inc32(&metric_count);
+			if (to_reschedule) {
+				reschedule(*item, now_time);
+				atomic_inc32(&metric_compleated);
+			} else {
+				atomic_inc32(&metric_errors);
+				log_trace(__FILE__, __LINE__, "Abandoning: " + item->to_string());
+			}
+		} catch (...) {
+			atomic_inc32(&metric_errors);
+			log_error(__FILE__, __LINE__, "UNKNOWN ERROR RUNING TASK: " + item->tag);
+			reschedule(*item, now_time);
+		}
+	}
 
+	void scheduler::execute_shared(const schedule_instance instance) {
+		if (!stop_requested_) {
+			try {
+				execute(instance, 0);
+			} catch (...) {
+				atomic_inc32(&metric_errors);
+				log_error(__FILE__, __LINE__, "Exception in scheduled item: " + str::xtos(instance.schedule_id));
+			}
+		}
+		boost::mutex::scoped_lock lock(queue_mutex_);
+		if (--in_flight_ == 0)
+			in_flight_cond_.notify_all();
+	}
 
 	void scheduler::reschedule(const task &item, boost::posix_time::ptime now_time) {
 		if (item.is_disabled()) {
@@ -302,10 +453,11 @@ namespace simple_scheduler {
 		schedule_instance instance;
 		instance.schedule_id = id;
 		instance.time = new_time;
-		if (!queue_.push(instance)) {
-			log_error(__FILE__, __LINE__, "Failed to reschedule item");
+		{
+			boost::mutex::scoped_lock l(queue_mutex_);
+			wheel_.add(instance, now());
 		}
-		idle_thread_cond_.notify_one();
+		timer_cond_.notify_one();
 	}
 
 	void scheduler::start_threads() {
@@ -313,7 +465,8 @@ namespace simple_scheduler {
 			return;
 		stop_requested_ = false;
 		std::size_t missing_threads = 0;
-		if (thread_count_ > threads_.threadCount())
+		// With a shared pool we only need the timer (and watchdog)
+		if (!executor_ && thread_count_ > threads_.threadCount())
 			missing_threads = thread_count_ - threads_.threadCount();
 		if (missing_threads > 0 && missing_threads <= thread_count_) {
 			for (std::size_t i = 0; i < missing_threads; i++) {
@@ -326,5 +479,10 @@ namespace simple_scheduler {
 			boost::function<void()> f = boost::bind(&scheduler::watch_dog, this, 0);
 			threads_.createThread(f);
 		}
+		if (!has_timer_) {
+			has_timer_ = true;
+			boost::function<void()> f = boost::bind(&scheduler::timer_proc, this, 1);
+			threads_.createThread(f);
+		}
 	}
 }
\ No newline at end of file
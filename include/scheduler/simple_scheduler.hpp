@@ -20,7 +20,8 @@
 #pragma once
 #include <string>
 #include <list>
-#include <queue>
+#include <deque>
+#include <vector>
 
 #include <boost/date_time.hpp>
 #include <boost/date_time/posix_time/ptime.hpp>
@@ -31,6 +32,7 @@
 #include <boost/unordered_map.hpp>
 #include <boost/thread/shared_mutex.hpp>
 #include <boost/function.hpp>
+#include <boost/cstdint.hpp>
 
 #include <has-threads.hpp>
 
@@ -47,10 +49,13 @@ namespace simple_scheduler {
 		bool has_duration;
 		bool has_schedule;
 		double randomeness;
+		// When set the task runs at a fixed offset into each interval (counted from the epoch) instead of at a random delay.
+		boost::optional<boost::posix_time::time_duration> phase;
 
 	public:
 		task() : id(0), duration(boost::posix_time::seconds(0)), has_duration(false), has_schedule(false), randomeness(0.0) {}
 		task(std::string tag, boost::posix_time::time_duration duration, double randomeness) : id(0), tag(tag), duration(duration), has_duration(true), has_schedule(false), randomeness(randomeness) {}
+		task(std::string tag, boost::posix_time::time_duration duration, boost::posix_time::time_duration phase) : id(0), tag(tag), duration(duration), has_duration(true), has_schedule(false), randomeness(0.0), phase(phase) {}
 		task(std::string tag, cron_parser::schedule schedule) : id(0), tag(tag), schedule(schedule), has_duration(false), has_schedule(true), randomeness(0.0) {}
 
 		bool is_disabled() const {
@@ -59,7 +64,9 @@ namespace simple_scheduler {
 		std::string to_string() const {
 			std::stringstream ss;
 			ss << id << "[" << tag << "] = ";
-			if (has_duration)
+			if (has_duration && phase)
+				ss << duration.total_seconds() << " at +" << phase->total_seconds();
+			else if (has_duration)
 				ss << duration.total_seconds() << " " << (randomeness*100) << "% randomness";
 			else if (has_schedule)
 				ss << schedule.to_string();
@@ -68,6 +75,14 @@ namespace simple_scheduler {
 			return ss.str();
 		}
 		boost::posix_time::ptime get_next(boost::posix_time::ptime now_time) const {
+			if (has_duration && duration.total_seconds() > 0 && phase) {
+				// The next slot after now which is phase into an interval (so the time is the same regardless of when we started)
+				boost::posix_time::ptime epoch(boost::gregorian::date(1970, 1, 1));
+				long long interval = duration.total_seconds();
+				long long offset = (now_time - epoch).total_seconds() - phase->total_seconds();
+				long long next = (offset / interval + 1) * interval + phase->total_seconds();
+				return epoch + boost::posix_time::seconds(static_cast<long>(next));
+			}
 			if (has_duration && duration.total_seconds() > 0) {
 				double total_delay = duration.total_seconds();
 				double val = (total_delay * randomeness) * (static_cast<double>(rand()) / static_cast<double>(RAND_MAX));
@@ -98,79 +113,79 @@ namespace simple_scheduler {
 		}
 	};
 
-	template<typename T>
-	class safe_schedule_queue {
-	public:
-		typedef boost::optional<T> value_type;
-	private:
-		typedef std::priority_queue<T> schedule_queue_type;
-		schedule_queue_type queue_;
-		boost::shared_mutex mutex_;
-	public:
-		bool empty(unsigned int timeout = 5) {
-			boost::shared_lock<boost::shared_mutex> lock(mutex_, boost::get_system_time() + boost::posix_time::seconds(timeout));
-			if (!lock.owns_lock())
-				return false;
-			return queue_.empty();
-		}
+	// A hashed timing wheel: instances are put in the slot for their tick and carry the number of revolutions left.
+	// Adding is O(1) and advancing only touches the instances in the slots which have passed.
+	// Not thread safe (the scheduler protects it with its queue mutex).
+	class timer_wheel {
+		struct entry {
+			schedule_instance instance;
+			boost::uint64_t rounds;
+		};
+		typedef std::list<entry> slot_type;
+
+		std::vector<slot_type> slots_;
+		boost::posix_time::ptime start_;
+		boost::int64_t resolution_;
+		boost::uint64_t current_;
+		std::size_t size_;
 
-		boost::optional<T> top(unsigned int timeout = 5) {
-			boost::shared_lock<boost::shared_mutex> lock(mutex_, boost::get_system_time() + boost::posix_time::seconds(timeout));
-			if (!lock || queue_.empty())
-				return boost::optional<T>();
-			return boost::optional<T>(queue_.top());
-		}
+	public:
+		timer_wheel(std::size_t slots, boost::posix_time::time_duration resolution, boost::posix_time::ptime start)
+			: slots_(slots), start_(start), resolution_(resolution.total_microseconds()), current_(0), size_(0) {}
 
-		std::size_t size(unsigned int timeout = 5) {
-			boost::shared_lock<boost::shared_mutex> lock(mutex_, boost::get_system_time() + boost::posix_time::seconds(timeout));
-			if (!lock || queue_.empty())
-				return 0;
-			return queue_.size();
-		}
+		void add(const schedule_instance &instance, boost::posix_time::ptime now);
+		// Moves all instances which are due at now to due (ordered by tick).
+		void advance(boost::posix_time::ptime now, std::list<schedule_instance> &due);
+		// When the next non empty slot should be processed.
+		boost::posix_time::ptime next_tick() const;
 
-		boost::optional<T> pop(unsigned int timeout = 5) {
-			boost::unique_lock<boost::shared_mutex> lock(mutex_, boost::get_system_time() + boost::posix_time::seconds(timeout));
-			if (!lock || queue_.empty())
-				return boost::optional<T>();
-			boost::optional<T>  ret = queue_.top();
-			queue_.pop();
-			return ret;
-		}
+		std::size_t size() const { return size_; }
+		bool empty() const { return size_ == 0; }
 
-		bool push(T instance, unsigned int timeout = 5) {
-			boost::unique_lock<boost::shared_mutex> lock(mutex_, boost::get_system_time() + boost::posix_time::seconds(timeout));
-			if (!lock) {
-				return false;
-			}
-			queue_.push(instance);
-			return true;
-		}
+	private:
+		boost::uint64_t get_tick(boost::posix_time::ptime time) const;
 	};
 
 	class scheduler : public boost::noncopyable {
+	public:
+		typedef boost::function<void()> work_type;
+		// Runs work on a shared pool (returns false if the work was not accepted).
+		typedef boost::function<bool(work_type)> executor_type;
 	private:
 		typedef boost::unordered_map<int, task> tasks_list_type;
 		typedef boost::optional<task> op_task_object;
-		typedef safe_schedule_queue<schedule_instance> schedule_queue_type;
+		typedef std::deque<schedule_instance> ready_queue_type;
 
 		// thread variables
 		unsigned int schedule_id_;
 		volatile bool stop_requested_;
 		volatile bool running_;
 		volatile bool has_watchdog_;
+		volatile bool has_timer_;
 		std::size_t thread_count_;
+		std::size_t max_threads_;
 		handler* handler_;
 		int error_threshold_;
 
 		has_threads threads_;
 		boost::mutex mutex_;
 		tasks_list_type tasks_;
-		schedule_queue_type queue_;
-		boost::mutex idle_thread_mutex_;
-		boost::condition_variable idle_thread_cond_;
+
+		// The timer thread moves due instances from the wheel to the ready queue which the workers consume.
+		boost::mutex queue_mutex_;
+		boost::condition_variable timer_cond_;
+		boost::condition_variable ready_cond_;
+		timer_wheel wheel_;
+		ready_queue_type ready_;
+
+		// When set due instances are handed to the executor instead of our own workers.
+		executor_type executor_;
+		std::size_t in_flight_;
+		boost::condition_variable in_flight_cond_;
 	public:
 
-		scheduler() : schedule_id_(0), stop_requested_(false), running_(false), has_watchdog_(false), thread_count_(10), handler_(NULL), error_threshold_(5) {}
+		scheduler() : schedule_id_(0), stop_requested_(false), running_(false), has_watchdog_(false), has_timer_(false), thread_count_(10), max_threads_(10), handler_(NULL), error_threshold_(5)
+			, wheel_(4096, boost::posix_time::milliseconds(10), boost::get_system_time()), in_flight_(0) {}
 		~scheduler() {}
 
 		void set_handler(handler* handler) {
@@ -189,11 +204,14 @@ namespace simple_scheduler {
 		int get_metric_errors() const;
 		int get_avg_time() const;
 		int get_metric_rate() const;
+		int get_metric_lag() const;
+		int get_metric_max_lag() const;
 		std::size_t get_metric_threads() const;
 		std::size_t get_metric_ql();
 		bool has_metrics() const;
 
 		int add_task(std::string tag, boost::posix_time::time_duration duration, double randomness);
+		int add_task(std::string tag, boost::posix_time::time_duration duration, boost::posix_time::time_duration phase);
 		int add_task(std::string tag, cron_parser::schedule schedule);
 		void remove_task(int id);
 		op_task_object get_task(int id);
@@ -206,14 +224,27 @@ namespace simple_scheduler {
 
 		void set_threads(int threads) {
 			thread_count_ = threads;
+			if (max_threads_ < thread_count_)
+				max_threads_ = thread_count_;
 			start_threads();
 		}
 		int get_threads() const { return thread_count_; }
+		// The number of threads the watchdog is allowed to grow the pool to when items are running late.
+		void set_max_threads(int threads) {
+			max_threads_ = threads < thread_count_ ? thread_count_ : threads;
+		}
+		// Must be set before the scheduler is started.
+		void set_executor(executor_type executor) {
+			executor_ = executor;
+		}
 
 	private:
 
 		void watch_dog(int id);
+		void timer_proc(int id);
 		void thread_proc(int id);
+		void execute(const schedule_instance &instance, int id);
+		void execute_shared(const schedule_instance instance);
 
 
 		void reschedule(const task &item, boost::posix_time::ptime now_time);
@@ -20,9 +20,12 @@
 #pragma once
 
 #include <boost/shared_ptr.hpp>
+#include <boost/thread/mutex.hpp>
 
 #include <socket/socket_helpers.hpp>
 #include <iostream>
+#include <list>
+#include <map>
 
 using boost::asio::ip::tcp;
 
@@ -119,6 +122,10 @@ namespace socket_helpers {
 				return boost::optional<typename protocol_type::response_type>(protocol_.get_response());
 			}
 
+			bool is_open() {
+				return get_socket().is_open();
+			}
+
 			virtual void shutdown() {
 				trace("shutdown()");
 				cancel_timer();
@@ -255,11 +262,14 @@ namespace socket_helpers {
 		private:
 			typedef connection<protocol_type> connection_type;
 			boost::asio::ssl::stream<tcp::socket> ssl_socket_;
+			std::string session_options_;
+			std::string session_key_;
 
 		public:
-			ssl_connection(boost::asio::io_service &io_service, boost::asio::ssl::context &context, boost::posix_time::time_duration timeout, boost::shared_ptr<typename protocol_type::client_handler> handler)
+			ssl_connection(boost::asio::io_service &io_service, boost::asio::ssl::context &context, const std::string &session_options, boost::posix_time::time_duration timeout, boost::shared_ptr<typename protocol_type::client_handler> handler)
 				: connection_type(io_service, timeout, handler)
-				, ssl_socket_(io_service, context) {}
+				, ssl_socket_(io_service, context)
+				, session_options_(session_options) {}
 			virtual ~ssl_connection() {
 				try {
 					this->close_socket();
@@ -276,14 +286,28 @@ namespace socket_helpers {
 					this->log_error(__FILE__, __LINE__, "Failed to connect to server: " + utf8::utf8_from_native(error.message()));
 				}
 				if (!error) {
+					session_key_ = host + ":" + port + "|" + session_options_;
+					socket_helpers::restore_client_session(session_key_, ssl_socket_.native_handle());
 					ssl_socket_.handshake(boost::asio::ssl::stream_base::client, error);
 					if (error) {
 						this->log_error(__FILE__, __LINE__, "SSL handshake failed: " + utf8::utf8_from_native(error.message()));
+						session_key_.clear();
 					}
 				}
 				return error;
 			}
 
+			// The session is saved when we are done since TLS 1.3 servers send the ticket after the handshake.
+			// OpenSSL drops sessions which were not shut down so we mark it as such (we do not wait for the close_notify).
+			virtual void close_socket() {
+				if (!session_key_.empty() && this->get_socket().is_open()) {
+					SSL_set_shutdown(ssl_socket_.native_handle(), SSL_SENT_SHUTDOWN | SSL_RECEIVED_SHUTDOWN);
+					socket_helpers::store_client_session(session_key_, ssl_socket_.native_handle());
+				}
+				session_key_.clear();
+				connection_type::close_socket();
+			}
+
 			virtual void start_read_request(boost::asio::mutable_buffers_1 buffer) {
 				this->trace("ssl::start_read_request()");
 				async_read(ssl_socket_, buffer,
@@ -307,8 +331,10 @@ namespace socket_helpers {
 		class client : boost::noncopyable {
 			boost::shared_ptr<connection<protocol_type> > connection_;
 			boost::asio::io_service io_service_;
-			const socket_helpers::connection_info &info_;
+			// A copy since pooled clients outlive the request they were created for
+			const socket_helpers::connection_info info_;
 			boost::shared_ptr<typename protocol_type::client_handler> handler_;
+			bool keep_alive_;
 
 			typedef connection<protocol_type> connection_type;
 			typedef tcp_connection<protocol_type> tcp_connection_type;
@@ -319,7 +345,7 @@ namespace socket_helpers {
 
 		public:
 			client(const socket_helpers::connection_info &info, typename boost::shared_ptr<typename protocol_type::client_handler> handler)
-				: info_(info), handler_(handler)
+				: info_(info), handler_(handler), keep_alive_(false)
 #ifdef USE_SSL
 				, context_(io_service_, boost::asio::ssl::context::sslv23)
 #endif
@@ -335,6 +361,7 @@ namespace socket_helpers {
 			}
 
 			void connect() {
+				keep_alive_ = false;
 				connection_.reset(create_connection());
 				boost::system::error_code error = connection_->connect(info_.get_address(), info_.get_port());
 				if (error) {
@@ -353,7 +380,7 @@ namespace socket_helpers {
 					BOOST_FOREACH(const std::string &e, errors) {
 						handler_->log_error(__FILE__, __LINE__, e);
 					}
-					return new ssl_connection_type(io_service_, context_, timeout, handler_);
+					return new ssl_connection_type(io_service_, context_, info_.ssl.get_session_key(), timeout, handler_);
 				}
 #endif
 				return new tcp_connection_type(io_service_, timeout, handler_);
@@ -377,9 +404,121 @@ namespace socket_helpers {
 				return *response;
 			}
 			void shutdown() {
-				connection_->shutdown();
+				keep_alive_ = false;
+				if (connection_)
+					connection_->shutdown();
 				connection_.reset();
 			};
+
+			enum keep_alive_result {
+				keep_alive_accepted,
+				keep_alive_refused,
+				keep_alive_failed
+			};
+			// Asks the server to keep the connection open between requests (the request and reply are protocol specific).
+			// Refused means the server answered something else, failed that there was no answer (timeout or closed connection).
+			keep_alive_result negotiate_keep_alive(typename protocol_type::request_type &request) {
+				if (!connection_)
+					connect();
+				boost::optional<typename protocol_type::response_type> response = connection_->process_request(request);
+				if (response && protocol_type::is_keep_alive_response(*response)) {
+					keep_alive_ = true;
+					return keep_alive_accepted;
+				}
+				shutdown();
+				if (response && !response->empty())
+					return keep_alive_refused;
+				return keep_alive_failed;
+			}
+			bool is_keep_alive() const {
+				return keep_alive_ && connection_ && connection_->is_open();
+			}
+		};
+
+		// Keeps clients whose server agreed to keep the connection open so later requests to the same server can reuse them.
+		// A client is only used by one request at a time (acquire takes it out of the pool, release puts it back).
+		template<class protocol_type>
+		class client_pool : boost::noncopyable {
+		public:
+			typedef client<protocol_type> client_type;
+			typedef boost::shared_ptr<client_type> client_ptr;
+
+		private:
+			struct idle_client {
+				client_ptr instance;
+				boost::posix_time::ptime expires;
+			};
+			typedef std::list<idle_client> idle_list;
+			typedef std::map<std::string, idle_list> idle_map;
+
+			boost::mutex mutex_;
+			idle_map idle_;
+			// Servers which answered the keep-alive request with something else (and when to ask them again)
+			std::map<std::string, boost::posix_time::ptime> refused_;
+			std::size_t max_idle_;
+			boost::posix_time::time_duration refused_retry_;
+
+		public:
+			client_pool() : max_idle_(8), refused_retry_(boost::posix_time::minutes(5)) {}
+
+			void set_max_idle(std::size_t max_idle) {
+				max_idle_ = max_idle;
+			}
+			void set_refused_retry(unsigned int seconds) {
+				refused_retry_ = boost::posix_time::seconds(seconds);
+			}
+
+			client_ptr acquire(const std::string &key, const socket_helpers::connection_info &info, boost::shared_ptr<typename protocol_type::client_handler> handler, typename protocol_type::request_type keep_alive_request) {
+				const boost::posix_time::ptime now = boost::posix_time::second_clock::universal_time();
+				{
+					boost::mutex::scoped_lock lock(mutex_);
+					typename idle_map::iterator it = idle_.find(key);
+					while (it != idle_.end() && !it->second.empty()) {
+						idle_client c = it->second.back();
+						it->second.pop_back();
+						if (c.expires > now && c.instance->is_keep_alive())
+							return c.instance;
+					}
+					std::map<std::string, boost::posix_time::ptime>::iterator refused = refused_.find(key);
+					if (refused != refused_.end()) {
+						if (refused->second > now)
+							return client_ptr(new client_type(info, handler));
+						refused_.erase(refused);
+					}
+				}
+				client_ptr instance(new client_type(info, handler));
+				typename client_type::keep_alive_result result = instance->negotiate_keep_alive(keep_alive_request);
+				if (result == client_type::keep_alive_refused) {
+					handler->log_debug(__FILE__, __LINE__, "Keep-alive not accepted by " + info.get_endpoint_string());
+					boost::mutex::scoped_lock lock(mutex_);
+					refused_[key] = now + refused_retry_;
+				} else if (result == client_type::keep_alive_failed) {
+					handler->log_debug(__FILE__, __LINE__, "No reply to keep-alive request from " + info.get_endpoint_string());
+				}
+				return instance;
+			}
+
+			// Idle connections are dropped after idle_timeout seconds which should be less than the idle timeout of the server.
+			void release(const std::string &key, client_ptr instance, unsigned int idle_timeout) {
+				if (!instance->is_keep_alive()) {
+					instance->shutdown();
+					return;
+				}
+				idle_client c;
+				c.instance = instance;
+				c.expires = boost::posix_time::second_clock::universal_time() + boost::posix_time::seconds(idle_timeout);
+				boost::mutex::scoped_lock lock(mutex_);
+				idle_list &list = idle_[key];
+				if (list.size() >= max_idle_)
+					list.pop_front();
+				list.push_back(c);
+			}
+
+			void clear() {
+				boost::mutex::scoped_lock lock(mutex_);
+				idle_.clear();
+				refused_.clear();
+			}
 		};
 
 		struct client_handler : private boost::noncopyable {
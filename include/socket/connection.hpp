@@ -24,10 +24,16 @@
 #include <boost/noncopyable.hpp>
 #include <boost/shared_ptr.hpp>
 #include <boost/enable_shared_from_this.hpp>
+#include <boost/atomic.hpp>
+#include <boost/cstdint.hpp>
+#include <boost/function.hpp>
+#include <boost/weak_ptr.hpp>
 #ifdef USE_SSL
 #include <boost/asio/ssl/context.hpp>
 #endif
 
+#include <socket/socket_helpers.hpp>
+
 #include <utf8.hpp>
 
 namespace socket_helpers {
@@ -47,6 +53,23 @@ namespace socket_helpers {
 		// recv    | recv       | on_read    | true = read more, false = done reading
 		// ...
 		//         |            | is_done    | true = is done, disconnect, false (read/write loop)
+		//         |            | is_pending | true = wait for the protocol to resume us (through the dispatcher)
+		//
+		// A protocol which keeps the connection open goes back to wants_data after on_write.
+		// The connection then waits up to idle_timeout for the next request instead of the normal timeout.
+
+		// The buffers of a single (scatter-gather) write
+		typedef std::vector<boost::asio::const_buffer> const_buffer_list;
+
+		// Runs a function on the connection (strand) and continues processing afterwards.
+		typedef boost::function<void(boost::function<void()>)> dispatcher_type;
+
+		// TLS handshakes done by the connections of a server
+		struct handshake_counters {
+			boost::atomic<boost::uint64_t> full;
+			boost::atomic<boost::uint64_t> resumed;
+			handshake_counters() : full(0), resumed(0) {}
+		};
 
 		template<class protocol_type, std::size_t N>
 		class connection : public boost::enable_shared_from_this<connection<protocol_type, N> >, private boost::noncopyable {
@@ -54,6 +77,8 @@ namespace socket_helpers {
 		public:
 			connection(boost::asio::io_service& io_service, boost::shared_ptr<protocol_type> protocol)
 				: is_active_(true)
+				, timeout_(0)
+				, idle_timeout_(0)
 				, strand_(io_service)
 				, timer_(io_service)
 				, protocol_(protocol) {}
@@ -71,8 +96,12 @@ namespace socket_helpers {
 			// High level connection start/stop
 			virtual void start() {
 				trace("start()");
+				socket_helpers::connection_info info = protocol_->get_info();
+				timeout_ = info.timeout;
+				idle_timeout_ = info.idle_timeout;
+				protocol_->set_dispatcher(boost::bind(&connection::dispatch, boost::weak_ptr<connection_type>(this->shared_from_this()), _1));
 				if (protocol_->on_connect()) {
-					set_timeout(protocol_->get_info().timeout);
+					set_timeout(timeout_);
 					do_process();
 				} else {
 					on_done(false);
@@ -140,10 +169,19 @@ namespace socket_helpers {
 							on_done(false);
 							return;
 						}
-						//std::vector<boost::asio::const_buffer> buffers;
-						//buffers.push_back();
-						if (is_active_)
-							start_write_request(buf(protocol_->get_outbound()));
+						if (is_active_) {
+							// Everything the protocol has queued goes out in one write
+							buffers_.clear();
+							protocol_->get_outbound(buffers_);
+							const_buffer_list buffers;
+							buffers.reserve(buffers_.size());
+							BOOST_FOREACH(const socket_helpers::shared_buffer &b, buffers_) {
+								buffers.push_back(boost::asio::buffer(*b));
+							}
+							start_write_request(buffers);
+						}
+					} else if (protocol_->is_pending()) {
+						trace("s - is_pending() == true");
 					} else {
 						if (is_active_)
 							on_done(true);
@@ -155,26 +193,46 @@ namespace socket_helpers {
 				}
 			}
 
+			// The connection is gone if it timed out while the protocol was busy, in which case the result is dropped.
+			static void dispatch(boost::weak_ptr<connection_type> weak_self, boost::function<void()> fun) {
+				boost::shared_ptr<connection_type> self = weak_self.lock();
+				if (self)
+					self->strand_.post(boost::bind(&connection::resume, self, fun));
+			}
+			void resume(boost::function<void()> fun) {
+				trace("resume()");
+				fun();
+				do_process();
+			}
+
 			virtual void start_read_request() = 0;
 			virtual void handle_read_request(const boost::system::error_code& e, std::size_t bytes_transferred) {
 				trace("handle_read_request(" + utf8::utf8_from_native(e.message()) + ", " + str::xtos(bytes_transferred) + ")");
 				if (!e) {
 					if (protocol_->on_read(buffer_.begin(), buffer_.begin() + bytes_transferred)) {
+						if (idle_timeout_ > 0 && !protocol_->wants_data())
+							set_timeout(timeout_);
 						do_process();
 					} else {
 						on_done(false);
 					}
+				} else if (e == boost::asio::error::eof && idle_timeout_ > 0 && protocol_->wants_data()) {
+					// The client closed a kept alive connection
+					on_done(true);
 				} else {
 					protocol_->log_error(__FILE__, __LINE__, "Failed to read data: " + utf8::utf8_from_native(e.message()));
 					on_done(false);
 				}
 			}
 
-			virtual void start_write_request(const boost::asio::const_buffer& response) = 0;
+			virtual void start_write_request(const const_buffer_list& buffers) = 0;
 			virtual void handle_write_response(const boost::system::error_code& e, std::size_t bytes_transferred) {
 				trace("handle_write_response(" + utf8::utf8_from_native(e.message()) + ", " + str::xtos(bytes_transferred) + ")");
 				if (!e) {
+					buffers_.clear();
 					protocol_->on_write();
+					if (idle_timeout_ > 0 && protocol_->wants_data())
+						set_timeout(idle_timeout_);
 					do_process();
 				} else {
 					protocol_->log_error(__FILE__, __LINE__, "Failed to send data: " + utf8::utf8_from_native(e.message()));
@@ -186,16 +244,14 @@ namespace socket_helpers {
 			//////////////////////////////////////////////////////////////////////////
 			// Internal functions and data
 
-			boost::asio::const_buffer buf(const typename protocol_type::outbound_buffer_type s) {
-				buffers_.push_back(s);
-				return boost::asio::buffer(buffers_.back());
-			}
-
 			bool is_active_;
+			unsigned int timeout_;
+			unsigned int idle_timeout_;
 			boost::asio::io_service::strand strand_;
 			boost::array<char, N> buffer_;
 			boost::asio::deadline_timer timer_;
-			std::list<typename protocol_type::outbound_buffer_type> buffers_;
+			// Released (back to the pool) as soon as the write completes
+			socket_helpers::buffer_list buffers_;
 			boost::shared_ptr<protocol_type> protocol_;
 		};
 
@@ -227,9 +283,9 @@ namespace socket_helpers {
 						boost::bind(&parent_type::handle_read_request, this->shared_from_this(), boost::asio::placeholders::error, boost::asio::placeholders::bytes_transferred)
 						));
 			}
-			virtual void start_write_request(const boost::asio::const_buffer& response) {
-				this->trace("start_write_request(" + str::xtos(boost::asio::buffer_size(response)) + ")");
-				boost::asio::async_write(socket_, boost::asio::const_buffers_1(response), parent_type::strand_.wrap(
+			virtual void start_write_request(const const_buffer_list& buffers) {
+				this->trace("start_write_request(" + str::xtos(boost::asio::buffer_size(buffers)) + ")");
+				boost::asio::async_write(socket_, buffers, parent_type::strand_.wrap(
 					boost::bind(&parent_type::handle_write_response, this->shared_from_this(), boost::asio::placeholders::error, boost::asio::placeholders::bytes_transferred)
 					));
 			}
@@ -241,9 +297,10 @@ namespace socket_helpers {
 			typedef connection<protocol_type, N> parent_type;
 			typedef ssl_connection<protocol_type, N> my_type;
 		public:
-			ssl_connection(boost::asio::io_service& io_service, boost::asio::ssl::context &context, boost::shared_ptr<protocol_type> protocol)
+			ssl_connection(boost::asio::io_service& io_service, boost::asio::ssl::context &context, boost::shared_ptr<protocol_type> protocol, boost::shared_ptr<handshake_counters> counters)
 				: connection<protocol_type, N>(io_service, protocol)
-				, ssl_socket_(io_service, context) {}
+				, ssl_socket_(io_service, context)
+				, counters_(counters) {}
 			virtual ~ssl_connection() {}
 
 			virtual bool is_open() {
@@ -263,9 +320,13 @@ namespace socket_helpers {
 			}
 
 			virtual void handle_handshake(const boost::system::error_code& e) {
-				if (!e)
+				if (!e) {
+					if (SSL_session_reused(ssl_socket_.native_handle()))
+						counters_->resumed++;
+					else
+						counters_->full++;
 					parent_type::start();
-				else {
+				} else {
 					if (ERR_GET_REASON(e.value()) == SSL_R_NO_SHARED_CIPHER) {
 						parent_type::protocol_->log_error(__FILE__, __LINE__, "Seems we cant agree on SSL: " + utf8::utf8_from_native(e.message()));
 						parent_type::protocol_->log_error(__FILE__, __LINE__, "Please review the insecure options as well as ssl options in settings.");
@@ -279,6 +340,13 @@ namespace socket_helpers {
 				}
 			}
 
+			virtual void on_done(bool all_ok) {
+				// OpenSSL drops sessions which were not shut down, so mark the ones we end on purpose as such to keep them resumable
+				if (all_ok)
+					SSL_set_shutdown(ssl_socket_.native_handle(), SSL_SENT_SHUTDOWN | SSL_RECEIVED_SHUTDOWN);
+				parent_type::on_done(all_ok);
+			}
+
 			virtual void start_read_request() {
 				this->trace("ssl::start_read_request()");
 				ssl_socket_.async_read_some(
@@ -289,9 +357,9 @@ namespace socket_helpers {
 					);
 			}
 
-			virtual void start_write_request(const boost::asio::const_buffer& response) {
-				this->trace("ssl::start_write_request(" + str::xtos(boost::asio::buffer_size(response)) + ")");
-				boost::asio::async_write(ssl_socket_, boost::asio::const_buffers_1(response),
+			virtual void start_write_request(const const_buffer_list& buffers) {
+				this->trace("ssl::start_write_request(" + str::xtos(boost::asio::buffer_size(buffers)) + ")");
+				boost::asio::async_write(ssl_socket_, buffers,
 					parent_type::strand_.wrap(
 						boost::bind(&parent_type::handle_write_response, this->shared_from_this(), boost::asio::placeholders::error, boost::asio::placeholders::bytes_transferred)
 						)
@@ -301,6 +369,7 @@ namespace socket_helpers {
 		protected:
 			typedef boost::asio::ssl::stream<boost::asio::ip::tcp::socket> ssl_socket;
 			ssl_socket ssl_socket_;
+			boost::shared_ptr<handshake_counters> counters_;
 		};
 #endif
 	} // namespace server
@@ -77,6 +77,7 @@ namespace socket_helpers {
 
 			boost::shared_ptr<connection_type> new_connection_;
 			boost::thread_group thread_group_;
+			boost::shared_ptr<handshake_counters> handshakes_;
 		public:
 			server(socket_helpers::connection_info info, typename protocol_type::handler_type handler)
 				: is_shutting_down_(false)
@@ -88,6 +89,7 @@ namespace socket_helpers {
 				, acceptor_v6(io_service_)
 				, accept_strand_(io_service_)
 				, logger_(protocol_type::create(info_, handler_))
+				, handshakes_(new handshake_counters())
 #ifdef USE_SSL
 				, context_(io_service_, boost::asio::ssl::context::sslv23)
 #endif
@@ -148,6 +150,7 @@ namespace socket_helpers {
 #ifdef USE_SSL
 					std::list<std::string> errors;
 					info_.ssl.configure_ssl_context(context_, errors);
+					info_.ssl.configure_session_cache(context_, info_.get_endpoint_string(), errors);
 					BOOST_FOREACH(const std::string &e, errors) {
 						logger_->log_error(__FILE__, __LINE__, e);
 					}
@@ -228,6 +231,13 @@ namespace socket_helpers {
 				return true;
 			}
 
+			boost::uint64_t get_full_handshakes() const {
+				return handshakes_->full;
+			}
+			boost::uint64_t get_resumed_handshakes() const {
+				return handshakes_->resumed;
+			}
+
 			void stop() {
 				is_shutting_down_ = true;
 				acceptor_v4.close();
@@ -289,7 +299,7 @@ namespace socket_helpers {
 				threads_++;
 #ifdef USE_SSL
 				if (info_.ssl.enabled) {
-					return new ssl_connection_type(io_service_, context_, protocol_type::create(info_, handler_));
+					return new ssl_connection_type(io_service_, context_, protocol_type::create(info_, handler_), handshakes_);
 				}
 #endif
 				return new tcp_connection_type(io_service_, protocol_type::create(info_, handler_));
@@ -20,6 +20,7 @@
 #include <boost/asio.hpp>
 #include <boost/algorithm/string.hpp>
 #include <boost/filesystem.hpp>
+#include <boost/thread/mutex.hpp>
 
 #include <str/utils.hpp>
 #include <str/format.hpp>
@@ -29,6 +30,8 @@
 #ifndef WIN32
 #include <openssl/x509v3.h>
 #endif
+
+#include <map>
 const int socket_helpers::connection_info::backlog_default = 0;
 
 namespace ip = boost::asio::ip;
@@ -191,6 +194,63 @@ void socket_helpers::allowed_hosts_manager::refresh(std::list<std::string> &erro
 	}
 }
 
+namespace {
+	// Large buffers are not kept (they are rare and would pin memory)
+	boost::shared_ptr<socket_helpers::buffer_pool> default_buffer_pool(new socket_helpers::buffer_pool(256, 128 * 1024));
+}
+
+boost::shared_ptr<socket_helpers::buffer_pool> socket_helpers::buffer_pool::get_default() {
+	return default_buffer_pool;
+}
+
+socket_helpers::buffer_pool::~buffer_pool() {
+	BOOST_FOREACH(std::vector<char> *buffer, idle_) {
+		delete buffer;
+	}
+}
+
+socket_helpers::shared_buffer socket_helpers::buffer_pool::acquire(std::size_t size) {
+	std::vector<char> *buffer = NULL;
+	{
+		boost::mutex::scoped_lock lock(mutex_);
+		if (!idle_.empty()) {
+			buffer = idle_.back();
+			idle_.pop_back();
+		}
+	}
+	if (buffer == NULL)
+		buffer = new std::vector<char>();
+	shared_buffer ret(buffer, boost::bind(&buffer_pool::release, boost::weak_ptr<buffer_pool>(shared_from_this()), _1));
+	ret->assign(size, 0);
+	return ret;
+}
+
+std::size_t socket_helpers::buffer_pool::get_idle_count() {
+	boost::mutex::scoped_lock lock(mutex_);
+	return idle_.size();
+}
+
+// Buffers released after the pool is gone are simply deleted
+void socket_helpers::buffer_pool::release(boost::weak_ptr<buffer_pool> pool, std::vector<char> *buffer) {
+	boost::shared_ptr<buffer_pool> self = pool.lock();
+	if (self)
+		self->put(buffer);
+	else
+		delete buffer;
+}
+
+void socket_helpers::buffer_pool::put(std::vector<char> *buffer) {
+	if (buffer->capacity() <= max_buffer_size_) {
+		buffer->clear();
+		boost::mutex::scoped_lock lock(mutex_);
+		if (idle_.size() < max_buffers_) {
+			idle_.push_back(buffer);
+			return;
+		}
+	}
+	delete buffer;
+}
+
 void socket_helpers::io::set_result(boost::optional<boost::system::error_code>* a, boost::system::error_code b) {
 	if (!b) {
 		a->reset(b);
@@ -231,6 +291,61 @@ void socket_helpers::connection_info::ssl_opts::configure_ssl_context(boost::asi
 	}
 }
 
+void socket_helpers::connection_info::ssl_opts::configure_session_cache(boost::asio::ssl::context &context, const std::string &session_id, std::list<std::string> &errors) const {
+	SSL_CTX *ctx = context.native_handle();
+	if (session_cache_size == 0) {
+		SSL_CTX_set_session_cache_mode(ctx, SSL_SESS_CACHE_OFF);
+		SSL_CTX_set_options(ctx, SSL_OP_NO_TICKET);
+		return;
+	}
+	SSL_CTX_set_session_cache_mode(ctx, SSL_SESS_CACHE_SERVER);
+	SSL_CTX_sess_set_cache_size(ctx, session_cache_size);
+	SSL_CTX_set_timeout(ctx, session_timeout);
+	// Sessions are only resumed on the listener which created them (and required when verifying clients)
+	std::string id = session_id.substr(0, SSL_MAX_SID_CTX_LENGTH);
+	if (SSL_CTX_set_session_id_context(ctx, reinterpret_cast<const unsigned char*>(id.c_str()), static_cast<unsigned int>(id.size())) != 1)
+		errors.push_back("Failed to set session id context: " + session_id);
+	if (session_tickets)
+		SSL_CTX_clear_options(ctx, SSL_OP_NO_TICKET);
+	else
+		SSL_CTX_set_options(ctx, SSL_OP_NO_TICKET);
+}
+
+namespace socket_helpers {
+	namespace {
+		typedef std::map<std::string, SSL_SESSION*> session_map;
+		boost::mutex client_sessions_mutex;
+		session_map client_sessions;
+	}
+
+	void store_client_session(const std::string &key, SSL *ssl) {
+		SSL_SESSION *session = SSL_get1_session(ssl);
+		if (session == NULL)
+			return;
+#if OPENSSL_VERSION_NUMBER >= 0x10101000L
+		if (!SSL_SESSION_is_resumable(session)) {
+			SSL_SESSION_free(session);
+			return;
+		}
+#endif
+		boost::mutex::scoped_lock lock(client_sessions_mutex);
+		session_map::iterator it = client_sessions.find(key);
+		if (it != client_sessions.end()) {
+			SSL_SESSION_free(it->second);
+			it->second = session;
+		} else {
+			client_sessions[key] = session;
+		}
+	}
+
+	void restore_client_session(const std::string &key, SSL *ssl) {
+		boost::mutex::scoped_lock lock(client_sessions_mutex);
+		session_map::const_iterator it = client_sessions.find(key);
+		if (it != client_sessions.end())
+			SSL_set_session(ssl, it->second);
+	}
+}
+
 boost::asio::ssl::context::verify_mode socket_helpers::connection_info::ssl_opts::get_verify_mode() const {
 	boost::asio::ssl::context::verify_mode mode = boost::asio::ssl::context_base::verify_none;
 	BOOST_FOREACH(const std::string &key, str::utils::split_lst(verify_mode, std::string(","))) {
@@ -28,6 +28,9 @@
 #include <boost/optional.hpp>
 #include <boost/shared_ptr.hpp>
 #include <boost/enable_shared_from_this.hpp>
+#include <boost/weak_ptr.hpp>
+#include <boost/noncopyable.hpp>
+#include <boost/thread/mutex.hpp>
 #ifdef USE_SSL
 #include <boost/asio/ssl.hpp>
 #include <boost/asio/ssl/basic_context.hpp>
@@ -35,10 +38,16 @@
 
 #include <list>
 #include <string>
+#include <vector>
+#include <algorithm>
 
 namespace socket_helpers {
 #ifdef USE_SSL
 	void write_certs(std::string cert, bool ca);
+
+	// Client side TLS sessions (per server and TLS options) so the next connection can resume instead of doing a full handshake
+	void store_client_session(const std::string &key, SSL *ssl);
+	void restore_client_session(const std::string &key, SSL *ssl);
 #endif
 	void validate_certificate(const std::string &certificate, std::list<std::string> &list);
 
@@ -149,7 +158,7 @@ namespace socket_helpers {
 
 	struct connection_info {
 		struct ssl_opts {
-			ssl_opts() : enabled(false) {}
+			ssl_opts() : enabled(false), session_cache_size(0), session_timeout(300), session_tickets(true) {}
 
 			ssl_opts(const ssl_opts &other)
 				: enabled(other.enabled)
@@ -160,7 +169,10 @@ namespace socket_helpers {
 				, allowed_ciphers(other.allowed_ciphers)
 				, dh_key(other.dh_key)
 				, verify_mode(other.verify_mode)
-				, ssl_options(other.ssl_options) {}
+				, ssl_options(other.ssl_options)
+				, session_cache_size(other.session_cache_size)
+				, session_timeout(other.session_timeout)
+				, session_tickets(other.session_tickets) {}
 			ssl_opts& operator=(const ssl_opts &other) {
 				enabled = other.enabled;
 				certificate = other.certificate;
@@ -171,6 +183,9 @@ namespace socket_helpers {
 				dh_key = other.dh_key;
 				verify_mode = other.verify_mode;
 				ssl_options = other.ssl_options;
+				session_cache_size = other.session_cache_size;
+				session_timeout = other.session_timeout;
+				session_tickets = other.session_tickets;
 				return *this;
 			}
 
@@ -187,6 +202,11 @@ namespace socket_helpers {
 			std::string verify_mode;
 			std::string ssl_options;
 
+			// Server side session resumption (a cache size of 0 disables the cache)
+			unsigned int session_cache_size;
+			unsigned int session_timeout;
+			bool session_tickets;
+
 			std::string to_string() const {
 				std::stringstream ss;
 				if (enabled) {
@@ -201,8 +221,14 @@ namespace socket_helpers {
 					ss << "ssl disabled";
 				return ss.str();
 			}
+			// Identifies the options a client session was negotiated with so it is only resumed by connections using the same ones.
+			std::string get_session_key() const {
+				return verify_mode + "|" + ca_path + "|" + certificate + "|" + certificate_format + "|" + certificate_key + "|" + certificate_key_format
+					+ "|" + allowed_ciphers + "|" + ssl_options;
+			}
 #ifdef USE_SSL
 			void configure_ssl_context(boost::asio::ssl::context &context, std::list<std::string> &errors) const;
+			void configure_session_cache(boost::asio::ssl::context &context, const std::string &session_id, std::list<std::string> &errors) const;
 			boost::asio::ssl::context::verify_mode get_verify_mode() const;
 			boost::asio::ssl::context::file_format get_certificate_format() const;
 			boost::asio::ssl::context::file_format get_certificate_key_format() const;
@@ -216,12 +242,14 @@ namespace socket_helpers {
 		std::string port_;
 		unsigned int thread_pool_size;
 		unsigned int timeout;
+		// Seconds a connection is kept open waiting for the next request (0 closes it after the first request)
+		unsigned int idle_timeout;
 		int retry;
 		bool reuse;
 		ssl_opts ssl;
 		allowed_hosts_manager allowed_hosts;
 
-		connection_info() : back_log(backlog_default), port_("0"), thread_pool_size(0), timeout(30), retry(2), reuse(true) {}
+		connection_info() : back_log(backlog_default), port_("0"), thread_pool_size(0), timeout(30), idle_timeout(0), retry(2), reuse(true) {}
 
 		connection_info(const connection_info &other)
 			: address(other.address)
@@ -229,6 +257,7 @@ namespace socket_helpers {
 			, port_(other.port_)
 			, thread_pool_size(other.thread_pool_size)
 			, timeout(other.timeout)
+			, idle_timeout(other.idle_timeout)
 			, retry(other.retry)
 			, reuse(other.reuse)
 			, ssl(other.ssl)
@@ -239,6 +268,7 @@ namespace socket_helpers {
 			port_ = other.port_;
 			thread_pool_size = other.thread_pool_size;
 			timeout = other.timeout;
+			idle_timeout = other.idle_timeout;
 			retry = other.retry;
 			reuse = other.reuse;
 			ssl = other.ssl;
@@ -266,6 +296,38 @@ namespace socket_helpers {
 		}
 	};
 
+	// Outbound data is kept in reference counted buffers which go back to the pool as soon as the last reference is dropped
+	typedef boost::shared_ptr<std::vector<char> > shared_buffer;
+	typedef std::vector<shared_buffer> buffer_list;
+
+	class buffer_pool : public boost::enable_shared_from_this<buffer_pool>, private boost::noncopyable {
+	public:
+		buffer_pool(std::size_t max_buffers, std::size_t max_buffer_size) : max_buffers_(max_buffers), max_buffer_size_(max_buffer_size) {}
+		~buffer_pool();
+
+		// The pool used by the connections of this module
+		static boost::shared_ptr<buffer_pool> get_default();
+
+		// Returns a zero filled buffer of the given size
+		shared_buffer acquire(std::size_t size);
+		template<class T>
+		shared_buffer acquire_copy(const T &data) {
+			shared_buffer buffer = acquire(data.size());
+			std::copy(data.begin(), data.end(), buffer->begin());
+			return buffer;
+		}
+		std::size_t get_idle_count();
+
+	private:
+		static void release(boost::weak_ptr<buffer_pool> pool, std::vector<char> *buffer);
+		void put(std::vector<char> *buffer);
+
+		boost::mutex mutex_;
+		std::vector<std::vector<char>*> idle_;
+		std::size_t max_buffers_;
+		std::size_t max_buffer_size_;
+	};
+
 	namespace io {
 		void set_result(boost::optional<boost::system::error_code>* a, boost::system::error_code b);
 
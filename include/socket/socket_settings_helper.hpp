@@ -78,6 +78,15 @@ namespace socket_helpers {
 					"single-dh-use\tAlways create a new key when using temporary/ephemeral DH parameters. "
 					"This option must be used to prevent small subgroup attacks, when the DH parameters were not generated using \"strong\" primes (e.g. when using DSA-parameters).\n"
 					"\n\n", true)
+
+				("ssl session cache", nscapi::settings_helper::uint_key(&info_.ssl.session_cache_size, 1024),
+					"SSL SESSION CACHE", "Number of SSL sessions to remember so clients which connect again can resume their session instead of doing a full handshake (0 disables resumption).", true)
+
+				("ssl session timeout", nscapi::settings_helper::uint_key(&info_.ssl.session_timeout, 300),
+					"SSL SESSION TIMEOUT", "Number of seconds a session can be resumed.", true)
+
+				("ssl session tickets", nscapi::settings_helper::bool_key(&info_.ssl.session_tickets, true),
+					"SSL SESSION TICKETS", "Allow clients to resume sessions using session tickets (the session is kept by the client).", true)
 				;
 		}
 
@@ -0,0 +1,105 @@
+/*
+ * Copyright (C) 2004-2016 Michael Medin
+ *
+ * This file is part of NSClient++ - https://nsclient.org
+ *
+ * NSClient++ is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * NSClient++ is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with NSClient++.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <boost/atomic.hpp>
+#include <boost/noncopyable.hpp>
+#include <boost/scoped_array.hpp>
+
+namespace nscp_thread {
+
+	// A bounded lock free queue for many producers and a single consumer.
+	// Values are pre-allocated and reused: a producer claims a slot, assigns it in place and publishes it, the consumer reads it
+	// in place and releases it. The slot sequence numbers tell producers and the consumer whose turn it is (the slot at position p
+	// is free when its sequence is p, ready when it is p+1 and free for the next round when the consumer sets it to p+capacity).
+	template<typename T>
+	class mpsc_ring : public boost::noncopyable {
+		struct cell {
+			boost::atomic<std::size_t> sequence;
+			T value;
+		};
+
+		boost::scoped_array<cell> cells_;
+		const std::size_t mask_;
+		char pad0_[64];
+		boost::atomic<std::size_t> enqueue_pos_;
+		char pad1_[64];
+		std::size_t dequeue_pos_;
+
+	public:
+		// Capacity is rounded up to a power of two.
+		explicit mpsc_ring(std::size_t capacity) : mask_(round_up(capacity) - 1), enqueue_pos_(0), dequeue_pos_(0) {
+			cells_.reset(new cell[mask_ + 1]);
+			for (std::size_t i = 0; i <= mask_; i++)
+				cells_[i].sequence.store(i, boost::memory_order_relaxed);
+		}
+
+		std::size_t capacity() const {
+			return mask_ + 1;
+		}
+
+		// Reserves a slot for writing, returns NULL when the ring is full.
+		T* claim(std::size_t &position) {
+			std::size_t pos = enqueue_pos_.load(boost::memory_order_relaxed);
+			while (true) {
+				cell &c = cells_[pos & mask_];
+				const std::size_t seq = c.sequence.load(boost::memory_order_acquire);
+				const std::ptrdiff_t diff = static_cast<std::ptrdiff_t>(seq) - static_cast<std::ptrdiff_t>(pos);
+				if (diff == 0) {
+					if (enqueue_pos_.compare_exchange_weak(pos, pos + 1, boost::memory_order_relaxed)) {
+						position = pos;
+						return &c.value;
+					}
+				} else if (diff < 0) {
+					return NULL;
+				} else {
+					pos = enqueue_pos_.load(boost::memory_order_relaxed);
+				}
+			}
+		}
+
+		// Hands a claimed slot over to the consumer.
+		void publish(std::size_t position) {
+			cells_[position & mask_].sequence.store(position + 1, boost::memory_order_release);
+		}
+
+		// Consumer only: the oldest published value or NULL if there is none.
+		T* front() {
+			cell &c = cells_[dequeue_pos_ & mask_];
+			if (c.sequence.load(boost::memory_order_acquire) != dequeue_pos_ + 1)
+				return NULL;
+			return &c.value;
+		}
+
+		// Consumer only: releases the value returned by front.
+		void pop() {
+			cells_[dequeue_pos_ & mask_].sequence.store(dequeue_pos_ + mask_ + 1, boost::memory_order_release);
+			dequeue_pos_++;
+		}
+
+	private:
+		static std::size_t round_up(std::size_t capacity) {
+			std::size_t ret = 2;
+			while (ret < capacity)
+				ret <<= 1;
+			return ret;
+		}
+	};
+}
@@ -0,0 +1,135 @@
+/*
+ * Copyright (C) 2004-2016 Michael Medin
+ *
+ * This file is part of NSClient++ - https://nsclient.org
+ *
+ * NSClient++ is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * NSClient++ is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with NSClient++.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <threads/work_stealing_pool.hpp>
+
+#include <boost/bind.hpp>
+
+namespace nscp_thread {
+
+	void work_stealing_pool::start(std::size_t threads) {
+		boost::mutex::scoped_lock lock(mutex_);
+		if (running_)
+			return;
+		if (threads == 0)
+			threads = 1;
+		queues_.clear();
+		for (std::size_t i = 0; i < threads; i++)
+			queues_.push_back(boost::shared_ptr<worker_queue>(new worker_queue()));
+		running_ = true;
+		for (std::size_t i = 0; i < threads; i++)
+			threads_.create_thread(boost::bind(&work_stealing_pool::worker, this, i));
+	}
+
+	void work_stealing_pool::stop() {
+		{
+			boost::mutex::scoped_lock lock(mutex_);
+			if (!running_)
+				return;
+			running_ = false;
+		}
+		idle_cond_.notify_all();
+		threads_.join_all();
+	}
+
+	bool work_stealing_pool::is_running() {
+		boost::mutex::scoped_lock lock(mutex_);
+		return running_;
+	}
+
+	bool work_stealing_pool::submit(task_type task) {
+		boost::mutex::scoped_lock lock(mutex_);
+		if (!running_)
+			return false;
+		std::size_t *current = current_.get();
+		std::size_t id = current != NULL ? *current : next_++ % queues_.size();
+		{
+			boost::mutex::scoped_lock queue_lock(queues_[id]->mutex);
+			queues_[id]->tasks.push_back(task);
+		}
+		pending_++;
+		lock.unlock();
+		idle_cond_.notify_one();
+		return true;
+	}
+
+	std::vector<work_stealing_pool::queue_metrics> work_stealing_pool::get_metrics() {
+		std::vector<queue_metrics> ret;
+		boost::mutex::scoped_lock lock(mutex_);
+		for (queue_list::const_iterator it = queues_.begin(); it != queues_.end(); ++it) {
+			boost::mutex::scoped_lock queue_lock((*it)->mutex);
+			queue_metrics m;
+			m.depth = (*it)->tasks.size();
+			m.executed = (*it)->executed;
+			m.stolen = (*it)->stolen;
+			ret.push_back(m);
+		}
+		return ret;
+	}
+
+	bool work_stealing_pool::take(std::size_t id, task_type &task) {
+		{
+			worker_queue &own = *queues_[id];
+			boost::mutex::scoped_lock lock(own.mutex);
+			if (!own.tasks.empty()) {
+				task = own.tasks.back();
+				own.tasks.pop_back();
+				own.executed++;
+				return true;
+			}
+		}
+		for (std::size_t i = 1; i < queues_.size(); i++) {
+			worker_queue &victim = *queues_[(id + i) % queues_.size()];
+			boost::mutex::scoped_lock lock(victim.mutex);
+			if (!victim.tasks.empty()) {
+				task = victim.tasks.front();
+				victim.tasks.pop_front();
+				lock.unlock();
+				boost::mutex::scoped_lock own_lock(queues_[id]->mutex);
+				queues_[id]->executed++;
+				queues_[id]->stolen++;
+				return true;
+			}
+		}
+		return false;
+	}
+
+	void work_stealing_pool::worker(std::size_t id) {
+		current_.reset(new std::size_t(id));
+		while (true) {
+			{
+				boost::mutex::scoped_lock lock(mutex_);
+				while (pending_ == 0 && running_)
+					idle_cond_.wait(lock);
+				if (pending_ == 0)
+					return;
+				pending_--;
+			}
+			// We have claimed a task so there is one in some queue (another worker might take the one we see first, so keep looking)
+			task_type task;
+			while (!take(id, task))
+				boost::this_thread::yield();
+			try {
+				task();
+			} catch (...) {
+				// Tasks are expected to handle their own errors, we only make sure the worker survives.
+			}
+		}
+	}
+}
@@ -0,0 +1,93 @@
+/*
+ * Copyright (C) 2004-2016 Michael Medin
+ *
+ * This file is part of NSClient++ - https://nsclient.org
+ *
+ * NSClient++ is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * NSClient++ is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with NSClient++.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <deque>
+#include <vector>
+
+#include <boost/cstdint.hpp>
+#include <boost/function.hpp>
+#include <boost/noncopyable.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/thread.hpp>
+#include <boost/thread/tss.hpp>
+
+namespace nscp_thread {
+
+	// A fixed size thread pool where each worker has its own queue.
+	// Tasks submitted from a worker are put on its own queue and run newest first (so continuations run while their data is still
+	// in the cache), other tasks are spread over the queues. A worker which runs out of tasks steals the oldest task from another queue.
+	class work_stealing_pool : public boost::noncopyable {
+	public:
+		typedef boost::function<void()> task_type;
+
+		struct queue_metrics {
+			std::size_t depth;
+			boost::uint64_t executed;
+			boost::uint64_t stolen;
+			queue_metrics() : depth(0), executed(0), stolen(0) {}
+		};
+
+	private:
+		struct worker_queue {
+			boost::mutex mutex;
+			std::deque<task_type> tasks;
+			boost::uint64_t executed;
+			boost::uint64_t stolen;
+			worker_queue() : executed(0), stolen(0) {}
+		};
+		typedef std::vector<boost::shared_ptr<worker_queue> > queue_list;
+
+		queue_list queues_;
+		boost::thread_group threads_;
+		// Guards pending, next and running (pending is the number of tasks in all queues which no worker has claimed yet)
+		boost::mutex mutex_;
+		boost::condition_variable idle_cond_;
+		std::size_t pending_;
+		std::size_t next_;
+		bool running_;
+		boost::thread_specific_ptr<std::size_t> current_;
+
+	public:
+		work_stealing_pool() : pending_(0), next_(0), running_(false) {}
+		~work_stealing_pool() {
+			stop();
+		}
+
+		void start(std::size_t threads);
+		// Waits for all submitted tasks to finish.
+		void stop();
+		bool submit(task_type task);
+
+		bool is_running();
+		// True when called from one of the pool's own workers.
+		bool is_worker() const {
+			return current_.get() != NULL;
+		}
+		std::size_t size() const {
+			return queues_.size();
+		}
+		std::vector<queue_metrics> get_metrics();
+
+	private:
+		void worker(std::size_t id);
+		bool take(std::size_t id, task_type &task);
+	};
+}
@@ -0,0 +1,161 @@
+/*
+ * Copyright (C) 2004-2016 Michael Medin
+ *
+ * This file is part of NSClient++ - https://nsclient.org
+ *
+ * NSClient++ is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * NSClient++ is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with NSClient++.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "where_test_helper.hpp"
+
+#include <iostream>
+#include <vector>
+#include <string>
+#include <cstdlib>
+
+#include <boost/optional.hpp>
+#include <boost/date_time/posix_time/posix_time.hpp>
+
+using where_test::test_filter;
+using where_test::test_object;
+using where_test::test_object_type;
+
+namespace pt = boost::posix_time;
+
+struct result {
+	long long matched;
+	long long elapsed_ms;
+	result() : matched(0), elapsed_ms(0) {}
+};
+
+template<class T>
+result run(test_filter &filter, const std::vector<test_object_type> &objects, long long iterations, T eval) {
+	result ret;
+	pt::ptime start = pt::microsec_clock::universal_time();
+	for (long long i = 0; i < iterations; i++) {
+		if ((filter.*eval)(objects[i % objects.size()]).is_true())
+			ret.matched++;
+	}
+	ret.elapsed_ms = (pt::microsec_clock::universal_time() - start).total_milliseconds();
+	return ret;
+}
+
+result run_batch(test_filter &filter, const std::vector<test_object_type> &objects, long long iterations) {
+	result ret;
+	pt::ptime start = pt::microsec_clock::universal_time();
+	for (long long i = 0; i < iterations; i += objects.size()) {
+		ret.matched += filter.evaluate_batch(objects).size();
+	}
+	ret.elapsed_ms = (pt::microsec_clock::universal_time() - start).total_milliseconds();
+	return ret;
+}
+
+void benchmark(const std::string &expr, const std::vector<test_object_type> &objects, long long iterations) {
+	test_filter filter;
+	if (!filter.parse(expr)) {
+		std::cout << "Failed to parse: " << expr << ": " << filter.context->get_error() << std::endl;
+		return;
+	}
+	result tree = run(filter, objects, iterations, &test_filter::evaluate_tree);
+	result compiled = run(filter, objects, iterations, &test_filter::evaluate);
+	result batch = run_batch(filter, objects, iterations);
+	double speedup = compiled.elapsed_ms > 0 ? static_cast<double>(tree.elapsed_ms) / compiled.elapsed_ms : 0.0;
+	std::cout << expr << std::endl;
+	std::cout << "  tree:     " << tree.elapsed_ms << "ms (" << tree.matched << " matched)" << std::endl;
+	std::cout << "  compiled: " << compiled.elapsed_ms << "ms (" << compiled.matched << " matched)" << std::endl;
+	std::cout << "  batch:    " << batch.elapsed_ms << "ms (" << batch.matched << " matched)" << std::endl;
+	std::cout << "  speedup:  " << speedup << "x" << (filter.parser.program.is_compiled() ? "" : " (not compiled)") << std::endl;
+}
+
+// The previous (boost::optional based) value_container kept for comparison
+struct legacy_value_container {
+	boost::optional<long long> i_value;
+	boost::optional<double> f_value;
+	boost::optional<std::string> s_value;
+	bool is_unsure;
+
+	legacy_value_container() : is_unsure(false) {}
+	static legacy_value_container create_int(long long value) {
+		legacy_value_container ret;
+		ret.i_value = value;
+		return ret;
+	}
+	static legacy_value_container create_string(std::string value) {
+		legacy_value_container ret;
+		ret.s_value = value;
+		return ret;
+	}
+	long long get_int() const { return *i_value; }
+	std::string get_string() const { return *s_value; }
+};
+
+// Mimics an operator receiving its operands by value (as operators.cpp used to)
+bool legacy_compare(const legacy_value_container lhs, const legacy_value_container rhs) {
+	if (lhs.s_value)
+		return lhs.get_string() == rhs.get_string();
+	return lhs.get_int() > rhs.get_int();
+}
+bool tagged_compare(const parsers::where::value_container &lhs, const parsers::where::value_container &rhs) {
+	if (lhs.is(parsers::where::type_string))
+		return lhs.get_string_ref() == rhs.get_string_ref();
+	return lhs.get_int() > rhs.get_int();
+}
+
+void benchmark_values(const std::vector<test_object_type> &objects, long long iterations) {
+	long long legacy_matched = 0, tagged_matched = 0;
+	const legacy_value_container legacy_size = legacy_value_container::create_int(1024 * 1024);
+	const legacy_value_container legacy_name = legacy_value_container::create_string("foo.log");
+	pt::ptime start = pt::microsec_clock::universal_time();
+	for (long long i = 0; i < iterations; i++) {
+		const test_object &o = *objects[i % objects.size()];
+		if (legacy_compare(legacy_value_container::create_int(o.size), legacy_size) && legacy_compare(legacy_value_container::create_string(o.name), legacy_name))
+			legacy_matched++;
+	}
+	long long legacy_ms = (pt::microsec_clock::universal_time() - start).total_milliseconds();
+
+	const parsers::where::value_container tagged_size = parsers::where::value_container::create_int(1024 * 1024);
+	const parsers::where::value_container tagged_name = parsers::where::value_container::create_string("foo.log");
+	start = pt::microsec_clock::universal_time();
+	for (long long i = 0; i < iterations; i++) {
+		const test_object &o = *objects[i % objects.size()];
+		if (tagged_compare(parsers::where::value_container::create_int(o.size), tagged_size) && tagged_compare(parsers::where::value_container::create_string(o.name), tagged_name))
+			tagged_matched++;
+	}
+	long long tagged_ms = (pt::microsec_clock::universal_time() - start).total_milliseconds();
+
+	std::cout << "value_container: size > 1M and name = 'foo.log'" << std::endl;
+	std::cout << "  optional: " << legacy_ms << "ms (" << legacy_matched << " matched)" << std::endl;
+	std::cout << "  tagged:   " << tagged_ms << "ms (" << tagged_matched << " matched)" << std::endl;
+	std::cout << "  speedup:  " << (tagged_ms > 0 ? static_cast<double>(legacy_ms) / tagged_ms : 0.0) << "x" << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+	long long iterations = 1000000;
+	if (argc > 1)
+		iterations = std::atol(argv[1]);
+
+	std::vector<test_object_type> objects;
+	for (int i = 0; i < 1000; i++) {
+		objects.push_back(test_object_type(new test_object(i * 4096, i / 10.0, i % 3 == 0 ? "foo.log" : "bar.txt", 1000 + i)));
+	}
+
+	std::cout << "Evaluating " << iterations << " objects per expression" << std::endl;
+	benchmark("size > 1M", objects, iterations);
+	benchmark("size > 1M and load < 50.5", objects, iterations);
+	benchmark("size > 1M and name = 'foo.log'", objects, iterations);
+	benchmark("size > 1M and name like 'foo' and written > -7d", objects, iterations);
+	benchmark("name regexp 'foo.*' or name regexp '.*\\.txt'", objects, iterations);
+	benchmark_values(objects, iterations);
+	return 0;
+}
@@ -0,0 +1,210 @@
+/*
+ * Copyright (C) 2004-2016 Michael Medin
+ *
+ * This file is part of NSClient++ - https://nsclient.org
+ *
+ * NSClient++ is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * NSClient++ is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with NSClient++.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "where_test_helper.hpp"
+
+#include <vector>
+#include <string>
+
+#include <gtest/gtest.h>
+
+using where_test::test_filter;
+using where_test::test_object;
+using where_test::test_object_type;
+
+std::vector<test_object_type> get_objects() {
+	std::vector<test_object_type> ret;
+	ret.push_back(test_object_type(new test_object(0, 0.0, "", 0)));
+	ret.push_back(test_object_type(new test_object(1024, 0.5, "foo.log", 1000)));
+	ret.push_back(test_object_type(new test_object(2 * 1024 * 1024, 12.5, "FooBar.txt", 2000)));
+	ret.push_back(test_object_type(new test_object(-5, 99.9, "bar", -1)));
+	return ret;
+}
+
+void assert_same(const std::string &expr) {
+	test_filter compiled, tree;
+	ASSERT_TRUE(compiled.parse(expr, true)) << expr;
+	ASSERT_TRUE(tree.parse(expr, false)) << expr;
+	std::vector<test_object_type> objects = get_objects();
+	parsers::where::batch_rows expected;
+	for (std::size_t i = 0; i < objects.size(); ++i) {
+		test_object_type o = objects[i];
+		parsers::where::value_container c = compiled.evaluate(o);
+		parsers::where::value_container t = tree.evaluate(o);
+		EXPECT_EQ(t.is_true(), c.is_true()) << expr << " for " << o->name;
+		EXPECT_EQ(t.is_unsure, c.is_unsure) << expr << " for " << o->name;
+		if (t.is_true())
+			expected.push_back(i);
+	}
+	EXPECT_EQ(expected, compiled.evaluate_batch(objects)) << expr;
+	EXPECT_EQ(expected, tree.evaluate_batch(objects)) << expr;
+}
+
+TEST(WhereCompilerTest, compiles_simple_expressions) {
+	test_filter f;
+	ASSERT_TRUE(f.parse("size > 1k and name like 'foo'"));
+	EXPECT_TRUE(f.parser.program.is_compiled());
+}
+
+TEST(WhereCompilerTest, root_constants_are_left_to_tree) {
+	test_filter f;
+	ASSERT_TRUE(f.parse("1"));
+	EXPECT_FALSE(f.parser.program.is_compiled());
+}
+
+TEST(WhereCompilerTest, same_result_as_tree_int) {
+	assert_same("size > 1k");
+	assert_same("size >= 1k");
+	assert_same("size < 1k");
+	assert_same("size <= 1k");
+	assert_same("size = 1k");
+	assert_same("size != 1k");
+	assert_same("size < 1M");
+	assert_same("written > 1500s");
+}
+
+TEST(WhereCompilerTest, same_result_as_tree_float) {
+	assert_same("load > 0.5");
+	assert_same("load < 12.5");
+	assert_same("load = 12.5");
+	assert_same("load > 10");
+}
+
+TEST(WhereCompilerTest, same_result_as_tree_string) {
+	assert_same("name = 'foo.log'");
+	assert_same("name != 'foo.log'");
+	assert_same("name like 'foo'");
+	assert_same("name not like 'foo'");
+	assert_same("name regexp '.*\\.txt'");
+	assert_same("name not regexp '.*\\.txt'");
+	assert_same("name regexp name");
+	assert_same("name regexp '[invalid'");
+	assert_same("name in ('bar', 'foo.log')");
+}
+
+TEST(WhereCompilerTest, same_result_as_tree_logical) {
+	assert_same("size > 1k and name like 'foo'");
+	assert_same("size > 1k or name like 'bar'");
+	assert_same("size > 1k and (load < 50 or name = 'bar')");
+	assert_same("not size > 1k");
+	assert_same("size > 1k and name regexp 'Foo.*'");
+	assert_same("written > -7d or size = 0b");
+}
+
+TEST(WhereRegexCacheTest, lru_counts_hits_and_evicts) {
+	parsers::where::regex_cache cache(2);
+	cache.get("a.*");
+	cache.get("a.*");
+	EXPECT_EQ(1, cache.get_compiles());
+	EXPECT_EQ(1, cache.get_hits());
+	cache.get("b.*");
+	cache.get("a.*");
+	cache.get("c.*");
+	EXPECT_EQ(2, cache.size());
+	EXPECT_EQ(1, cache.get_evictions());
+	cache.get("a.*");
+	EXPECT_EQ(3, cache.get_compiles());
+	EXPECT_EQ(3, cache.get_hits());
+	EXPECT_THROW(cache.get("[invalid"), boost::regex_error);
+}
+
+TEST(WhereRegexCacheTest, constant_patterns_are_compiled_once) {
+	test_filter f;
+	ASSERT_TRUE(f.parse("name regexp 'foo.*' or name not regexp 'bar'"));
+	EXPECT_TRUE(f.parser.program.is_compiled());
+	EXPECT_EQ(2, f.regex_cache->get_compiles());
+	BOOST_FOREACH(test_object_type o, get_objects()) {
+		f.evaluate(o);
+	}
+	EXPECT_EQ(2, f.regex_cache->get_compiles());
+	EXPECT_EQ(0, f.regex_cache->get_hits());
+}
+
+TEST(WhereRegexCacheTest, dynamic_patterns_use_the_cache) {
+	test_filter f;
+	ASSERT_TRUE(f.parse("name regexp name"));
+	test_object_type o(new test_object(0, 0.0, "foo", 0));
+	EXPECT_TRUE(f.evaluate(o).is_true());
+	EXPECT_TRUE(f.evaluate(o).is_true());
+	EXPECT_TRUE(f.evaluate(o).is_true());
+	EXPECT_EQ(1, f.regex_cache->get_compiles());
+	EXPECT_EQ(2, f.regex_cache->get_hits());
+}
+
+TEST(WhereOptimizerTest, folds_unit_conversions) {
+	test_filter f;
+	ASSERT_TRUE(f.parse("written > -7d and size > 1k"));
+	EXPECT_TRUE(f.parser.program.is_compiled());
+	EXPECT_NE(std::string::npos, f.parser.result_as_program().find("2 constant expressions folded")) << f.parser.result_as_program();
+	EXPECT_EQ(std::string::npos, f.parser.result_as_program().find("convert")) << f.parser.result_as_program();
+}
+
+TEST(WhereOptimizerTest, folds_constant_expressions) {
+	assert_same("1 = 1 and size > 1k");
+	assert_same("1 = 2 or size > 1k");
+	assert_same("'a' in ('a', 'b') and size > 1k");
+	test_filter f;
+	ASSERT_TRUE(f.parse("1 = 2 or size > 1k"));
+	std::string plan = f.parser.result_as_program();
+	EXPECT_NE(std::string::npos, plan.find("2 constant expressions folded")) << plan;
+	EXPECT_EQ(std::string::npos, plan.find(" or ")) << plan;
+	ASSERT_TRUE(f.parse("1 = 2 and size > 1k"));
+	plan = f.parser.result_as_program();
+	EXPECT_EQ(std::string::npos, plan.find("size")) << plan;
+	assert_same("1 = 2 and size > 1k");
+	assert_same("1 = 1 or size > 1k");
+}
+
+TEST(WhereOptimizerTest, cheap_operands_run_first) {
+	test_filter f;
+	ASSERT_TRUE(f.parse("name regexp 'foo.*' and size > 1k"));
+	std::string plan = f.parser.result_as_program();
+	EXPECT_LT(plan.find("size"), plan.find("name")) << plan;
+	assert_same("name regexp 'foo.*' and size > 1k");
+	assert_same("name like 'bar' or load > 50");
+	assert_same("(name like 'foo' or size > 1M) and (name regexp 'Foo.*' and load > 10)");
+}
+
+TEST(WhereOptimizerTest, not_is_compiled) {
+	test_filter f;
+	ASSERT_TRUE(f.parse("not size > 1k"));
+	EXPECT_TRUE(f.parser.program.is_compiled());
+	assert_same("not size > 1k");
+	assert_same("not name regexp 'foo.*'");
+}
+
+TEST(WhereBatchTest, selects_matching_rows) {
+	test_filter f;
+	ASSERT_TRUE(f.parse("size > 1k or name = 'bar'"));
+	std::vector<test_object_type> objects = get_objects();
+	parsers::where::batch_rows matched = f.evaluate_batch(objects);
+	ASSERT_EQ(2u, matched.size());
+	EXPECT_EQ(2u, matched[0]);
+	EXPECT_EQ(3u, matched[1]);
+	EXPECT_TRUE(f.evaluate_batch(std::vector<test_object_type>()).empty());
+}
+
+TEST(WhereBatchTest, string_predicates_only_run_for_undecided_rows) {
+	test_filter f;
+	ASSERT_TRUE(f.parse("name regexp name and size > 1M"));
+	parsers::where::batch_rows matched = f.evaluate_batch(get_objects());
+	ASSERT_EQ(1u, matched.size());
+	EXPECT_EQ(2u, matched[0]);
+	EXPECT_EQ(1u, f.regex_cache->get_compiles() + f.regex_cache->get_hits());
+}
@@ -0,0 +1,146 @@
+/*
+ * Copyright (C) 2004-2016 Michael Medin
+ *
+ * This file is part of NSClient++ - https://nsclient.org
+ *
+ * NSClient++ is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * NSClient++ is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with NSClient++.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <string>
+#include <list>
+#include <vector>
+
+#include <boost/shared_ptr.hpp>
+#include <boost/function.hpp>
+
+#include <parsers/where.hpp>
+#include <parsers/where/engine_impl.hpp>
+#include <parsers/where/variable.hpp>
+
+namespace where_test {
+	namespace pw = parsers::where;
+
+	struct test_object {
+		long long size;
+		double load;
+		std::string name;
+		long long written;
+
+		test_object(long long size, double load, std::string name, long long written) : size(size), load(load), name(name), written(written) {}
+	};
+	typedef boost::shared_ptr<test_object> test_object_type;
+
+	// A minimal object factory exposing a handful of typed variables (mimics filter_handler_impl without the NSCAPI dependencies).
+	struct test_context : public pw::evaluation_context_impl<test_object_type> {
+		typedef boost::function<std::string(object_type, pw::evaluation_context)> bound_string_type;
+		typedef boost::function<long long(object_type, pw::evaluation_context)> bound_int_type;
+		typedef boost::function<double(object_type, pw::evaluation_context)> bound_float_type;
+		typedef boost::shared_ptr<pw::number_performance_generator_interface<object_type, long long> > int_perf_type;
+		typedef boost::shared_ptr<pw::number_performance_generator_interface<object_type, double> > float_perf_type;
+
+		static long long get_size(object_type o, pw::evaluation_context) { return o->size; }
+		static double get_load(object_type o, pw::evaluation_context) { return o->load; }
+		static std::string get_name(object_type o, pw::evaluation_context) { return o->name; }
+		static long long get_written(object_type o, pw::evaluation_context) { return o->written; }
+
+		bool has_variable(const std::string &name) {
+			return name == "size" || name == "load" || name == "name" || name == "written";
+		}
+		pw::node_type create_variable(const std::string &name, bool) {
+			if (name == "size")
+				return pw::node_type(new pw::int_variable_node<test_context>(name, pw::type_size, &get_size, std::list<int_perf_type>()));
+			if (name == "written")
+				return pw::node_type(new pw::int_variable_node<test_context>(name, pw::type_date, &get_written, std::list<int_perf_type>()));
+			if (name == "load")
+				return pw::node_type(new pw::float_variable_node<test_context>(name, pw::type_float, &get_load, std::list<float_perf_type>()));
+			if (name == "name")
+				return pw::node_type(new pw::str_variable_node<test_context>(name, pw::type_string, &get_name));
+			return pw::factory::create_false();
+		}
+		bool has_function(const std::string &) {
+			return false;
+		}
+		pw::node_type create_function(const std::string &, pw::node_type) {
+			return pw::factory::create_false();
+		}
+		bool can_convert(pw::value_type, pw::value_type) {
+			return false;
+		}
+		bool can_convert(std::string, pw::node_type, pw::value_type) {
+			return false;
+		}
+		boost::shared_ptr<pw::binary_function_impl> create_converter(std::string, pw::node_type, pw::value_type) {
+			return boost::shared_ptr<pw::binary_function_impl>();
+		}
+		std::string get_performance_config_key(const std::string, const std::string, const std::string, const std::string, const std::string v) const {
+			return v;
+		}
+	};
+
+	struct test_binder : public pw::batch_binder {
+		boost::shared_ptr<test_context> context;
+		const std::vector<test_object_type> &objects;
+
+		test_binder(boost::shared_ptr<test_context> context, const std::vector<test_object_type> &objects) : context(context), objects(objects) {}
+		void bind(std::size_t row) {
+			context->set_object(objects[row]);
+		}
+	};
+
+	struct test_filter {
+		boost::shared_ptr<test_context> context;
+		pw::parser parser;
+		pw::regex_cache_type regex_cache;
+
+		test_filter() : context(new test_context()), regex_cache(new pw::regex_cache()) {}
+
+		bool parse(const std::string &expr, bool compile = true) {
+			if (!parser.parse(context, expr))
+				return false;
+			if (!parser.derive_types(context) || context->has_error())
+				return false;
+			if (!parser.bind(context) || context->has_error())
+				return false;
+			if (!parser.static_eval(context) || context->has_error())
+				return false;
+			if (compile)
+				parser.compile(context, regex_cache);
+			return !context->has_error();
+		}
+
+		pw::value_container evaluate(test_object_type object) {
+			context->set_object(object);
+			pw::value_container ret = parser.evaluate(context);
+			context->clear();
+			return ret;
+		}
+		pw::value_container evaluate_tree(test_object_type object) {
+			context->set_object(object);
+			pw::value_container ret = parser.evaluate_tree(context);
+			context->clear();
+			return ret;
+		}
+		pw::batch_rows evaluate_batch(const std::vector<test_object_type> &objects) {
+			pw::batch_rows rows, matched;
+			for (std::size_t i = 0; i < objects.size(); ++i)
+				rows.push_back(i);
+			test_binder binder(context, objects);
+			parser.evaluate_batch(context, binder, rows, matched);
+			context->clear();
+			return matched;
+		}
+	};
+}
@@ -45,7 +45,8 @@ namespace po = boost::program_options;
 
 CheckDisk::CheckDisk() : show_errors_(false) {}
 
-void CheckDisk::checkDriveSize(Plugin::QueryRequestMessage::Request &request, Plugin::QueryResponseMessage::Response *response) {
+void CheckDisk::checkDriveSize(const Plugin::QueryRequestMessage::Request &legacy_request, Plugin::QueryResponseMessage::Response *response) {
+	Plugin::QueryRequestMessage::Request request(legacy_request);
 	boost::program_options::options_description desc;
 
 	std::vector<std::string> times;
@@ -112,7 +113,8 @@ void CheckDisk::check_drivesize(const Plugin::QueryRequestMessage::Request &requ
 	check_drive::check(request, response);
 }
 
-void CheckDisk::checkFiles(Plugin::QueryRequestMessage::Request &request, Plugin::QueryResponseMessage::Response *response) {
+void CheckDisk::checkFiles(const Plugin::QueryRequestMessage::Request &legacy_request, Plugin::QueryResponseMessage::Response *response) {
+	Plugin::QueryRequestMessage::Request request(legacy_request);
 	boost::program_options::options_description desc;
 
 	std::vector<std::string> times;
@@ -139,9 +139,7 @@ bool CheckEventLog::unloadModule() {
 		NSC_LOG_ERROR_STD("Failed to start collection thread");
 
 	nscapi::core_helper core(get_core(), get_id());
- 	BOOST_FOREACH(const bookmarks::map_type::value_type &v, bookmarks_.get_copy()) {
- 		core.put_storage("eventlog.bookmarks", v.first, v.second, false, false);
- 	}
+	core.put_storage("eventlog.bookmarks", bookmarks_.get_copy(), false, false);
 	return true;
 }
 
@@ -388,7 +386,8 @@ void log_args(const Plugin::QueryRequestMessage::Request &request) {
 	NSC_DEBUG_MSG("Created command: " + ss.str());
 }
 
-void CheckEventLog::CheckEventLog_(Plugin::QueryRequestMessage::Request &request, Plugin::QueryResponseMessage::Response *response) {
+void CheckEventLog::CheckEventLog_(const Plugin::QueryRequestMessage::Request &legacy_request, Plugin::QueryResponseMessage::Response *response) {
+	Plugin::QueryRequestMessage::Request request(legacy_request);
 	boost::program_options::options_description desc;
 	bool debug = false;
 	std::string filter, syntax, scan_range, top_syntax;
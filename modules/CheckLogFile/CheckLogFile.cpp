@@ -19,15 +19,23 @@
 
 #include <boost/program_options.hpp>
 #include <boost/algorithm/string.hpp>
+#include <boost/filesystem.hpp>
+#include <boost/thread.hpp>
+
+#include <limits>
 
 #include <parsers/filter/modern_filter.hpp>
 #include <parsers/filter/cli_helper.hpp>
 #include <nscapi/nscapi_settings_helper.hpp>
 #include <nscapi/nscapi_helper_singleton.hpp>
+#include <nscapi/nscapi_core_helper.hpp>
 #include <nscapi/macros.hpp>
 
+#include <str/utils.hpp>
+
 #include "CheckLogFile.h"
 #include "realtime_thread.hpp"
+#include "scan.hpp"
 
 namespace sh = nscapi::settings_helper;
 namespace po = boost::program_options;
@@ -63,6 +71,9 @@ bool CheckLogFile::loadModuleEx(std::string alias, NSCAPI::moduleLoadMode mode)
 
 	thread_->filters_.add_samples(get_settings_proxy());
 	if (mode == NSCAPI::normalStart) {
+		nscapi::core_helper core(get_core(), get_id());
+		positions_.load(core.get_storage_strings("logfile.positions"));
+
 		if (!thread_->start())
 			NSC_LOG_ERROR_STD("Failed to start collection thread");
 	}
@@ -71,9 +82,18 @@ bool CheckLogFile::loadModuleEx(std::string alias, NSCAPI::moduleLoadMode mode)
 bool CheckLogFile::unloadModule() {
 	if (thread_ && !thread_->stop())
 		NSC_LOG_ERROR_STD("Failed to stop thread");
+
+	nscapi::core_helper core(get_core(), get_id());
+	core.put_storage("logfile.positions", positions_.get_copy(), false, false);
 	return true;
 }
 
+namespace {
+	// Files larger than this are split in ranges which are scanned in parallel.
+	const boost::uintmax_t scan_range_size = 64 * 1024 * 1024;
+	const std::size_t max_scan_workers = 8;
+}
+
 void CheckLogFile::check_logfile(const Plugin::QueryRequestMessage::Request &request, Plugin::QueryResponseMessage::Response *response) {
 	typedef logfile_filter::filter filter_type;
 	modern_filter::data_container data;
@@ -81,6 +101,7 @@ void CheckLogFile::check_logfile(const Plugin::QueryRequestMessage::Request &req
 	std::string regexp, line_split, column_split;
 	std::vector<std::string> file_list;
 	std::string files_string;
+	std::string read_from;
 	std::string mode;
 
 	filter_type filter;
@@ -97,6 +118,8 @@ void CheckLogFile::check_logfile(const Plugin::QueryRequestMessage::Request &req
 			"Notice that specifying multiple files will create an aggregate set it will not check each file individually.\n"
 			"In other words if one file contains an error the entire check will result in error or if you check the count it is the global count which is used.")
 		("files", po::value<std::string>(&files_string), "A comma separated list of files to scan (same as file except a list)")
+		("read-from", po::value<std::string>(&read_from)->implicit_value("auto"), "Only read lines added since the last check with the same name (rotated and truncated files are detected). "
+			"If you set this to auto the name will be derived from your filter, warn and crit.")
 		//		("mode", po::value<std::string>(&mode),						"Mode of operation: count (count all critical/warning lines), find (find first critical/warning line)")
 		;
 
@@ -122,20 +145,60 @@ void CheckLogFile::check_logfile(const Plugin::QueryRequestMessage::Request &req
 	if (!filter_helper.build_filter(filter))
 		return;
 
+	std::string read_from_prefix;
+	if (!read_from.empty()) {
+		read_from_prefix = read_from;
+		if (read_from == "auto") {
+			read_from_prefix += ",filter[" + str::utils::joinEx(data.filter_string, ",") + "]";
+			read_from_prefix += ",warn[" + str::utils::joinEx(data.warn_string, ",") + "]";
+			read_from_prefix += ",crit[" + str::utils::joinEx(data.crit_string, ",") + "]";
+		}
+		read_from_prefix += ",";
+	}
+
+	std::vector<logfile_scan::scan_item> items;
 	BOOST_FOREACH(const std::string &filename, file_list) {
-		std::ifstream file(filename.c_str());
-		if (file.is_open()) {
-			std::string line;
-			while (file.good()) {
-				std::getline(file, line, '\n');
-				std::list<std::string> chunks = str::utils::split_lst(line, column_split);
-				boost::shared_ptr<logfile_filter::filter_obj> record(new logfile_filter::filter_obj(filename, line, chunks));
-				filter.match(record);
-			}
-			file.close();
-		} else {
-			return nscapi::protobuf::functions::set_response_bad(*response, "Failed to open file: " + filename);
+		if (!read_from_prefix.empty()) {
+			logfile_scan::scan_item item(filename, 0, 0);
+			item.key = read_from_prefix + filename;
+			logfile_tail::position_store::op_position previous = positions_.get(item.key);
+			if (previous)
+				item.position = *previous;
+			items.push_back(item);
+			continue;
+		}
+		boost::system::error_code ec;
+		boost::uintmax_t size = boost::filesystem::file_size(filename, ec);
+		if (ec || size <= scan_range_size) {
+			items.push_back(logfile_scan::scan_item(filename, 0, std::numeric_limits<boost::uintmax_t>::max()));
+			continue;
 		}
+		for (boost::uintmax_t begin = 0; begin < size; begin += scan_range_size)
+			items.push_back(logfile_scan::scan_item(filename, begin, begin + scan_range_size < size ? begin + scan_range_size : std::numeric_limits<boost::uintmax_t>::max()));
+	}
+
+	if (items.size() == 1 || !logfile_scan::can_scan_parallel(filter)) {
+		logfile_scan::scan_serial(items, filter, column_split);
+	} else {
+		std::size_t workers = std::min<std::size_t>(items.size(), std::min<std::size_t>(std::max(1u, boost::thread::hardware_concurrency()), max_scan_workers));
+		logfile_scan::scan_parallel(items, filter, column_split, boost::bind(&nscapi::core_wrapper::submit_task, get_core(), _1), workers);
+	}
+	logfile_tail::position_store::map_type changed;
+	const logfile_scan::scan_item *failed = NULL;
+	BOOST_FOREACH(const logfile_scan::scan_item &item, items) {
+		if (!item.opened) {
+			failed = &item;
+			break;
+		}
+		if (!item.key.empty() && positions_.add(item.key, item.position))
+			changed[item.key] = item.position.to_string();
+	}
+	// Written right away so a crash does not make the next check read (and alert on) everything again.
+	if (!changed.empty()) {
+		nscapi::core_helper core(get_core(), get_id());
+		core.put_storage("logfile.positions", changed, false, false);
 	}
+	if (failed)
+		return nscapi::protobuf::functions::set_response_bad(*response, "Failed to open file: " + failed->filename);
 	filter_helper.post_process(filter);
 }
\ No newline at end of file
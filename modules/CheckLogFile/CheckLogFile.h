@@ -22,10 +22,13 @@
 #include <nscapi/nscapi_protobuf.hpp>
 #include <nscapi/nscapi_plugin_impl.hpp>
 
+#include "file_tail.hpp"
+
 struct real_time_thread;
 class CheckLogFile : public nscapi::impl::simple_plugin {
 private:
 	boost::shared_ptr<real_time_thread> thread_;
+	logfile_tail::position_store positions_;
 
 public:
 	CheckLogFile() {}
@@ -0,0 +1,280 @@
+/*
+ * Copyright (C) 2004-2016 Michael Medin
+ *
+ * This file is part of NSClient++ - https://nsclient.org
+ *
+ * NSClient++ is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * NSClient++ is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with NSClient++.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "file_tail.hpp"
+
+#include <fstream>
+#include <algorithm>
+#include <cstring>
+#include <limits>
+
+#include <boost/filesystem.hpp>
+#include <boost/algorithm/string.hpp>
+
+#include <str/xtos.hpp>
+
+#ifndef WIN32
+#include <sys/stat.h>
+#endif
+
+namespace logfile_tail {
+
+	std::string file_position::to_string() const {
+		return str::xtos(device) + ":" + str::xtos(inode) + ":" + str::xtos(offset);
+	}
+
+	file_position file_position::from_string(const std::string &value) {
+		file_position ret;
+		std::vector<std::string> parts;
+		boost::split(parts, value, boost::is_any_of(":"));
+		if (parts.size() == 3) {
+			ret.device = str::stox<boost::uintmax_t>(parts[0], 0);
+			ret.inode = str::stox<boost::uintmax_t>(parts[1], 0);
+			ret.offset = str::stox<boost::uintmax_t>(parts[2], 0);
+		}
+		return ret;
+	}
+
+	// Fetches the identity of the file and uses the current size as the offset.
+	bool identify(const boost::filesystem::path &file, file_position &position) {
+#ifdef WIN32
+		// No inode to go by, rotation is detected by the file shrinking.
+		if (!boost::filesystem::exists(file))
+			return false;
+		position.device = 0;
+		position.inode = 0;
+		position.offset = boost::filesystem::file_size(file);
+#else
+		struct stat st;
+		if (stat(file.string().c_str(), &st) != 0)
+			return false;
+		position.device = st.st_dev;
+		position.inode = st.st_ino;
+		position.offset = st.st_size;
+#endif
+		return true;
+	}
+
+	const std::size_t chunk_size = 1024 * 1024;
+
+	inline std::size_t strip_cr(const std::vector<char> &chunk, std::size_t begin, std::size_t length) {
+		if (length > 0 && chunk[begin + length - 1] == '\r')
+			return length - 1;
+		return length;
+	}
+
+	// Reads the lines starting before end (a line crossing end is read in full).
+	bool read_lines(const boost::filesystem::path &file, boost::uintmax_t &offset, line_handler handler, bool include_partial, boost::uintmax_t end) {
+		std::ifstream stream(file.string().c_str(), std::ios::in | std::ios::binary);
+		if (!stream.is_open())
+			return false;
+		stream.seekg(offset);
+		chunk_type previous;
+		std::size_t carry = 0, carry_begin = 0;
+		while (true) {
+			// A line which does not fit in a chunk is moved to a new (larger) chunk.
+			chunk_type chunk(new std::vector<char>(std::max(chunk_size, carry * 2)));
+			if (carry > 0)
+				std::memcpy(&(*chunk)[0], &(*previous)[carry_begin], carry);
+			stream.read(&(*chunk)[carry], chunk->size() - carry);
+			const std::size_t available = carry + static_cast<std::size_t>(stream.gcount());
+			if (available == carry) {
+				if (carry > 0 && include_partial && offset < end) {
+					handler(chunk, 0, strip_cr(*chunk, 0, carry));
+					offset += carry;
+				}
+				break;
+			}
+			const char *data = &(*chunk)[0];
+			std::size_t pos = 0;
+			while (pos < available) {
+				if (offset >= end)
+					return true;
+				const char *eol = static_cast<const char*>(std::memchr(data + pos, '\n', available - pos));
+				if (eol == NULL)
+					break;
+				const std::size_t line_end = eol - data;
+				handler(chunk, pos, strip_cr(*chunk, pos, line_end - pos));
+				offset += line_end - pos + 1;
+				pos = line_end + 1;
+			}
+			previous = chunk;
+			carry = available - pos;
+			carry_begin = pos;
+		}
+		return true;
+	}
+
+	bool get_end_position(const boost::filesystem::path &file, file_position &position) {
+		return identify(file, position);
+	}
+
+	bool read_new_lines(const boost::filesystem::path &file, file_position &position, line_handler handler) {
+		file_position current;
+		if (!identify(file, current))
+			return false;
+		if ((position.device != 0 || position.inode != 0) && !position.is_same_file(current)) {
+			boost::filesystem::path rotated = file.string() + ".1";
+			file_position previous;
+			if (identify(rotated, previous) && previous.is_same_file(position) && position.offset < previous.offset)
+				read_lines(rotated, position.offset, handler, true, std::numeric_limits<boost::uintmax_t>::max());
+			position.offset = 0;
+		} else if (current.offset < position.offset) {
+			position.offset = 0;
+		}
+		position.device = current.device;
+		position.inode = current.inode;
+		return read_lines(file, position.offset, handler, false, std::numeric_limits<boost::uintmax_t>::max());
+	}
+
+	bool read_all_lines(const boost::filesystem::path &file, line_handler handler) {
+		boost::uintmax_t offset = 0;
+		return read_lines(file, offset, handler, true, std::numeric_limits<boost::uintmax_t>::max());
+	}
+
+	bool read_range(const boost::filesystem::path &file, boost::uintmax_t begin, boost::uintmax_t end, line_handler handler) {
+		boost::uintmax_t offset = begin;
+		if (begin > 0) {
+			// The line crossing begin belongs to the previous range
+			std::ifstream stream(file.string().c_str(), std::ios::in | std::ios::binary);
+			if (!stream.is_open())
+				return false;
+			stream.seekg(begin - 1);
+			std::string skipped;
+			std::getline(stream, skipped, '\n');
+			if (stream.eof())
+				return true;
+			offset = begin + skipped.size();
+		}
+		return read_lines(file, offset, handler, true, end);
+	}
+
+	bool match_pattern(const std::string &pattern, const std::string &name) {
+		std::size_t p = 0, n = 0, star = std::string::npos, resume = 0;
+		while (n < name.size()) {
+			if (p < pattern.size() && (pattern[p] == '?' || pattern[p] == name[n])) {
+				p++;
+				n++;
+			} else if (p < pattern.size() && pattern[p] == '*') {
+				star = p++;
+				resume = n;
+			} else if (star != std::string::npos) {
+				p = star + 1;
+				n = ++resume;
+			} else {
+				return false;
+			}
+		}
+		while (p < pattern.size() && pattern[p] == '*')
+			p++;
+		return p == pattern.size();
+	}
+
+	inline std::size_t find_split(const char *data, std::size_t length, const std::string &key, std::size_t pos) {
+		if (pos >= length)
+			return std::string::npos;
+		if (key.size() == 1) {
+			const char *p = static_cast<const char*>(std::memchr(data + pos, key[0], length - pos));
+			return p == NULL ? std::string::npos : p - data;
+		}
+		const char *p = std::search(data + pos, data + length, key.begin(), key.end());
+		return p == data + length ? std::string::npos : p - data;
+	}
+
+	// Mirrors str::utils::split_lst (which only skips the first character of the separator)
+	bool line_view::find_column(std::size_t col, std::size_t &begin, std::size_t &length) const {
+		if (col < 1)
+			return false;
+		if (!column_split_ || column_split_->empty()) {
+			begin = 0;
+			length = length_;
+			return col == 1 && length_ > 0;
+		}
+		std::size_t pos = 0, lpos = 0, current = 1;
+		while ((pos = find_split(data_, length_, *column_split_, pos)) != std::string::npos) {
+			if (current++ == col) {
+				begin = lpos;
+				length = pos - lpos;
+				return true;
+			}
+			lpos = ++pos;
+		}
+		if (current == col && lpos < length_) {
+			begin = lpos;
+			length = length_ - lpos;
+			return true;
+		}
+		return false;
+	}
+
+	bool line_view::has_column(std::size_t col) const {
+		std::size_t begin, length;
+		return find_column(col, begin, length);
+	}
+
+	std::string line_view::get_column(std::size_t col) const {
+		std::size_t begin, length;
+		if (!find_column(col, begin, length))
+			return "";
+		return std::string(data_ + begin, length);
+	}
+
+	bool position_store::add(const std::string key, const file_position &position) {
+		boost::unique_lock<boost::timed_mutex> lock(mutex_, boost::get_system_time() + boost::posix_time::seconds(5));
+		if (!lock.owns_lock()) {
+			return false;
+		}
+		std::string value = position.to_string();
+		std::string &current = positions_[key];
+		if (current == value)
+			return false;
+		current = value;
+		return true;
+	}
+
+	void position_store::load(const map_type &values) {
+		boost::unique_lock<boost::timed_mutex> lock(mutex_, boost::get_system_time() + boost::posix_time::seconds(5));
+		if (!lock.owns_lock()) {
+			return;
+		}
+		positions_.insert(values.begin(), values.end());
+	}
+
+	position_store::op_position position_store::get(const std::string key) {
+		boost::unique_lock<boost::timed_mutex> lock(mutex_, boost::get_system_time() + boost::posix_time::seconds(5));
+		if (!lock.owns_lock()) {
+			return op_position();
+		}
+		map_type::const_iterator cit = positions_.find(key);
+		if (cit == positions_.end()) {
+			return op_position();
+		}
+		return file_position::from_string(cit->second);
+	}
+
+	position_store::map_type position_store::get_copy() {
+		map_type ret;
+		boost::unique_lock<boost::timed_mutex> lock(mutex_, boost::get_system_time() + boost::posix_time::seconds(5));
+		if (!lock.owns_lock()) {
+			return ret;
+		}
+		ret.insert(positions_.begin(), positions_.end());
+		return ret;
+	}
+}
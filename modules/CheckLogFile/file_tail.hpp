@@ -0,0 +1,120 @@
+/*
+ * Copyright (C) 2004-2016 Michael Medin
+ *
+ * This file is part of NSClient++ - https://nsclient.org
+ *
+ * NSClient++ is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * NSClient++ is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with NSClient++.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include <boost/cstdint.hpp>
+#include <boost/function.hpp>
+#include <boost/optional.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/filesystem/path.hpp>
+
+namespace logfile_tail {
+
+	// Where we stopped reading a file.
+	// The device and inode identify the file so we can tell a rotated file from one which has grown.
+	struct file_position {
+		boost::uintmax_t device;
+		boost::uintmax_t inode;
+		boost::uintmax_t offset;
+
+		file_position() : device(0), inode(0), offset(0) {}
+
+		bool is_same_file(const file_position &other) const {
+			return device == other.device && inode == other.inode;
+		}
+		std::string to_string() const;
+		static file_position from_string(const std::string &value);
+	};
+
+	// Files are read in large chunks, lines refer to the chunk they were found in so nothing is copied.
+	typedef boost::shared_ptr<std::vector<char> > chunk_type;
+	typedef boost::function<void(const chunk_type &chunk, std::size_t begin, std::size_t length)> line_handler;
+
+	// A line (without the line ending) in a chunk, columns are only located when asked for.
+	// The view does not own anything: the chunk and the separator must outlive it.
+	class line_view {
+		const char *data_;
+		std::size_t length_;
+		const std::string *column_split_;
+
+	public:
+		line_view(const char *data, std::size_t length, const std::string *column_split)
+			: data_(data), length_(length), column_split_(column_split) {}
+
+		const char* data() const {
+			return data_;
+		}
+		std::size_t size() const {
+			return length_;
+		}
+		std::string str() const {
+			return std::string(data_, length_);
+		}
+		// Columns are numbered from 1 (same as str::utils::split_lst)
+		bool has_column(std::size_t col) const;
+		std::string get_column(std::size_t col) const;
+
+	private:
+		bool find_column(std::size_t col, std::size_t &begin, std::size_t &length) const;
+	};
+
+	// Sets position to the end of the file (returns false if the file does not exist).
+	bool get_end_position(const boost::filesystem::path &file, file_position &position);
+
+	// Reads all complete lines written since position and moves the position past them (a trailing partial line is left for the next read).
+	// A file which shrank (copytruncate) is read from the start, a file which was replaced is read from the start after the rest of
+	// the previous file has been read from <file>.1 (if it can be found).
+	bool read_new_lines(const boost::filesystem::path &file, file_position &position, line_handler handler);
+
+	// Reads the entire file (including a trailing partial line).
+	bool read_all_lines(const boost::filesystem::path &file, line_handler handler);
+
+	// Reads the lines which start in [begin, end) so a file can be split in ranges which are read independently.
+	bool read_range(const boost::filesystem::path &file, boost::uintmax_t begin, boost::uintmax_t end, line_handler handler);
+
+	// Matches a file name against a pattern where * matches any sequence and ? any single character.
+	bool match_pattern(const std::string &pattern, const std::string &name);
+	inline bool is_pattern(const std::string &name) {
+		return name.find_first_of("*?") != std::string::npos;
+	}
+
+	// Positions for check_logfile read-from, these are kept in the core storage between restarts.
+	class position_store {
+	public:
+		typedef boost::optional<file_position> op_position;
+		typedef std::map<std::string, std::string> map_type;
+
+	private:
+		boost::timed_mutex mutex_;
+		map_type positions_;
+
+	public:
+		// Returns true when the stored position changed.
+		bool add(const std::string key, const file_position &position);
+		void load(const map_type &values);
+		op_position get(const std::string key);
+		map_type get_copy();
+	};
+}
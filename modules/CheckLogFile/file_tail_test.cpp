@@ -0,0 +1,131 @@
+/*
+ * Copyright (C) 2004-2016 Michael Medin
+ *
+ * This file is part of NSClient++ - https://nsclient.org
+ *
+ * NSClient++ is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * NSClient++ is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with NSClient++.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "file_tail.hpp"
+
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include <boost/bind.hpp>
+#include <boost/foreach.hpp>
+
+#include <str/utils.hpp>
+
+#include <gtest/gtest.h>
+
+struct line_collector {
+	std::vector<std::string> lines;
+	void add(const logfile_tail::chunk_type &chunk, std::size_t begin, std::size_t length) {
+		lines.push_back(std::string(&(*chunk)[begin], length));
+	}
+	std::string get() {
+		std::string ret = str::utils::joinEx(lines, "|");
+		lines.clear();
+		return ret;
+	}
+};
+
+void write_file(const std::string &file, const std::string &data, bool append) {
+	std::ofstream out(file.c_str(), std::ios::out | std::ios::binary | (append ? std::ios::app : std::ios::trunc));
+	out << data;
+}
+
+TEST(LogfileTailTest, columns_match_split_lst) {
+	const char* lines[] = { "", "a", "a\tb\tc", "a\t\tc\t", "\ta", "a::b::c" };
+	const char* splits[] = { "\t", "::" };
+	BOOST_FOREACH(const char *split, splits) {
+		std::string column_split = split;
+		BOOST_FOREACH(const char *l, lines) {
+			std::string line = l;
+			std::vector<std::string> expected = str::utils::split<std::vector<std::string> >(line, column_split);
+			logfile_tail::line_view view(line.c_str(), line.size(), &column_split);
+			for (std::size_t i = 0; i < 6; i++) {
+				EXPECT_EQ(i >= 1 && i <= expected.size(), view.has_column(i)) << line << " column " << i;
+				EXPECT_EQ(i >= 1 && i <= expected.size() ? expected[i - 1] : "", view.get_column(i)) << line << " column " << i;
+			}
+		}
+	}
+}
+
+TEST(LogfileTailTest, reads_complete_lines_only) {
+	std::string file = "logfile_tail_test.log";
+	line_collector c;
+	write_file(file, "a\r\nb\npart", false);
+	logfile_tail::file_position position;
+	ASSERT_TRUE(logfile_tail::read_new_lines(file, position, boost::bind(&line_collector::add, &c, _1, _2, _3)));
+	EXPECT_EQ("a|b", c.get());
+	write_file(file, "ial\nc\n", true);
+	logfile_tail::read_new_lines(file, position, boost::bind(&line_collector::add, &c, _1, _2, _3));
+	EXPECT_EQ("partial|c", c.get());
+	logfile_tail::file_position copy = logfile_tail::file_position::from_string(position.to_string());
+	logfile_tail::read_new_lines(file, copy, boost::bind(&line_collector::add, &c, _1, _2, _3));
+	EXPECT_EQ("", c.get());
+	logfile_tail::read_all_lines(file, boost::bind(&line_collector::add, &c, _1, _2, _3));
+	EXPECT_EQ("a|b|partial|c", c.get());
+	std::remove(file.c_str());
+}
+
+TEST(LogfileTailTest, detects_truncate_and_rotate) {
+	std::string file = "logfile_tail_test.log", rotated = file + ".1";
+	std::remove(rotated.c_str());
+	line_collector c;
+	write_file(file, "a\nb\nc\n", false);
+	logfile_tail::file_position position;
+	logfile_tail::read_new_lines(file, position, boost::bind(&line_collector::add, &c, _1, _2, _3));
+	EXPECT_EQ("a|b|c", c.get());
+
+	write_file(file, "d\n", false);
+	logfile_tail::read_new_lines(file, position, boost::bind(&line_collector::add, &c, _1, _2, _3));
+	EXPECT_EQ("d", c.get());
+
+#ifndef WIN32
+	write_file(file, "e", true);
+	std::rename(file.c_str(), rotated.c_str());
+	write_file(file, "f\n", false);
+	logfile_tail::read_new_lines(file, position, boost::bind(&line_collector::add, &c, _1, _2, _3));
+	EXPECT_EQ("e|f", c.get());
+	std::remove(rotated.c_str());
+#endif
+	std::remove(file.c_str());
+}
+
+TEST(LogfileTailTest, ranges_cover_each_line_once) {
+	std::string file = "logfile_tail_test.log";
+	std::string data = "aa\nb\n\nccc\ndd\ne";
+	write_file(file, data, false);
+	line_collector c;
+	for (std::size_t size = 1; size <= data.size(); size++) {
+		for (std::size_t begin = 0; begin < data.size(); begin += size)
+			ASSERT_TRUE(logfile_tail::read_range(file, begin, begin + size, boost::bind(&line_collector::add, &c, _1, _2, _3)));
+		EXPECT_EQ("aa|b||ccc|dd|e", c.get()) << "range size " << size;
+	}
+	std::remove(file.c_str());
+}
+
+TEST(LogfileTailTest, match_pattern) {
+	EXPECT_TRUE(logfile_tail::match_pattern("*.log", "app.log"));
+	EXPECT_TRUE(logfile_tail::match_pattern("app-?.log", "app-1.log"));
+	EXPECT_TRUE(logfile_tail::match_pattern("a*b*c", "aXbYbc"));
+	EXPECT_TRUE(logfile_tail::match_pattern("*", ""));
+	EXPECT_FALSE(logfile_tail::match_pattern("*.log", "app.log.1"));
+	EXPECT_FALSE(logfile_tail::match_pattern("app-?.log", "app-10.log"));
+	EXPECT_FALSE(logfile_tail::match_pattern("app.log", "app.lo"));
+}
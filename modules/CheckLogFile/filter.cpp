@@ -19,9 +19,12 @@
 
 #include <map>
 #include <list>
+#include <algorithm>
 
 #include <boost/bind.hpp>
 #include <boost/assign.hpp>
+#include <boost/make_shared.hpp>
+#include <boost/foreach.hpp>
 
 #include <parsers/where.hpp>
 
@@ -58,11 +61,68 @@ logfile_filter::filter_obj_handler::filter_obj_handler() {
 		("column7", boost::bind(&filter_obj::get_column, _1, 7), boost::bind(&filter_obj::get_column_number, _1, 7), "The value in the 7:th column")
 		("column8", boost::bind(&filter_obj::get_column, _1, 8), boost::bind(&filter_obj::get_column_number, _1, 8), "The value in the 8:th column")
 		("column9", boost::bind(&filter_obj::get_column, _1, 9), boost::bind(&filter_obj::get_column_number, _1, 9), "The value in the 9:th column")
-		("filename", boost::bind(&filter_obj::filename, _1), "The name of the file")
-		("file", boost::bind(&filter_obj::filename, _1), "The name of the file")
+		("filename", boost::bind(&filter_obj::get_filename, _1), "The name of the file")
+		("file", boost::bind(&filter_obj::get_filename, _1), "The name of the file")
 		;
 
 	registry_.add_string_fun()
 		("column", &get_column_fun, "Fetch the value from the given column number.\nSyntax: column(<coulmn number>)")
 		;
-}
\ No newline at end of file
+}
+
+//////////////////////////////////////////////////////////////////////////
+
+void logfile_filter::record_batch::add(const logfile_tail::chunk_type &chunk, std::size_t begin, std::size_t length) {
+	if (skip_empty && length == 0)
+		return;
+	if (!block) {
+		block = boost::make_shared<record_block>(filename, column_split);
+		block->objects.reserve(1024);
+	}
+	if (block->chunks.empty() || block->chunks.back() != chunk)
+		block->chunks.push_back(chunk);
+	block->objects.push_back(filter_obj(&block->filename, logfile_tail::line_view(&(*chunk)[begin], length, &block->column_split)));
+	if (block->objects.size() >= 1024)
+		flush();
+}
+
+modern_filter::match_result logfile_filter::record_batch::flush() {
+	if (!block)
+		return result;
+	std::vector<boost::shared_ptr<filter_obj> > records;
+	records.reserve(block->objects.size());
+	BOOST_FOREACH(filter_obj &o, block->objects) {
+		records.push_back(boost::shared_ptr<filter_obj>(block, &o));
+	}
+	block.reset();
+	if (!collect) {
+		result.append(filter_.match_batch(records));
+		return result;
+	}
+	parsers::where::batch_rows matched;
+	filter_.filter_batch(records, matched);
+	collect->push_back(filtered_batch());
+	filtered_batch &batch = collect->back();
+	batch.count = records.size();
+	if (matched.empty())
+		return result;
+	std::size_t size = 0;
+	BOOST_FOREACH(std::size_t i, matched) {
+		size += records[i]->line.size();
+	}
+	boost::shared_ptr<record_block> copy = boost::make_shared<record_block>(filename, column_split);
+	copy->chunks.push_back(boost::make_shared<std::vector<char> >(size + 1));
+	copy->objects.reserve(matched.size());
+	char *data = &(*copy->chunks.front())[0];
+	BOOST_FOREACH(std::size_t i, matched) {
+		const logfile_tail::line_view &line = records[i]->line;
+		std::copy(line.data(), line.data() + line.size(), data);
+		copy->objects.push_back(filter_obj(&copy->filename, logfile_tail::line_view(data, line.size(), &copy->column_split)));
+		data += line.size();
+	}
+	batch.matched.reserve(copy->objects.size());
+	BOOST_FOREACH(filter_obj &o, copy->objects) {
+		batch.matched.push_back(boost::shared_ptr<filter_obj>(copy, &o));
+	}
+	return result;
+}
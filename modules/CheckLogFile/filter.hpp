@@ -20,6 +20,7 @@
 #pragma once
 
 #include <map>
+#include <list>
 #include <string>
 
 #include <parsers/where.hpp>
@@ -34,32 +35,31 @@
 #include <parsers/filter/modern_filter.hpp>
 #include <parsers/where/filter_handler_impl.hpp>
 
+#include "file_tail.hpp"
+
 namespace logfile_filter {
 	struct filter_obj {
-		std::string filename;
-		std::string line;
-		std::vector<std::string> chunks;
+		const std::string *filename;
+		logfile_tail::line_view line;
 		typedef parsers::where::node_type node_type;
-		filter_obj(std::string filename, std::string line, std::list<std::string> chunks) : filename(filename), line(line), chunks(chunks.begin(), chunks.end()) {}
+		filter_obj(const std::string *filename, const logfile_tail::line_view &line) : filename(filename), line(line) {}
 
 		std::string get_column(std::size_t col) const {
-			if (col >= 1 && col <= chunks.size())
-				return chunks[col - 1];
-			return "";
+			return line.get_column(col);
 		}
 		long long get_column_number(std::size_t col) const {
-			if (col >= 1 && col <= chunks.size())
-				return str::stox<long long>(chunks[col - 1]);
+			if (line.has_column(col))
+				return str::stox<long long>(line.get_column(col));
 			return 0;
 		}
 		std::string get_filename() const {
-			return filename;
+			return *filename;
 		}
 		std::string get_line() const {
-			return line;
+			return line.str();
 		}
 		node_type get_column_fun(parsers::where::value_type target_type, parsers::where::evaluation_context context, const node_type subject);
-		std::string to_string() const { return filename; }
+		std::string to_string() const { return *filename; }
 	};
 
 	typedef parsers::where::filter_handler_impl<boost::shared_ptr<filter_obj> > native_context;
@@ -68,4 +68,41 @@ namespace logfile_filter {
 	};
 
 	typedef modern_filter::modern_filters<filter_obj, filter_obj_handler> filter;
+
+	// The lines of a batch and the chunks they refer to.
+	// The records handed to the filter share ownership of the block so no line is copied.
+	struct record_block {
+		std::string filename;
+		std::string column_split;
+		std::vector<logfile_tail::chunk_type> chunks;
+		std::vector<filter_obj> objects;
+
+		record_block(const std::string &filename, const std::string &column_split) : filename(filename), column_split(column_split) {}
+	};
+
+	// A batch which has only been through the filter expression (see record_batch::collect).
+	// The matched lines are copied so the chunks of the batch can be released.
+	struct filtered_batch {
+		std::size_t count;
+		std::vector<boost::shared_ptr<filter_obj> > matched;
+
+		filtered_batch() : count(0) {}
+	};
+	typedef std::list<filtered_batch> filtered_batches;
+
+	// Collects the lines of a file and matches them in batches.
+	// If collect is set the batches are only filtered and appended there to be replayed (in order) on another filter.
+	struct record_batch {
+		filter &filter_;
+		std::string filename;
+		std::string column_split;
+		bool skip_empty;
+		filtered_batches *collect;
+		boost::shared_ptr<record_block> block;
+		modern_filter::match_result result;
+
+		record_batch(filter &filter_, const std::string &filename, const std::string &column_split, bool skip_empty, filtered_batches *collect = NULL) : filter_(filter_), filename(filename), column_split(column_split), skip_empty(skip_empty), collect(collect) {}
+		void add(const logfile_tail::chunk_type &chunk, std::size_t begin, std::size_t length);
+		modern_filter::match_result flush();
+	};
 }
\ No newline at end of file
@@ -0,0 +1,154 @@
+/*
+ * Copyright (C) 2004-2016 Michael Medin
+ *
+ * This file is part of NSClient++ - https://nsclient.org
+ *
+ * NSClient++ is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * NSClient++ is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with NSClient++.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "file_tail.hpp"
+
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <list>
+#include <cstdio>
+#include <cstdlib>
+
+#include <boost/bind.hpp>
+#include <boost/make_shared.hpp>
+#include <boost/date_time/posix_time/posix_time.hpp>
+
+#include <str/utils.hpp>
+#include <str/xtos.hpp>
+
+namespace pt = boost::posix_time;
+
+// The record as it used to be built (a copy of the line and all columns).
+struct legacy_record {
+	std::string filename;
+	std::string line;
+	std::vector<std::string> chunks;
+	legacy_record(std::string filename, std::string line, std::list<std::string> chunks) : filename(filename), line(line), chunks(chunks.begin(), chunks.end()) {}
+};
+
+// Same layout as logfile_filter::record_block
+struct record {
+	const std::string *filename;
+	logfile_tail::line_view line;
+	record(const std::string *filename, const logfile_tail::line_view &line) : filename(filename), line(line) {}
+};
+struct record_block {
+	std::string filename;
+	std::string split;
+	std::vector<logfile_tail::chunk_type> chunks;
+	std::vector<record> objects;
+	record_block() : filename("test.log"), split("\t") {}
+};
+
+struct counter {
+	long long lines;
+	long long hits;
+	bool use_column;
+	boost::shared_ptr<record_block> block;
+
+	counter(bool use_column) : lines(0), hits(0), use_column(use_column) {}
+
+	void add(const logfile_tail::chunk_type &chunk, std::size_t begin, std::size_t length) {
+		if (!block) {
+			block = boost::make_shared<record_block>();
+			block->objects.reserve(1024);
+		}
+		if (block->chunks.empty() || block->chunks.back() != chunk)
+			block->chunks.push_back(chunk);
+		block->objects.push_back(record(&block->filename, logfile_tail::line_view(&(*chunk)[begin], length, &block->split)));
+		if (block->objects.size() >= 1024)
+			flush();
+	}
+	void flush() {
+		if (!block)
+			return;
+		std::vector<boost::shared_ptr<record> > records;
+		records.reserve(block->objects.size());
+		for (std::size_t i = 0; i < block->objects.size(); ++i)
+			records.push_back(boost::shared_ptr<record>(block, &block->objects[i]));
+		block.reset();
+		for (std::size_t i = 0; i < records.size(); ++i) {
+			lines++;
+			if (use_column ? records[i]->line.get_column(2) == "ERROR" : records[i]->line.size() > 80)
+				hits++;
+		}
+	}
+};
+
+void legacy_read(const std::string &file, bool use_column, long long &lines, long long &hits) {
+	std::ifstream stream(file.c_str());
+	std::string line;
+	std::vector<boost::shared_ptr<legacy_record> > records;
+	while (stream.good()) {
+		std::getline(stream, line, '\n');
+		records.push_back(boost::shared_ptr<legacy_record>(new legacy_record(file, line, str::utils::split_lst(line, "\t"))));
+		if (records.size() >= 1024 || !stream.good()) {
+			for (std::size_t i = 0; i < records.size(); ++i) {
+				lines++;
+				const legacy_record &r = *records[i];
+				if (use_column ? (r.chunks.size() >= 2 && r.chunks[1] == "ERROR") : r.line.size() > 80)
+					hits++;
+			}
+			records.clear();
+		}
+	}
+}
+
+void benchmark(const std::string &file, long long size_mb, bool use_column) {
+	long long legacy_lines = 0, legacy_hits = 0;
+	pt::ptime start = pt::microsec_clock::universal_time();
+	legacy_read(file, use_column, legacy_lines, legacy_hits);
+	long long legacy_ms = (pt::microsec_clock::universal_time() - start).total_milliseconds();
+
+	counter c(use_column);
+	start = pt::microsec_clock::universal_time();
+	logfile_tail::read_all_lines(file, boost::bind(&counter::add, &c, _1, _2, _3));
+	c.flush();
+	long long chunked_ms = (pt::microsec_clock::universal_time() - start).total_milliseconds();
+
+	std::cout << (use_column ? "column2 = 'ERROR'" : "line only") << std::endl;
+	std::cout << "  getline/split: " << legacy_ms << "ms, " << (legacy_ms > 0 ? size_mb * 1000 / legacy_ms : 0) << "MB/s (" << legacy_hits << " of " << legacy_lines << " lines)" << std::endl;
+	std::cout << "  chunked/lazy:  " << chunked_ms << "ms, " << (chunked_ms > 0 ? size_mb * 1000 / chunked_ms : 0) << "MB/s (" << c.hits << " of " << c.lines << " lines)" << std::endl;
+	std::cout << "  speedup:       " << (chunked_ms > 0 ? static_cast<double>(legacy_ms) / chunked_ms : 0.0) << "x" << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+	long long size_mb = 1024;
+	if (argc > 1)
+		size_mb = std::atol(argv[1]);
+	std::string file = argc > 2 ? argv[2] : "logfile_benchmark.log";
+
+	{
+		const char *levels[] = { "INFO", "DEBUG", "WARNING", "ERROR" };
+		std::ofstream out(file.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+		long long written = 0;
+		for (long long i = 0; written < size_mb * 1024 * 1024; i++) {
+			std::string line = "2016-01-01 12:00:" + str::xtos(i % 60) + "\t" + levels[i % 4] + "\tcomponent-" + str::xtos(i % 17) + "\tProcessed request " + str::xtos(i) + " for user " + str::xtos(i % 1000) + (i % 3 == 0 ? " with a somewhat longer message attached to it" : "") + "\n";
+			out << line;
+			written += line.size();
+		}
+	}
+	std::cout << "Reading " << size_mb << "MB synthetic log" << std::endl;
+	benchmark(file, size_mb, false);
+	benchmark(file, size_mb, true);
+	std::remove(file.c_str());
+	return 0;
+}
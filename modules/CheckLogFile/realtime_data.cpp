@@ -25,6 +25,7 @@
 #include <str/utils.hpp>
 
 #include <boost/foreach.hpp>
+#include <boost/bind.hpp>
 #include <boost/filesystem.hpp>
 
 
@@ -66,7 +67,28 @@ bool runtime_data::has_changed(const file_container &fc) const {
 }
 
 
-bool runtime_data::has_changed(transient_data_type) const {
+bool runtime_data::is_watched(const std::string &file) const {
+	BOOST_FOREACH(const file_container &fc, files) {
+		if (fc.file.string() == file)
+			return true;
+	}
+	boost::filesystem::path path = file;
+	BOOST_FOREACH(const boost::filesystem::path &pattern, patterns) {
+		if (pattern.parent_path() == path.parent_path() && logfile_tail::match_pattern(pattern.filename().string(), path.filename().string()))
+			return true;
+	}
+	return false;
+}
+
+bool runtime_data::has_changed(transient_data_type data) const {
+	if (data && !data->changed_files.empty()) {
+		// The watcher told us which files changed so we do not need to look at the others.
+		BOOST_FOREACH(const std::string &file, data->changed_files) {
+			if (is_watched(file))
+				return true;
+		}
+		return false;
+	}
 	BOOST_FOREACH(const file_container &fc, files) {
 		if (has_changed(fc)) {
 			return true;
@@ -76,13 +98,34 @@ bool runtime_data::has_changed(transient_data_type) const {
 }
 
 void runtime_data::add_file(const boost::filesystem::path &path) {
+	if (!logfile_tail::is_pattern(path.filename().string())) {
+		add_file(path, false);
+		return;
+	}
+	patterns.push_back(path);
+	boost::filesystem::path folder = path.parent_path().empty() ? boost::filesystem::path(".") : path.parent_path();
+	try {
+		if (!boost::filesystem::is_directory(folder))
+			return;
+		boost::filesystem::directory_iterator end;
+		for (boost::filesystem::directory_iterator it(folder); it != end; ++it) {
+			std::string name = it->path().filename().string();
+			if (boost::filesystem::is_regular_file(it->status()) && logfile_tail::match_pattern(path.filename().string(), name))
+				add_file(path.parent_path() / name, false);
+		}
+	} catch (const std::exception &e) {
+		NSC_LOG_ERROR("Failed to list " + folder.string() + ": " + utf8::utf8_from_native(e.what()));
+	}
+}
+
+void runtime_data::add_file(const boost::filesystem::path &path, bool from_start) {
 	try {
 		file_container fc;
-		if (boost::filesystem::exists(path)) {
-			fc.file = path;
-			fc.size = boost::filesystem::file_size(fc.file);
+		fc.file = path;
+		// Only lines written after we started are processed (unless the file was created after we started)
+		if (!from_start && logfile_tail::get_end_position(fc.file, fc.position)) {
+			fc.size = fc.position.offset;
 		} else {
-			fc.file = path;
 			fc.size = 0;
 		}
 		files.push_back(fc);
@@ -91,40 +134,67 @@ void runtime_data::add_file(const boost::filesystem::path &path) {
 	}
 }
 
-modern_filter::match_result runtime_data::process_item(filter_type &filter, transient_data_type) {
+std::list<boost::filesystem::path> runtime_data::get_folders() const {
+	std::list<boost::filesystem::path> ret;
+	BOOST_FOREACH(const file_container &fc, files) {
+		ret.push_back(fc.file.parent_path());
+	}
+	BOOST_FOREACH(const boost::filesystem::path &pattern, patterns) {
+		ret.push_back(pattern.parent_path());
+	}
+	return ret;
+}
+
+modern_filter::match_result runtime_data::process_item(filter_type &filter, transient_data_type data) {
 	modern_filter::match_result ret;
-	BOOST_FOREACH(file_container &c, files) {
-		boost::uintmax_t sz = boost::filesystem::file_size(c.file);
-		if (sz == 0) {
-			NSC_TRACE_ENABLED() {
-				NSC_TRACE_MSG("File was zero, no point in reading it: " + c.file.string());
+	const bool known_changes = data && !data->changed_files.empty();
+	if (known_changes) {
+		BOOST_FOREACH(const std::string &file, data->changed_files) {
+			if (!is_watched(file))
+				continue;
+			bool found = false;
+			BOOST_FOREACH(const file_container &fc, files) {
+				if (fc.file.string() == file) {
+					found = true;
+					break;
+				}
 			}
-			continue;
-		}
-		if (!has_changed(c)) {
-			NSC_TRACE_ENABLED() {
-				NSC_TRACE_MSG("File was unchanged, no point in reading it: " + c.file.string());
+			if (!found) {
+				NSC_DEBUG_MSG("Found new file: " + file);
+				add_file(file, true);
 			}
-			continue;
 		}
-		c.time = boost::filesystem::last_write_time(c.file);
-		c.size = sz;
-
-		std::ifstream file(c.file.string().c_str());
-		if (file.is_open()) {
-			std::string line;
-			if (!read_from_start && sz > c.size)
-				file.seekg(c.size);
-			while (file.good()) {
-				std::getline(file, line, '\n');
-				if (!line.empty()) {
-					std::list<std::string> chunks = str::utils::split_lst(line, utf8::cvt<std::string>(column_split));
-					boost::shared_ptr<logfile_filter::filter_obj> record(new logfile_filter::filter_obj(c.file.string(), line, chunks));
-					ret.append(filter.match(record));
+	}
+	BOOST_FOREACH(file_container &c, files) {
+		if (known_changes) {
+			if (data->changed_files.find(c.file.string()) == data->changed_files.end())
+				continue;
+		} else {
+			boost::uintmax_t sz = boost::filesystem::file_size(c.file);
+			if (sz == 0) {
+				NSC_TRACE_ENABLED() {
+					NSC_TRACE_MSG("File was zero, no point in reading it: " + c.file.string());
 				}
+				continue;
 			}
-			file.close();
-		} else {
+			if (!has_changed(c)) {
+				NSC_TRACE_ENABLED() {
+					NSC_TRACE_MSG("File was unchanged, no point in reading it: " + c.file.string());
+				}
+				continue;
+			}
+			c.time = boost::filesystem::last_write_time(c.file);
+			c.size = sz;
+		}
+
+		if (read_from_start)
+			c.position.offset = 0;
+		logfile_filter::record_batch batch(filter, c.file.string(), utf8::cvt<std::string>(column_split), true);
+		if (logfile_tail::read_new_lines(c.file, c.position, boost::bind(&logfile_filter::record_batch::add, &batch, _1, _2, _3))) {
+			if (known_changes)
+				c.size = c.position.offset;
+			ret.append(batch.flush());
+		} else if (!known_changes) {
 			NSC_LOG_ERROR("Failed to open file: " + c.file.string());
 		}
 	}
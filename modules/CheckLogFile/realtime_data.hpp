@@ -19,15 +19,22 @@
 
 #pragma once
 #include <list>
+#include <set>
 
 #include <boost/filesystem/path.hpp>
 
+#include <str/utils.hpp>
+
 #include "filter.hpp"
+#include "file_tail.hpp"
 
 struct runtime_data {
 	struct transient_data_impl {
 		std::string path_;
+		// The files the watcher reported as changed (when empty all files are checked)
+		std::set<std::string> changed_files;
 		transient_data_impl(std::string path) : path_(path) {}
+		transient_data_impl(const std::set<std::string> &changed_files) : path_(str::utils::joinEx(changed_files, ", ")), changed_files(changed_files) {}
 		std::string to_string() const { return path_; }
 	};
 	typedef logfile_filter::filter filter_type;
@@ -37,10 +44,13 @@ struct runtime_data {
 		boost::filesystem::path file;
 		boost::uintmax_t size;
 		std::time_t time;
+		logfile_tail::file_position position;
 		file_container() : size(0), time(0) {}
 	};
 
 	std::list<file_container> files;
+	// Wildcard patterns (i.e. /var/log/app-*.log), files matching these are added as they are created.
+	std::list<boost::filesystem::path> patterns;
 	std::string column_split;
 	std::string line_split;
 	bool read_from_start;
@@ -56,6 +66,9 @@ struct runtime_data {
 	void set_comparison(bool check_time_);
 
 	void add_file(const boost::filesystem::path &path);
+	std::list<boost::filesystem::path> get_folders() const;
 private:
 	bool has_changed(const file_container &fc) const;
+	bool is_watched(const std::string &file) const;
+	void add_file(const boost::filesystem::path &path, bool from_start);
 };
\ No newline at end of file
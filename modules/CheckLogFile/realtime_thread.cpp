@@ -36,10 +36,12 @@
 #include <boost/filesystem.hpp>
 
 #include <map>
+#include <set>
 #include <vector>
 #include <time.h>
 
 #ifndef WIN32
+#include <errno.h>
 #include <poll.h>
 #include <sys/inotify.h>
 #endif
@@ -70,15 +72,14 @@ void real_time_thread::thread_proc() {
 					continue;
 				}
 			}
-#else
-			if (boost::filesystem::is_regular(path)) {
-				logs.push_back(path.string());
-			} else {
-				NSC_LOG_ERROR("Failed to find folder for " + object->get_alias() + ": " + path.string());
-				continue;
-			}
 #endif
 		}
+#ifndef WIN32
+		// Watching the folders lets us see files which are created or rotated after we started.
+		BOOST_FOREACH(const boost::filesystem::path &folder, data.get_folders()) {
+			logs.push_back(folder.string());
+		}
+#endif
 		helper.add_item(object, data, "logfile");
 	}
 
@@ -96,9 +97,14 @@ void real_time_thread::thread_proc() {
 
 	struct pollfd pollfds[2] = { { inotify_init(), POLLIN | POLLPRI, 0}, { stop_event_[0], POLLIN, 0} };
 
-	int *wds = new int[logs.size()];
-	for (std::size_t i = 0; i < files_list.size(); i++) {
-		wds[i] = inotify_add_watch(pollfds[0].fd, files_list[i].c_str(), IN_MODIFY);
+	std::map<int, boost::filesystem::path> watches;
+	BOOST_FOREACH(const std::string &folder, files_list) {
+		int wd = inotify_add_watch(pollfds[0].fd, folder.empty() ? "." : folder.c_str(), IN_CREATE | IN_MOVED_TO | IN_MODIFY | IN_CLOSE_WRITE);
+		if (wd < 0) {
+			NSC_LOG_ERROR("Failed to watch folder " + folder + ": " + error::lookup::last_error(errno));
+		} else {
+			watches[wd] = folder;
+		}
 	}
 
 #endif
@@ -134,6 +140,8 @@ void real_time_thread::thread_proc() {
 		if (dur)
 			timeout = dur->total_milliseconds();
 		char buffer[BUF_LEN];
+		std::set<std::string> changed_files;
+		bool overflow = false;
 		int length = poll(pollfds, 2, timeout);
 		if (!length) {
 			continue;
@@ -146,12 +154,24 @@ void real_time_thread::thread_proc() {
 			length = read(pollfds[0].fd, buffer, BUF_LEN);
 			for (int j = 0; j < length;) {
 				struct inotify_event * event = (struct inotify_event *) &buffer[j];
-				trigger_folder = event->name;
+				std::map<int, boost::filesystem::path>::const_iterator it = watches.find(event->wd);
+				if (event->mask & IN_Q_OVERFLOW)
+					overflow = true;
+				else if (event->len > 0 && it != watches.end())
+					changed_files.insert((it->second / event->name).string());
 				j += EVENT_SIZE + event->len;
 			}
+			// Events for files we do not monitor (the folders can be shared with other files)
+			if (changed_files.empty() && !overflow)
+				continue;
 		} else {
 			NSC_LOG_ERROR("Strange, please report this...");
 		}
+		// When events were lost we do not know what changed so all files are checked
+		if (!overflow && !changed_files.empty()) {
+			helper.process_items(boost::shared_ptr<runtime_data::transient_data_impl>(new runtime_data::transient_data_impl(changed_files)));
+			continue;
+		}
 #endif
 		helper.process_items(boost::shared_ptr<runtime_data::transient_data_impl>(new runtime_data::transient_data_impl(trigger_folder)));
 
@@ -160,8 +180,8 @@ void real_time_thread::thread_proc() {
 #ifdef WIN32
 	delete[] handles;
 #else
-	for (std::size_t i = 0; i < files_list.size(); i++) {
-		inotify_rm_watch(pollfds[0].fd, wds[i]);
+	for (std::map<int, boost::filesystem::path>::const_iterator it = watches.begin(); it != watches.end(); ++it) {
+		inotify_rm_watch(pollfds[0].fd, it->first);
 	}
 	close(pollfds[0].fd);
 	//close(pollfds[1].fd);
@@ -0,0 +1,125 @@
+/*
+ * Copyright (C) 2004-2016 Michael Medin
+ *
+ * This file is part of NSClient++ - https://nsclient.org
+ *
+ * NSClient++ is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * NSClient++ is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with NSClient++.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+
+#include <boost/bind.hpp>
+#include <boost/foreach.hpp>
+#include <boost/make_shared.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/condition_variable.hpp>
+
+#include "scan.hpp"
+
+namespace {
+	void scan(logfile_scan::scan_item &item, logfile_filter::filter &filter, const std::string &column_split, logfile_filter::filtered_batches *collect) {
+		logfile_filter::record_batch batch(filter, item.filename, column_split, false, collect);
+		logfile_tail::line_handler handler = boost::bind(&logfile_filter::record_batch::add, &batch, _1, _2, _3);
+		if (!item.key.empty())
+			item.opened = logfile_tail::read_new_lines(item.filename, item.position, handler);
+		else
+			item.opened = logfile_tail::read_range(item.filename, item.begin, item.end, handler);
+		batch.flush();
+	}
+
+	// The job owns the items since a task can start after scan_parallel has returned (if it was queued behind other work).
+	struct scan_job {
+		std::vector<logfile_scan::scan_item> items;
+		std::vector<boost::shared_ptr<logfile_filter::filter> > filters;
+		std::string column_split;
+		boost::mutex mutex;
+		boost::condition_variable done_cond;
+		std::size_t next;
+		std::size_t done;
+
+		scan_job(const std::string &column_split) : column_split(column_split), next(0), done(0) {}
+
+		// Scans items (using the filter of the worker) until there are none left.
+		void run(std::size_t worker) {
+			while (true) {
+				std::size_t i;
+				{
+					boost::mutex::scoped_lock lock(mutex);
+					if (next >= items.size())
+						return;
+					i = next++;
+				}
+				try {
+					scan(items[i], *filters[worker], column_split, &items[i].batches);
+				} catch (...) {
+					// Anything escaping here would leave wait() blocked forever.
+					items[i].opened = false;
+				}
+				boost::mutex::scoped_lock lock(mutex);
+				if (++done == items.size())
+					done_cond.notify_all();
+			}
+		}
+
+		// Waits for all items and hands them back.
+		void wait(std::vector<logfile_scan::scan_item> &result) {
+			boost::mutex::scoped_lock lock(mutex);
+			while (done < items.size())
+				done_cond.wait(lock);
+			result.swap(items);
+		}
+	};
+
+	void run_job(boost::shared_ptr<scan_job> job, std::size_t worker) {
+		job->run(worker);
+	}
+}
+
+bool logfile_scan::can_scan_parallel(logfile_filter::filter &filter) {
+	return !filter.has_unique_index && !filter.filter_uses_summary();
+}
+
+void logfile_scan::scan_serial(std::vector<scan_item> &items, logfile_filter::filter &filter, const std::string &column_split) {
+	BOOST_FOREACH(scan_item &item, items) {
+		scan(item, filter, column_split, NULL);
+	}
+}
+
+void logfile_scan::scan_parallel(std::vector<scan_item> &items, logfile_filter::filter &filter, const std::string &column_split, executor_type executor, std::size_t workers) {
+	boost::shared_ptr<scan_job> job = boost::make_shared<scan_job>(column_split);
+	for (std::size_t i = 0; i < std::max<std::size_t>(workers, 1); i++) {
+		boost::shared_ptr<logfile_filter::filter> copy(new logfile_filter::filter());
+		if (!filter.copy_filter(*copy))
+			break;
+		job->filters.push_back(copy);
+	}
+	if (job->filters.empty())
+		return scan_serial(items, filter, column_split);
+
+	job->items.swap(items);
+	for (std::size_t i = 1; i < job->filters.size(); i++) {
+		if (!executor || !executor(boost::bind(&run_job, job, i)))
+			break;
+	}
+	job->run(0);
+	job->wait(items);
+
+	// Process the matches in file order so the summary is the same as when scanning serially
+	BOOST_FOREACH(scan_item &item, items) {
+		BOOST_FOREACH(const logfile_filter::filtered_batch &batch, item.batches) {
+			filter.replay_batch(batch.count, batch.matched);
+		}
+		item.batches.clear();
+	}
+}
@@ -0,0 +1,63 @@
+/*
+ * Copyright (C) 2004-2016 Michael Medin
+ *
+ * This file is part of NSClient++ - https://nsclient.org
+ *
+ * NSClient++ is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * NSClient++ is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with NSClient++.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include <boost/cstdint.hpp>
+#include <boost/function.hpp>
+
+#include "file_tail.hpp"
+#include "filter.hpp"
+
+namespace logfile_scan {
+
+	// A file (or a range of a large file) to scan.
+	// Items with a key are read from position (which is updated) otherwise the lines starting in [begin, end) are read.
+	struct scan_item {
+		std::string filename;
+		boost::uintmax_t begin;
+		boost::uintmax_t end;
+		std::string key;
+		logfile_tail::file_position position;
+		logfile_filter::filtered_batches batches;
+		bool opened;
+
+		scan_item(const std::string &filename, boost::uintmax_t begin, boost::uintmax_t end) : filename(filename), begin(begin), end(end), opened(false) {}
+	};
+
+	typedef boost::function<void()> task_type;
+	// Runs a task in the background returning false if it could not be queued.
+	typedef boost::function<bool(task_type)> executor_type;
+
+	// True if the items can be scanned by scan_parallel and give the same result as scan_serial.
+	// A unique index or a filter expression using the summary depend on the records before them.
+	bool can_scan_parallel(logfile_filter::filter &filter);
+
+	// Scans the items in order matching all lines against the filter.
+	void scan_serial(std::vector<scan_item> &items, logfile_filter::filter &filter, const std::string &column_split);
+
+	// Scans the items using up to workers tasks on the executor.
+	// The tasks only evaluate the filter expression (on copies of it) and the matching lines are then processed in order
+	// on filter so the result is the same as for scan_serial.
+	// The caller scans items as well so this finishes even if the executor never gets around to running the tasks.
+	void scan_parallel(std::vector<scan_item> &items, logfile_filter::filter &filter, const std::string &column_split, executor_type executor, std::size_t workers);
+}
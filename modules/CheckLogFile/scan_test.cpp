@@ -0,0 +1,126 @@
+/*
+ * Copyright (C) 2004-2016 Michael Medin
+ *
+ * This file is part of NSClient++ - https://nsclient.org
+ *
+ * NSClient++ is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * NSClient++ is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with NSClient++.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "scan.hpp"
+
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include <boost/bind.hpp>
+#include <boost/thread.hpp>
+
+#include <nscapi/nscapi_helper_singleton.hpp>
+#include <str/xtos.hpp>
+
+#include <gtest/gtest.h>
+
+nscapi::helper_singleton* nscapi::plugin_singleton = new nscapi::helper_singleton();
+
+struct thread_executor {
+	boost::thread_group threads;
+	bool submit(logfile_scan::task_type task) {
+		threads.create_thread(task);
+		return true;
+	}
+};
+
+bool reject_task(logfile_scan::task_type) {
+	return false;
+}
+
+bool build_filter(logfile_filter::filter &filter, const std::string &filter_string, const std::string &warn, const std::string &crit) {
+	std::string error;
+	if (!filter.build_syntax(false, "${count}/${total} (${problem_list})", "${column1}", "${column1}", "", "", "%(status): Nothing found", error))
+		return false;
+	if (!filter.build_engines(false, filter_string, "", warn, crit))
+		return false;
+	if (!filter.validate(error))
+		return false;
+	filter.start_match();
+	return true;
+}
+
+std::string get_result(logfile_filter::filter &filter) {
+	filter.match_post();
+	return str::xtos(filter.summary.returnCode) + ": " + filter.get_message();
+}
+
+// Writes 5000 lines and returns them as parts ranges.
+std::vector<logfile_scan::scan_item> write_items(const std::string &file, std::size_t parts) {
+	std::string data;
+	for (int i = 0; i < 5000; i++)
+		data += str::xtos(i) + "\t" + (i % 7 == 0 ? "ERROR" : i % 5 == 0 ? "WARN" : "INFO") + "\n";
+	std::ofstream out(file.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+	out << data;
+	out.close();
+	std::vector<logfile_scan::scan_item> items;
+	std::size_t size = data.size() / parts + 1;
+	for (std::size_t begin = 0; begin < data.size(); begin += size)
+		items.push_back(logfile_scan::scan_item(file, begin, begin + size));
+	return items;
+}
+
+std::string scan_serial(const std::string &file, const std::string &filter_string, const std::string &warn, const std::string &crit) {
+	logfile_filter::filter filter;
+	EXPECT_TRUE(build_filter(filter, filter_string, warn, crit));
+	std::vector<logfile_scan::scan_item> items = write_items(file, 1);
+	logfile_scan::scan_serial(items, filter, "\t");
+	return get_result(filter);
+}
+
+std::string scan_parallel(const std::string &file, const std::string &filter_string, const std::string &warn, const std::string &crit, logfile_scan::executor_type executor) {
+	logfile_filter::filter filter;
+	EXPECT_TRUE(build_filter(filter, filter_string, warn, crit));
+	EXPECT_TRUE(logfile_scan::can_scan_parallel(filter));
+	std::vector<logfile_scan::scan_item> items = write_items(file, 7);
+	logfile_scan::scan_parallel(items, filter, "\t", executor, 4);
+	for (std::size_t i = 0; i < items.size(); i++)
+		EXPECT_TRUE(items[i].opened);
+	return get_result(filter);
+}
+
+TEST(LogfileScanTest, parallel_matches_serial_with_summary_in_warn_and_crit) {
+	std::string file = "logfile_scan_test.log";
+	std::string filter = "column2 != 'INFO'";
+	std::string warn = "column2 = 'WARN' and count > 20";
+	std::string crit = "column2 = 'ERROR' and count > 500";
+	std::string expected = scan_serial(file, filter, warn, crit);
+	EXPECT_NE(std::string::npos, expected.find("/5000"));
+
+	thread_executor threads;
+	EXPECT_EQ(expected, scan_parallel(file, filter, warn, crit, boost::bind(&thread_executor::submit, &threads, _1)));
+	threads.threads.join_all();
+	EXPECT_EQ(expected, scan_parallel(file, filter, warn, crit, &reject_task));
+	std::remove(file.c_str());
+}
+
+TEST(LogfileScanTest, filters_depending_on_previous_records_are_serial) {
+	logfile_filter::filter summary_filter;
+	ASSERT_TRUE(build_filter(summary_filter, "column2 != 'INFO' and count < 10", "", ""));
+	EXPECT_FALSE(logfile_scan::can_scan_parallel(summary_filter));
+
+	logfile_filter::filter unique_filter;
+	ASSERT_TRUE(build_filter(unique_filter, "column2 != 'INFO'", "", ""));
+	EXPECT_TRUE(logfile_scan::can_scan_parallel(unique_filter));
+	std::string error;
+	ASSERT_TRUE(unique_filter.build_index("${column2}", error));
+	EXPECT_FALSE(logfile_scan::can_scan_parallel(unique_filter));
+}
@@ -518,7 +518,8 @@ int CheckSystem::commandLineExec(const int target_mode, const std::string &comma
 	return NSCAPI::cmd_return_codes::returnIgnored;
 }
 
-void CheckSystem::checkCpu(Plugin::QueryRequestMessage::Request &request, Plugin::QueryResponseMessage::Response *response) {
+void CheckSystem::checkCpu(const Plugin::QueryRequestMessage::Request &legacy_request, Plugin::QueryResponseMessage::Response *response) {
+	Plugin::QueryRequestMessage::Request request(legacy_request);
 	boost::program_options::options_description desc;
 
 	std::vector<std::string> times;
@@ -605,7 +606,8 @@ ULONGLONG nscpGetTickCount64() {
 	return pGetTickCount64();
 }
 
-void CheckSystem::checkUptime(Plugin::QueryRequestMessage::Request &request, Plugin::QueryResponseMessage::Response *response) {
+void CheckSystem::checkUptime(const Plugin::QueryRequestMessage::Request &legacy_request, Plugin::QueryResponseMessage::Response *response) {
+	Plugin::QueryRequestMessage::Request request(legacy_request);
 	boost::program_options::options_description desc;
 
 	nscapi::program_options::add_help(desc);
@@ -699,7 +701,8 @@ void CheckSystem::check_network(const Plugin::QueryRequestMessage::Request &requ
 	network_check::check::check_network(request, response, collector->get_network());
 }
 
-void CheckSystem::checkServiceState(Plugin::QueryRequestMessage::Request &request, Plugin::QueryResponseMessage::Response *response) {
+void CheckSystem::checkServiceState(const Plugin::QueryRequestMessage::Request &legacy_request, Plugin::QueryResponseMessage::Response *response) {
+	Plugin::QueryRequestMessage::Request request(legacy_request);
 	boost::program_options::options_description desc;
 	std::vector<std::string> excludes;
 
@@ -863,7 +866,8 @@ void CheckSystem::check_pagefile(const Plugin::QueryRequestMessage::Request &req
 	filter_helper.post_process(filter);
 }
 
-void CheckSystem::checkMem(Plugin::QueryRequestMessage::Request &request, Plugin::QueryResponseMessage::Response *response) {
+void CheckSystem::checkMem(const Plugin::QueryRequestMessage::Request &legacy_request, Plugin::QueryResponseMessage::Response *response) {
+	Plugin::QueryRequestMessage::Request request(legacy_request);
 	boost::program_options::options_description desc;
 
 	std::vector<std::string> types;
@@ -912,7 +916,8 @@ void CheckSystem::check_memory(const Plugin::QueryRequestMessage::Request &reque
 	memory_checks::memory::check(request, response);
 }
 
-void CheckSystem::checkProcState(Plugin::QueryRequestMessage::Request &request, Plugin::QueryResponseMessage::Response *response) {
+void CheckSystem::checkProcState(const Plugin::QueryRequestMessage::Request &legacy_request, Plugin::QueryResponseMessage::Response *response) {
+	Plugin::QueryRequestMessage::Request request(legacy_request);
 	boost::program_options::options_description desc;
 	std::vector<std::string> excludes;
 
@@ -981,7 +986,8 @@ void CheckSystem::check_process(const Plugin::QueryRequestMessage::Request &requ
 	process_checks::active::check(request, response);
 }
 
-void CheckSystem::checkCounter(Plugin::QueryRequestMessage::Request &request, Plugin::QueryResponseMessage::Response *response) {
+void CheckSystem::checkCounter(const Plugin::QueryRequestMessage::Request &legacy_request, Plugin::QueryResponseMessage::Response *response) {
+	Plugin::QueryRequestMessage::Request request(legacy_request);
 	boost::program_options::options_description desc;
 
 	std::vector<std::string> counters;
@@ -246,12 +246,12 @@ void CheckSystem::check_memory(const Plugin::QueryRequestMessage::Request &reque
 		return nscapi::protobuf::functions::set_response_bad(*response, e.what());
 	}
 
+	std::vector<boost::shared_ptr<check_mem_filter::filter_obj> > records;
 	BOOST_FOREACH(const std::string &type, types) {
 		bool found = false;
 		BOOST_FOREACH(const check_mem_filter::filter_obj &o, mem_data) {
 			if (o.type == type) {
-				boost::shared_ptr<check_mem_filter::filter_obj> record(new check_mem_filter::filter_obj(o));
-				filter.match(record);
+				records.push_back(boost::shared_ptr<check_mem_filter::filter_obj>(new check_mem_filter::filter_obj(o)));
 				found = true;
 				break;
 			}
@@ -260,6 +260,7 @@ void CheckSystem::check_memory(const Plugin::QueryRequestMessage::Request &reque
 			return nscapi::protobuf::functions::set_response_bad(*response, "Invalid type: " + type);
 		}
 	}
+	filter.match_batch(records);
 
 	filter_helper.post_process(filter);
 }
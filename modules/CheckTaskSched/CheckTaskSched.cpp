@@ -58,7 +58,8 @@ void log_args(const Plugin::QueryRequestMessage::Request &request) {
 	NSC_DEBUG_MSG("Created command: " + ss.str());
 }
 
-void CheckTaskSched::CheckTaskSched_(Plugin::QueryRequestMessage::Request &request, Plugin::QueryResponseMessage::Response *response) {
+void CheckTaskSched::CheckTaskSched_(const Plugin::QueryRequestMessage::Request &legacy_request, Plugin::QueryResponseMessage::Response *response) {
+	Plugin::QueryRequestMessage::Request request(legacy_request);
 	boost::program_options::options_description desc;
 
 	std::vector<std::string> counters;
@@ -34,10 +34,11 @@
 namespace nrpe_client {
 	struct connection_data : public socket_helpers::connection_info {
 		int buffer_length;
+		int keep_alive;
 		std::string encoding;
 		boost::shared_ptr<socket_helpers::client::client_handler> handler;
 
-		connection_data(client::destination_container source, client::destination_container target, boost::shared_ptr<socket_helpers::client::client_handler> handler) : buffer_length(0), handler(handler) {
+		connection_data(client::destination_container source, client::destination_container target, boost::shared_ptr<socket_helpers::client::client_handler> handler) : buffer_length(0), keep_alive(0), handler(handler) {
 			address = target.address.host;
 			port_ = target.address.get_port_string("5666");
 
@@ -69,6 +70,7 @@ namespace nrpe_client {
 			timeout = target.timeout;
 			retry = target.retry;
 			buffer_length = target.get_int_data("payload length", 1024);
+			keep_alive = target.get_int_data("keep alive", 0);
 			encoding = target.get_string_data("encoding");
 
 			if (target.has_data("no ssl"))
@@ -81,6 +83,7 @@ namespace nrpe_client {
 			std::stringstream ss;
 			ss << "host: " << get_endpoint_string();
 			ss << ", buffer_length: " << buffer_length;
+			ss << ", keep_alive: " << keep_alive;
 			ss << ", ssl: " << ssl.to_string();
 			return ss.str();
 		}
@@ -105,6 +108,7 @@ namespace nrpe_client {
 	template<class TCoreHandler = client_handler>
 	struct nrpe_client_handler : public client::handler_interface {
 		boost::shared_ptr<TCoreHandler> handler_;
+		socket_helpers::client::client_pool<nrpe::client::protocol> pool_;
 		nrpe_client_handler() : handler_(boost::make_shared<TCoreHandler>()) {}
 
 		std::string get_command(std::string alias, std::string command = "") {
@@ -206,10 +210,19 @@ namespace nrpe_client {
 					encoded_data = utf8::to_encoding(utf8::cvt<std::wstring>(data), con.encoding);
 				}
 				nrpe::packet packet = nrpe::packet::make_request(encoded_data, con.buffer_length);
-				socket_helpers::client::client<nrpe::client::protocol> client(con, handler_);
-				client.connect();
-				std::list<nrpe::packet> responses = client.process_request(packet);
-				client.shutdown();
+				std::list<nrpe::packet> responses;
+				if (con.keep_alive > 0) {
+					// Connections are only shared between targets which would have negotiated them the same way.
+					const std::string key = con.get_endpoint_string() + "/" + str::xtos(con.buffer_length) + (con.ssl.enabled ? "/ssl|" + con.ssl.get_session_key() : "");
+					socket_helpers::client::client_pool<nrpe::client::protocol>::client_ptr client = pool_.acquire(key, con, handler_, nrpe::packet::make_keep_alive_request(con.buffer_length));
+					responses = client->process_request(packet);
+					pool_.release(key, client, con.keep_alive);
+				} else {
+					socket_helpers::client::client<nrpe::client::protocol> client(con, handler_);
+					client.connect();
+					responses = client.process_request(packet);
+					client.shutdown();
+				}
 				int result = NSCAPI::query_return_codes::returnUNKNOWN;
 				std::string payload;
 				if (responses.size() > 0)
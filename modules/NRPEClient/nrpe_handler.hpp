@@ -43,6 +43,7 @@ namespace nrpe_handler {
 			set_property_bool("insecure", false);
 			set_property_bool("ssl", true);
 			set_property_int("payload length", 1024);
+			set_property_int("keep alive", 0);
 		}
 
 		nrpe_target_object(const nscapi::settings_objects::object_instance other, std::string alias, std::string path) : parent(other, alias, path) {}
@@ -63,6 +64,9 @@ namespace nrpe_handler {
 
 				("payload length", sh::int_fun_key(boost::bind(&parent::set_property_int, this, "payload length", _1)),
 					"PAYLOAD LENGTH", "Length of payload to/from the NRPE agent. This is a hard specific value so you have to \"configure\" (read recompile) your NRPE agent to use the same value for it to work.")
+
+				("keep alive", sh::int_fun_key(boost::bind(&parent::set_property_int, this, "keep alive", _1)),
+					"KEEP ALIVE", "Seconds to keep the connection open for the next request (0 disables keep-alive). The server has to support keep-alive (NSClient++ with idle timeout set) and this should be less than its idle timeout.", true)
 				;
 			settings.register_all();
 			settings.notify();
@@ -110,6 +114,9 @@ namespace nrpe_handler {
 				("payload-length,l", po::value<unsigned int>()->notifier(boost::bind(&client::destination_container::set_int_data, &target, "payload length", _1)),
 					"Length of payload (has to be same as on the server)")
 
+				("keep-alive", po::value<unsigned int>()->notifier(boost::bind(&client::destination_container::set_int_data, &target, "keep alive", _1)),
+					"Seconds to keep the connection open for the next request (requires a server with keep-alive enabled)")
+
 				("buffer-length", po::value<unsigned int>()->notifier(boost::bind(&client::destination_container::set_int_data, &target, "payload length", _1)),
 					"Length of payload to/from the NRPE agent. This is a hard specific value so you have to \"configure\" (read recompile) your NRPE agent to use the same value for it to work.")
 				;
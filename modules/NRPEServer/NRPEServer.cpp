@@ -33,13 +33,14 @@
 
 namespace sh = nscapi::settings_helper;
 
-NRPEServer::NRPEServer() {}
+NRPEServer::NRPEServer() : max_concurrent_(0), queue_depth_(0), active_(0) {}
 NRPEServer::~NRPEServer() {}
 
 bool NRPEServer::loadModuleEx(std::string alias, NSCAPI::moduleLoadMode mode) {
 	try {
 		if (server_) {
 			server_->stop();
+			workers_.stop();
 			server_.reset();
 		}
 	} catch (...) {
@@ -79,6 +80,15 @@ bool NRPEServer::loadModuleEx(std::string alias, NSCAPI::moduleLoadMode mode) {
 		("performance data", sh::bool_fun_key(boost::bind(&NRPEServer::set_perf_data, this, _1), true),
 			"PERFORMANCE DATA", "Send performance data back to nagios (set this to 0 to remove all performance data).", true)
 
+		("max concurrent", sh::uint_key(&max_concurrent_, 10),
+			"MAXIMUM CONCURRENT CHECKS", "Number of checks which are run at the same time (0 runs checks on the network threads).", true)
+
+		("queue depth", sh::uint_key(&queue_depth_, 100),
+			"QUEUE DEPTH", "Number of requests which can wait for a check to finish, when the queue is full requests are answered with UNKNOWN: overloaded.", true)
+
+		("idle timeout", sh::uint_key(&info_.idle_timeout, 0),
+			"IDLE TIMEOUT", "Seconds to keep a connection open for the next request when the client asks for keep-alive (0 disables keep-alive).", true)
+
 		;
 
 	socket_helpers::settings_helper::add_core_server_opts(settings, info_);
@@ -128,6 +138,8 @@ bool NRPEServer::loadModuleEx(std::string alias, NSCAPI::moduleLoadMode mode) {
 
 		boost::asio::io_service io_service_;
 
+		if (max_concurrent_ > 0)
+			workers_.start(max_concurrent_);
 		server_.reset(new nrpe::server::server(info_, this));
 		if (!server_) {
 			NSC_LOG_ERROR_STD("Failed to create server instance!");
@@ -142,6 +154,7 @@ bool NRPEServer::unloadModule() {
 	try {
 		if (server_) {
 			server_->stop();
+			workers_.stop();
 			server_.reset();
 		}
 	} catch (...) {
@@ -153,6 +166,58 @@ bool NRPEServer::unloadModule() {
 
 
 
+void NRPEServer::handle_async(nrpe::packet p, response_callback callback) {
+	// _NRPE_CHECK is answered right away so it still works when we are busy
+	if (max_concurrent_ == 0 || !workers_.is_running() || str::utils::getToken(p.getPayload(), '!').first == "_NRPE_CHECK") {
+		callback(handle(p));
+		return;
+	}
+	{
+		boost::mutex::scoped_lock lock(load_mutex_);
+		if (active_ < max_concurrent_ + queue_depth_) {
+			active_++;
+			lock.unlock();
+			if (workers_.submit(boost::bind(&NRPEServer::run_async, this, p, callback)))
+				return;
+			lock.lock();
+			active_--;
+		}
+	}
+	NSC_LOG_ERROR("Too many concurrent requests, rejecting: " + str::utils::getToken(p.getPayload(), '!').first);
+	std::list<nrpe::packet> packets;
+	packets.push_back(nrpe::packet::create_response(NSCAPI::query_return_codes::returnUNKNOWN, "UNKNOWN: overloaded", p.get_payload_length()));
+	callback(packets);
+}
+
+void NRPEServer::run_async(nrpe::packet p, response_callback callback) {
+	std::list<nrpe::packet> packets;
+	try {
+		packets = handle(p);
+	} catch (const std::exception &e) {
+		packets.push_back(create_error("Exception processing request: " + utf8::utf8_from_native(e.what())));
+	} catch (...) {
+		packets.push_back(create_error("Exception processing request"));
+	}
+	{
+		boost::mutex::scoped_lock lock(load_mutex_);
+		active_--;
+	}
+	callback(packets);
+}
+
+void NRPEServer::fetchMetrics(Plugin::MetricsMessage::Response *response) {
+	if (!server_)
+		return;
+	Plugin::Common::MetricsBundle *bundle = response->add_bundles();
+	bundle->set_key("nrpe");
+	Plugin::Common::Metric *m = bundle->add_value();
+	m->set_key("handshakes.full");
+	m->mutable_value()->set_int_data(server_->get_full_handshakes());
+	m = bundle->add_value();
+	m->set_key("handshakes.resumed");
+	m->mutable_value()->set_int_data(server_->get_resumed_handshakes());
+}
+
 std::list<nrpe::packet> NRPEServer::handle(nrpe::packet p) {
 	std::list<nrpe::packet> packets;
 	str::utils::token cmd = str::utils::getToken(p.getPayload(), '!');
@@ -19,9 +19,13 @@
 
 #include <nrpe/server/protocol.hpp>
 #include <nscapi/nscapi_targets.hpp>
+#include <nscapi/nscapi_protobuf.hpp>
 #include <nscapi/nscapi_plugin_impl.hpp>
 #include <nrpe/packet.hpp>
 #include <nrpe/server/handler.hpp>
+#include <threads/work_stealing_pool.hpp>
+
+#include <boost/thread/mutex.hpp>
 
 class NRPEServer : public nscapi::impl::simple_plugin, nrpe::server::handler {
 private:
@@ -31,6 +35,8 @@ private:
 	bool allowArgs_;
 	bool multiple_packets_;
 	std::string encoding_;
+	unsigned int max_concurrent_;
+	unsigned int queue_depth_;
 
 	void set_perf_data(bool v) {
 		noPerfData_ = !v;
@@ -44,9 +50,12 @@ public:
 	// Module calls
 	bool loadModuleEx(std::string alias, NSCAPI::moduleLoadMode mode);
 	bool unloadModule();
+	void fetchMetrics(Plugin::MetricsMessage::Response *response);
 
 	// Handler
 	std::list<nrpe::packet> handle(nrpe::packet packet);
+	void handle_async(nrpe::packet packet, response_callback callback);
+	void run_async(nrpe::packet packet, response_callback callback);
 
 	nrpe::packet create_error(std::string msg) {
 		return nrpe::packet::create_response(3, msg, payload_length_);
@@ -69,4 +78,8 @@ public:
 private:
 	socket_helpers::connection_info info_;
 	boost::shared_ptr<nrpe::server::server> server_;
+	// Checks are run here instead of on the I/O threads of the server
+	nscp_thread::work_stealing_pool workers_;
+	boost::mutex load_mutex_;
+	std::size_t active_;
 };
@@ -118,6 +118,19 @@ bool NSCAServer::unloadModule() {
 	return true;
 }
 
+void NSCAServer::fetchMetrics(Plugin::MetricsMessage::Response *response) {
+	if (!server_)
+		return;
+	Plugin::Common::MetricsBundle *bundle = response->add_bundles();
+	bundle->set_key("nsca");
+	Plugin::Common::Metric *m = bundle->add_value();
+	m->set_key("handshakes.full");
+	m->mutable_value()->set_int_data(server_->get_full_handshakes());
+	m = bundle->add_value();
+	m->set_key("handshakes.resumed");
+	m->mutable_value()->set_int_data(server_->get_resumed_handshakes());
+}
+
 void NSCAServer::handle(nsca::packet p) {
 	std::string response;
 	std::string::size_type pos = p.result.find('|');
@@ -19,6 +19,7 @@
 
 
 #include <nsca/server/protocol.hpp>
+#include <nscapi/nscapi_protobuf.hpp>
 #include <nscapi/nscapi_plugin_impl.hpp>
 
 class NSCAServer : public nscapi::impl::simple_plugin, nsca::server::handler {
@@ -49,6 +50,7 @@ public:
 	// Module calls
 	bool loadModuleEx(std::string alias, NSCAPI::moduleLoadMode mode);
 	bool unloadModule();
+	void fetchMetrics(Plugin::MetricsMessage::Response *response);
 
 	// handler
 	void handle(nsca::packet packet);
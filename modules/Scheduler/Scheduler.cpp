@@ -26,6 +26,8 @@
 #include <nscapi/nscapi_protobuf_nagios.hpp>
 #include <nscapi/macros.hpp>
 
+#include <str/xtos.hpp>
+
 namespace sh = nscapi::settings_helper;
 
 bool Scheduler::loadModuleEx(std::string alias, NSCAPI::moduleLoadMode mode) {
@@ -33,10 +35,12 @@ bool Scheduler::loadModuleEx(std::string alias, NSCAPI::moduleLoadMode mode) {
 		scheduler_.prepare_shutdown();
 		scheduler_.unset_handler();
 		scheduler_.stop();
+		batcher_.stop();
 		schedules_.clear();
 	}
 
 
+	bool shared_workers = false, spread = false, coalesce = false;
 	sh::settings_registry settings(get_settings_proxy());
 	settings.set_alias(alias, "scheduler");
 	schedules_.set_path(settings.alias().get_settings_path("schedules"));
@@ -49,6 +53,19 @@ bool Scheduler::loadModuleEx(std::string alias, NSCAPI::moduleLoadMode mode) {
 	settings.alias().add_key_to_settings()
 		("threads", sh::int_fun_key(boost::bind(&schedules::scheduler::set_threads, &scheduler_, _1), 5),
 			"Threads", "Number of threads to use.")
+		("max threads", sh::int_fun_key(boost::bind(&schedules::scheduler::set_max_threads, &scheduler_, _1), 10),
+			"Maximum threads", "Number of threads the scheduler is allowed to grow to when items are running late.")
+		("shared workers", sh::bool_key(&shared_workers, false),
+			"Use shared workers", "Run the scheduled items on the shared worker pool in the core instead of dedicated threads.")
+		("spread", sh::bool_key(&spread, false),
+			"Spread schedules", "Run each interval schedule at a fixed offset into its interval (derived from the alias) instead of using randomness. "
+			"This spreads the load evenly and each schedule keeps its slot across reloads and restarts.")
+		("coalesce", sh::bool_key(&coalesce, false),
+			"Coalesce schedules", "Run schedules with the same command, arguments and interval once and send the result to each of them.")
+		("batch size", sh::int_fun_key(boost::bind(&schedules::submit_batcher::set_max_size, &batcher_, _1), 1),
+			"Batch size", "Maximum number of results to send in one submission to a channel, 1 sends each result as soon as it is ready.")
+		("batch latency", sh::string_fun_key(boost::bind(&schedules::submit_batcher::set_max_latency, &batcher_, _1), "1s"),
+			"Batch latency", "Maximum time a result is held back waiting for a batch to fill up, 0 sends each result as soon as it is ready.")
 		;
 
 	settings.alias().add_path_to_settings()
@@ -75,9 +92,21 @@ bool Scheduler::loadModuleEx(std::string alias, NSCAPI::moduleLoadMode mode) {
 	settings.register_all();
 	settings.notify();
 
+	if (shared_workers && !get_core()->can_submit_tasks()) {
+		NSC_LOG_ERROR("The core does not have a shared worker pool, using dedicated threads");
+		shared_workers = false;
+	}
+	if (shared_workers)
+		scheduler_.set_executor(boost::bind(&nscapi::core_wrapper::submit_task, get_core(), _1));
+	else
+		scheduler_.set_executor(simple_scheduler::scheduler::executor_type());
+
 	schedules_.ensure_default();
 	schedules_.add_samples(get_settings_proxy());
 
+	scheduler_.set_spread(spread);
+	scheduler_.set_coalesce(coalesce);
+	std::list<schedules::target_object> targets;
 	BOOST_FOREACH(const schedules::schedule_handler::object_list_type::value_type &o, schedules_.get_object_list()) {
 		if (o->duration && (*o->duration).total_seconds() == 0) {
 			NSC_LOG_ERROR("WE cant add schedules with 0 duration: " + o->to_string());
@@ -92,9 +121,11 @@ bool Scheduler::loadModuleEx(std::string alias, NSCAPI::moduleLoadMode mode) {
 			continue;
 		}
 		NSC_DEBUG_MSG("Adding scheduled item: " + o->to_string());
-		scheduler_.add_task(o);
+		targets.push_back(o);
 	}
+	scheduler_.add_tasks(targets);
 
+	batcher_.start();
 	if (mode == NSCAPI::normalStart) {
 		scheduler_.set_handler(this);
 		scheduler_.start();
@@ -120,6 +151,7 @@ bool Scheduler::unloadModule() {
 	scheduler_.prepare_shutdown();
 	scheduler_.unset_handler();
 	scheduler_.stop();
+	batcher_.stop();
 	schedules_.clear();
 	return true;
 }
@@ -134,47 +166,29 @@ void Scheduler::on_trace(const char* file, int line, std::string msg) {
 #include <nscapi/functions.hpp>
 
 
-bool Scheduler::handle_schedule(schedules::target_object item) {
+bool Scheduler::handle_schedule(const schedules::target_list &items) {
+	if (items.empty())
+		return true;
+	const schedules::target_object &first = items.front();
 	try {
 		std::string response;
 		nscapi::core_helper ch(get_core(), get_id());
-		if (!ch.simple_query(item->command.c_str(), item->arguments, response)) {
-			NSC_LOG_ERROR("Failed to execute: " + item->command);
-			if (item->channel.empty()) {
-				NSC_LOG_ERROR_WA("No channel specified for ", item->get_alias());
-				return true;
+		if (!ch.simple_query(first->command.c_str(), first->arguments, response)) {
+			NSC_LOG_ERROR("Failed to execute: " + first->command);
+			BOOST_FOREACH(const schedules::target_object &item, items) {
+				if (item->channel.empty()) {
+					NSC_LOG_ERROR_WA("No channel specified for ", item->get_alias());
+					continue;
+				}
+				std::string request, result;
+				nscapi::protobuf::functions::create_simple_submit_request(item->channel, item->command, NSCAPI::query_return_codes::returnUNKNOWN, "Command was not found: " + item->command, "", request);
+				get_core()->submit_message(item->channel, request, result);
 			}
-			nscapi::protobuf::functions::create_simple_submit_request(item->channel, item->command, NSCAPI::query_return_codes::returnUNKNOWN, "Command was not found: " + item->command, "", response);
-			std::string result;
-			get_core()->submit_message(item->channel, response, result);
 			return true;
 		}
-		Plugin::QueryResponseMessage resp_msg;
-		resp_msg.ParseFromString(response);
-		Plugin::QueryResponseMessage resp_msg_send;
-		resp_msg_send.mutable_header()->CopyFrom(resp_msg.header());
-		BOOST_FOREACH(const Plugin::QueryResponseMessage::Response &p, resp_msg.payload()) {
-			if (nscapi::report::matches(item->report, nscapi::protobuf::functions::gbp_to_nagios_status(p.result())))
-				resp_msg_send.add_payload()->CopyFrom(p);
-		}
-		if (resp_msg_send.payload_size() > 0) {
-			if (item->channel.empty()) {
-				NSC_LOG_ERROR_STD("No channel specified for " + item->get_alias() + " mssage will not be sent.");
-				return true;
-			}
-			nscapi::protobuf::functions::make_submit_from_query(response, item->channel, item->get_alias(), item->target_id, item->source_id);
-			std::string result;
-			if (!get_core()->submit_message(item->channel, response, result)) {
-				NSC_LOG_ERROR_STD("Failed to submit: " + item->get_alias());
-				return true;
-			}
-			std::string error;
-			if (!nscapi::protobuf::functions::parse_simple_submit_response(result, error)) {
-				NSC_LOG_ERROR_STD("Failed to submit " + item->get_alias() + ": " + error);
-				return true;
-			}
-		} else {
-			NSC_DEBUG_MSG("Filter not matched for: " + item->get_alias() + " so nothing is reported");
+		// Coalesced schedules share the result but each of them filters and submits it on its own
+		BOOST_FOREACH(const schedules::target_object &item, items) {
+			submit_result(item, response);
 		}
 		return true;
 	} catch (nsclient::nsclient_exception &e) {
@@ -184,11 +198,68 @@ bool Scheduler::handle_schedule(schedules::target_object item) {
 		NSC_LOG_ERROR_EXR("Exception: ", e);
 		return false;
 	} catch (...) {
-		NSC_LOG_ERROR_EX(item->get_alias());
+		NSC_LOG_ERROR_EX(first->get_alias());
 		return false;
 	}
 }
 
+void Scheduler::submit_result(const schedules::target_object &item, std::string response) {
+	Plugin::QueryResponseMessage resp_msg;
+	resp_msg.ParseFromString(response);
+	Plugin::QueryResponseMessage resp_msg_send;
+	resp_msg_send.mutable_header()->CopyFrom(resp_msg.header());
+	BOOST_FOREACH(const Plugin::QueryResponseMessage::Response &p, resp_msg.payload()) {
+		if (nscapi::report::matches(item->report, nscapi::protobuf::functions::gbp_to_nagios_status(p.result())))
+			resp_msg_send.add_payload()->CopyFrom(p);
+	}
+	if (resp_msg_send.payload_size() > 0) {
+		if (item->channel.empty()) {
+			NSC_LOG_ERROR_STD("No channel specified for " + item->get_alias() + " mssage will not be sent.");
+			return;
+		}
+		nscapi::protobuf::functions::make_submit_from_query(response, item->channel, item->get_alias(), item->target_id, item->source_id);
+		if (batcher_.is_enabled()) {
+			batcher_.add(item->channel, response);
+			return;
+		}
+		std::string result;
+		if (!get_core()->submit_message(item->channel, response, result)) {
+			NSC_LOG_ERROR_STD("Failed to submit: " + item->get_alias());
+			return;
+		}
+		std::string error;
+		if (!nscapi::protobuf::functions::parse_simple_submit_response(result, error)) {
+			NSC_LOG_ERROR_STD("Failed to submit " + item->get_alias() + ": " + error);
+			return;
+		}
+	} else {
+		NSC_DEBUG_MSG("Filter not matched for: " + item->get_alias() + " so nothing is reported");
+	}
+}
+
+void Scheduler::submit_batch(const std::string &channel, const Plugin::SubmitRequestMessage &request) {
+	try {
+		std::string result;
+		if (!get_core()->submit_message(channel, request.SerializeAsString(), result)) {
+			NSC_LOG_ERROR_STD("Failed to submit " + str::xtos(request.payload_size()) + " results to " + channel);
+			return;
+		}
+		Plugin::SubmitResponseMessage response;
+		response.ParseFromString(result);
+		for (int i = 0; i < response.payload_size(); ++i) {
+			const Plugin::SubmitResponseMessage::Response &p = response.payload(i);
+			if (p.result().code() != Plugin::Common_Result_StatusCodeType_STATUS_OK) {
+				std::string alias = i < request.payload_size() && response.payload_size() == request.payload_size() ? request.payload(i).alias() : channel;
+				NSC_LOG_ERROR_STD("Failed to submit " + alias + ": " + p.result().message());
+			}
+		}
+	} catch (const std::exception &e) {
+		NSC_LOG_ERROR_EXR("Failed to submit batch to " + channel, e);
+	} catch (...) {
+		NSC_LOG_ERROR_EX("Failed to submit batch to " + channel);
+	}
+}
+
 void Scheduler::fetchMetrics(Plugin::MetricsMessage::Response *response) {
 	Plugin::Common::MetricsBundle *bundle = response->add_bundles();
 	bundle->set_key("scheduler");
@@ -200,6 +271,8 @@ void Scheduler::fetchMetrics(Plugin::MetricsMessage::Response *response) {
 		boost::uint64_t queue = scheduler_.get_scheduler().get_metric_ql();
 		boost::uint64_t avgtime = scheduler_.get_scheduler().get_avg_time();
 		boost::uint64_t rate = scheduler_.get_scheduler().get_metric_rate();
+		boost::uint64_t lag = scheduler_.get_scheduler().get_metric_lag();
+		boost::uint64_t max_lag = scheduler_.get_scheduler().get_metric_max_lag();
 
 		Plugin::Common::Metric *m = bundle->add_value();
 		m->set_key("jobs");
@@ -222,6 +295,12 @@ void Scheduler::fetchMetrics(Plugin::MetricsMessage::Response *response) {
 		m = bundle->add_value();
 		m->set_key("rate");
 		m->mutable_value()->set_int_data(rate);
+		m = bundle->add_value();
+		m->set_key("lag");
+		m->mutable_value()->set_int_data(lag);
+		m = bundle->add_value();
+		m->set_key("maxlag");
+		m->mutable_value()->set_int_data(max_lag);
 	} else {
 		Plugin::Common::Metric *m = bundle->add_value();
 		m->set_key("metrics.available");
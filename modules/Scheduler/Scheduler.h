@@ -20,6 +20,7 @@
 #include <nscapi/nscapi_plugin_impl.hpp>
 #include <scheduler/simple_scheduler.hpp>
 #include "schedules_handler.hpp"
+#include "submit_batcher.hpp"
 
 typedef schedules::schedule_handler::object_instance schedule_instance;
 class Scheduler : public schedules::task_handler, public nscapi::impl::simple_plugin {
@@ -27,10 +28,12 @@ private:
 
 	schedules::scheduler scheduler_;
 	schedules::schedule_handler schedules_;
+	schedules::submit_batcher batcher_;
 
 public:
 	Scheduler() {
 		scheduler_.set_handler(this);
+		batcher_.set_handler(boost::bind(&Scheduler::submit_batch, this, _1, _2));
 	}
 	virtual ~Scheduler() {
 		scheduler_.set_handler(NULL);
@@ -43,7 +46,9 @@ public:
 	void fetchMetrics(Plugin::MetricsMessage_Response *response);
 
 	void add_schedule(std::string alias, std::string command);
-	bool handle_schedule(schedules::target_object task);
+	bool handle_schedule(const schedules::target_list &tasks);
+	void submit_result(const schedules::target_object &item, std::string response);
+	void submit_batch(const std::string &channel, const Plugin::SubmitRequestMessage &request);
 
 	void on_error(const char* file, int line, std::string error);
 	void on_trace(const char* file, int line, std::string error);
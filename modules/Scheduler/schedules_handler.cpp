@@ -19,11 +19,16 @@
 
 #include "schedules_handler.hpp"
 
+#include <str/xtos.hpp>
+
 namespace schedules {
 
-	target_object scheduler::get(int id) {
+	target_list scheduler::get(int id) {
 		boost::mutex::scoped_lock l(tasks.get_mutex());
-		return metadata[id];
+		metadata_map::const_iterator it = metadata.find(id);
+		if (it == metadata.end())
+			return target_list();
+		return it->second;
 	}
 
 	void scheduler::start() {
@@ -50,17 +55,56 @@ namespace schedules {
 		return boost::posix_time::seconds(str::format::stox_as_time_sec<long>(str, "s"));
 	}
 
-	void scheduler::add_task(const target_object target) {
-		unsigned int id = 0;
+	// A stable (FNV-1a) hash so the offset does not change between versions or platforms.
+	unsigned int hash_alias(const std::string &alias) {
+		unsigned int hash = 2166136261u;
+		BOOST_FOREACH(char c, alias) {
+			hash ^= static_cast<unsigned char>(c);
+			hash *= 16777619u;
+		}
+		return hash;
+	}
+
+	std::string get_coalesce_key(const target_object &target) {
+		std::string key = target->command + "\n" + str::utils::joinEx(target->arguments, "\n");
 		if (target->duration)
-			id = tasks.add_task(target->get_alias(), *target->duration, target->randomness);
+			key += "\ninterval:" + str::xtos((*target->duration).total_seconds());
 		else if (target->schedule)
-			id = tasks.add_task(target->get_alias(), cron_parser::parse(*target->schedule));
-		else
-			id = tasks.add_task(target->get_alias(), parse_interval("5m"), 0.1);
-		{
-			boost::mutex::scoped_lock l(tasks.get_mutex());
-			metadata[id] = target;
+			key += "\nschedule:" + *target->schedule;
+		return key;
+	}
+
+	void scheduler::add_tasks(const std::list<target_object> &targets) {
+		std::list<target_list> groups;
+		if (coalesce_) {
+			// Ordered so the group (and its offset) does not depend on the order of the settings
+			std::map<std::string, target_list> keyed;
+			BOOST_FOREACH(const target_object &target, targets) {
+				keyed[get_coalesce_key(target)].push_back(target);
+			}
+			for (std::map<std::string, target_list>::const_iterator it = keyed.begin(); it != keyed.end(); ++it) {
+				groups.push_back(it->second);
+			}
+		} else {
+			BOOST_FOREACH(const target_object &target, targets) {
+				groups.push_back(target_list(1, target));
+			}
+		}
+		BOOST_FOREACH(const target_list &group, groups) {
+			const target_object &target = group.front();
+			unsigned int id = 0;
+			if (target->duration && spread_ && (*target->duration).total_seconds() > 0)
+				id = tasks.add_task(target->get_alias(), *target->duration, boost::posix_time::seconds(hash_alias(target->get_alias()) % (*target->duration).total_seconds()));
+			else if (target->duration)
+				id = tasks.add_task(target->get_alias(), *target->duration, target->randomness);
+			else if (target->schedule)
+				id = tasks.add_task(target->get_alias(), cron_parser::parse(*target->schedule));
+			else
+				id = tasks.add_task(target->get_alias(), parse_interval("5m"), 0.1);
+			{
+				boost::mutex::scoped_lock l(tasks.get_mutex());
+				metadata[id] = group;
+			}
 		}
 	}
 
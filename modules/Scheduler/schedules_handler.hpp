@@ -183,23 +183,29 @@ namespace schedules {
 
 	typedef boost::optional<schedule_object> optional_target_object;
 	typedef boost::shared_ptr<schedule_object> target_object;
+	// Schedules which are run as one (see coalesce)
+	typedef std::list<target_object> target_list;
 
 	typedef nscapi::settings_objects::object_handler<schedule_object> schedule_handler;
 
 	struct task_handler {
-		virtual bool handle_schedule(target_object task) = 0;
+		virtual bool handle_schedule(const target_list &tasks) = 0;
 		virtual void on_error(const char* file, int line, std::string error) = 0;
 		virtual void on_trace(const char* file, int line, std::string error) = 0;
 
 	};
 
 	struct scheduler : public simple_scheduler::handler {
-		typedef boost::unordered_map<int, target_object> metadata_map;
+		typedef boost::unordered_map<int, target_list> metadata_map;
 		metadata_map metadata;
 		simple_scheduler::scheduler tasks;
 		task_handler *handler_;
+		bool spread_;
+		bool coalesce_;
 
-		target_object get(int id);
+		scheduler() : handler_(NULL), spread_(false), coalesce_(false) {}
+
+		target_list get(int id);
 
 		void start();
 		void stop();
@@ -222,8 +228,23 @@ namespace schedules {
 		void set_threads(int count) {
 			tasks.set_threads(count);
 		}
+		void set_max_threads(int count) {
+			tasks.set_max_threads(count);
+		}
+		void set_executor(simple_scheduler::scheduler::executor_type executor) {
+			tasks.set_executor(executor);
+		}
 
-		void add_task(const target_object target);
+		// Spread: run each schedule at a fixed offset into its interval (derived from its alias) so schedules added at the same time
+		// do not all run at once and keep their slot across reloads.
+		// Coalesce: schedules with the same command, arguments and interval are run once and the result is sent to each of them.
+		void set_spread(bool spread) {
+			spread_ = spread;
+		}
+		void set_coalesce(bool coalesce) {
+			coalesce_ = coalesce;
+		}
+		void add_tasks(const std::list<target_object> &targets);
 
 		bool handle_schedule(simple_scheduler::task item) {
 			task_handler *tmp = handler_;
@@ -0,0 +1,135 @@
+/*
+ * Copyright (C) 2004-2016 Michael Medin
+ *
+ * This file is part of NSClient++ - https://nsclient.org
+ *
+ * NSClient++ is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * NSClient++ is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with NSClient++.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "submit_batcher.hpp"
+
+#include <str/format.hpp>
+
+#include <boost/bind.hpp>
+#include <boost/foreach.hpp>
+
+namespace schedules {
+
+	void submit_batcher::set_max_latency(std::string latency) {
+		max_latency_ = boost::posix_time::milliseconds(str::format::decode_time<long>(latency, 1000));
+	}
+
+	void submit_batcher::start() {
+		boost::mutex::scoped_lock lock(mutex_);
+		if (!is_enabled() || thread_.joinable())
+			return;
+		stop_ = false;
+		thread_ = boost::thread(boost::bind(&submit_batcher::thread_proc, this));
+	}
+
+	// Stops the flush thread and sends whatever is still queued.
+	void submit_batcher::stop() {
+		{
+			boost::mutex::scoped_lock lock(mutex_);
+			stop_ = true;
+		}
+		cond_.notify_all();
+		if (thread_.joinable())
+			thread_.join();
+		batch_list remaining;
+		{
+			boost::mutex::scoped_lock lock(mutex_);
+			remaining.swap(ready_);
+			BOOST_FOREACH(batch_map::value_type &v, batches_) {
+				remaining.push_back(batch());
+				remaining.back().channel = v.second.channel;
+				remaining.back().request.Swap(&v.second.request);
+			}
+			batches_.clear();
+		}
+		flush(remaining);
+	}
+
+	// Full batches are moved to the ready list right away so a batch never grows past the max size.
+	void submit_batcher::add(const std::string &channel, const std::string &request) {
+		Plugin::SubmitRequestMessage message;
+		message.ParseFromString(request);
+		const std::string key = channel + "|" + message.header().recipient_id() + "|" + message.header().sender_id();
+		bool wake = false;
+		{
+			boost::mutex::scoped_lock lock(mutex_);
+			batch_map::iterator it = batches_.find(key);
+			if (it == batches_.end()) {
+				it = batches_.insert(batch_map::value_type(key, batch())).first;
+				it->second.channel = channel;
+				it->second.request.Swap(&message);
+				it->second.first = boost::posix_time::microsec_clock::universal_time();
+				// The flush thread waits without a timeout while there are no batches.
+				wake = true;
+			} else {
+				for (int i = 0; i < message.payload_size(); ++i)
+					it->second.request.add_payload()->Swap(message.mutable_payload(i));
+			}
+			if (static_cast<std::size_t>(it->second.request.payload_size()) >= max_size_) {
+				ready_.push_back(batch());
+				ready_.back().channel = channel;
+				ready_.back().request.Swap(&it->second.request);
+				batches_.erase(it);
+				wake = true;
+			}
+		}
+		if (wake)
+			cond_.notify_all();
+	}
+
+	void submit_batcher::thread_proc() {
+		boost::mutex::scoped_lock lock(mutex_);
+		while (!stop_) {
+			boost::posix_time::ptime now = boost::posix_time::microsec_clock::universal_time();
+			boost::posix_time::ptime next = now + max_latency_;
+			batch_list due;
+			due.swap(ready_);
+			for (batch_map::iterator it = batches_.begin(); it != batches_.end();) {
+				if (it->second.first + max_latency_ <= now) {
+					due.push_back(batch());
+					due.back().channel = it->second.channel;
+					due.back().request.Swap(&it->second.request);
+					batches_.erase(it++);
+				} else {
+					next = std::min(next, it->second.first + max_latency_);
+					++it;
+				}
+			}
+			if (!due.empty()) {
+				lock.unlock();
+				flush(due);
+				lock.lock();
+				continue;
+			}
+			if (batches_.empty())
+				cond_.wait(lock);
+			else
+				cond_.timed_wait(lock, next);
+		}
+	}
+
+	void submit_batcher::flush(batch_list &batches) {
+		if (!handler_)
+			return;
+		BOOST_FOREACH(const batch &b, batches) {
+			handler_(b.channel, b.request);
+		}
+	}
+}
@@ -0,0 +1,87 @@
+/*
+ * Copyright (C) 2004-2016 Michael Medin
+ *
+ * This file is part of NSClient++ - https://nsclient.org
+ *
+ * NSClient++ is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * NSClient++ is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with NSClient++.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <nscapi/nscapi_protobuf.hpp>
+
+#include <boost/function.hpp>
+#include <boost/thread/thread.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include <boost/date_time/posix_time/posix_time.hpp>
+
+#include <list>
+#include <map>
+#include <string>
+
+namespace schedules {
+
+	// Collects submissions going to the same channel, target and source into one message.
+	// A batch is flushed from a background thread once it is full or its oldest result is too old.
+	class submit_batcher {
+	public:
+		typedef boost::function<void(const std::string &channel, const Plugin::SubmitRequestMessage &request)> flush_handler;
+
+	private:
+		struct batch {
+			std::string channel;
+			Plugin::SubmitRequestMessage request;
+			boost::posix_time::ptime first;
+		};
+		typedef std::map<std::string, batch> batch_map;
+		typedef std::list<batch> batch_list;
+
+		batch_map batches_;
+		batch_list ready_;
+		flush_handler handler_;
+		boost::mutex mutex_;
+		boost::condition_variable cond_;
+		boost::thread thread_;
+		std::size_t max_size_;
+		boost::posix_time::time_duration max_latency_;
+		bool stop_;
+
+	public:
+		submit_batcher() : max_size_(1), max_latency_(boost::posix_time::seconds(1)), stop_(false) {}
+		~submit_batcher() {
+			stop();
+		}
+
+		void set_handler(flush_handler handler) {
+			handler_ = handler;
+		}
+		void set_max_size(int size) {
+			max_size_ = size < 1 ? 1 : size;
+		}
+		void set_max_latency(std::string latency);
+		// A latency of 0 would leave nothing to wait for so results are then sent right away as well.
+		bool is_enabled() const {
+			return max_size_ > 1 && max_latency_ > boost::posix_time::time_duration();
+		}
+
+		void start();
+		void stop();
+		void add(const std::string &channel, const std::string &request);
+
+	private:
+		void thread_proc();
+		void flush(batch_list &batches);
+	};
+}
@@ -114,6 +114,8 @@ std::string simple_string_fun(std::string key) {
 bool SimpleCache::loadModuleEx(std::string alias, NSCAPI::moduleLoadMode mode) {
 	std::string primary_key;
 	std::string channel;
+	std::string ttl;
+	unsigned int max_entries = 0;
 	sh::settings_registry settings(get_settings_proxy());
 
 	settings.set_alias(alias, "cache");
@@ -131,13 +133,29 @@ bool SimpleCache::loadModuleEx(std::string alias, NSCAPI::moduleLoadMode mode) {
 		("channel", sh::string_key(&channel, "CACHE"),
 			"CHANNEL", "The channel to listen to.")
 
+		("max entries", sh::uint_key(&max_entries, 100000),
+			"MAXIMUM ENTRIES", "The maximum number of results to keep, when full the least recently used results are dropped (0 means no limit).")
+
+		("ttl", sh::string_key(&ttl, "0"),
+			"TIME TO LIVE", "How long a result is kept after it was submitted, for instance 10m (0 means results are kept until they are replaced).")
+
+		("persist", sh::bool_key(&persist_, false),
+			"PERSIST", "Keep the cached results in the core storage so they survive restarts.")
+
 		;
 
 	settings.register_all();
 	settings.notify();
 
+	cache_.configure(max_entries, str::format::stox_as_time_sec<long>(ttl, "s"));
+
 	nscapi::core_helper core(get_core(), get_id());
 	core.register_channel(channel);
+	// Only a running service has a cache worth keeping (saving from any other mode would replace it with an empty one)
+	persist_ = persist_ && mode == NSCAPI::normalStart;
+	if (persist_) {
+		cache_.load(core.get_storage_strings("cache.results"));
+	}
 
 	parsers::simple_expression parser;
 	parsers::simple_expression::result_type result;
@@ -170,20 +188,45 @@ bool SimpleCache::loadModuleEx(std::string alias, NSCAPI::moduleLoadMode mode) {
 	return true;
 }
 
+bool SimpleCache::unloadModule() {
+	if (persist_) {
+		nscapi::core_helper core(get_core(), get_id());
+		// Replaced as a whole so evicted and expired results are removed from the storage as well
+		core.replace_storage("cache.results", cache_.save(), false, true);
+	}
+	return true;
+}
+
+void SimpleCache::fetchMetrics(Plugin::MetricsMessage::Response *response) {
+	simple_cache::cache_metrics metrics = cache_.get_metrics();
+	Plugin::Common::MetricsBundle *bundle = response->add_bundles();
+	bundle->set_key("cache");
+	Plugin::Common::Metric *m = bundle->add_value();
+	m->set_key("entries");
+	m->mutable_value()->set_int_data(metrics.entries);
+	m = bundle->add_value();
+	m->set_key("hits");
+	m->mutable_value()->set_int_data(metrics.hits);
+	m = bundle->add_value();
+	m->set_key("misses");
+	m->mutable_value()->set_int_data(metrics.misses);
+	m = bundle->add_value();
+	m->set_key("evictions");
+	m->mutable_value()->set_int_data(metrics.evictions);
+	m = bundle->add_value();
+	m->set_key("expired");
+	m->mutable_value()->set_int_data(metrics.expired);
+}
+
 void SimpleCache::handleNotification(const std::string &channel, const Plugin::QueryResponseMessage::Response &request, Plugin::SubmitResponseMessage::Response *response, const Plugin::SubmitRequestMessage &request_message) {
 	std::string key;
 	BOOST_FOREACH(index_lookup_function &f, index_lookup_) {
 		key += f(channel, request_message.header(), request);
 	}
-	std::string data = request.SerializeAsString();
 	NSC_DEBUG_MSG("Adding to index: " + key);
-	{
-		boost::unique_lock<boost::shared_mutex> lock(cache_mutex_);
-		if (!lock) {
-			nscapi::protobuf::functions::append_simple_submit_response_payload(response, request.command(), false, "Failed to get lock");
-			return;
-		}
-		cache_[key] = data;
+	if (!cache_.put(key, simple_cache::response_type(new Plugin::QueryResponseMessage::Response(request)))) {
+		nscapi::protobuf::functions::append_simple_submit_response_payload(response, request.command(), false, "Failed to get lock");
+		return;
 	}
 	nscapi::protobuf::functions::append_simple_submit_response_payload(response, request.command(), true, "message has been cached");
 }
@@ -199,14 +242,8 @@ void SimpleCache::list_cache(const Plugin::QueryRequestMessage::Request &request
 		return;
 
 	std::string data;
-	{
-		boost::shared_lock<boost::shared_mutex> lock(cache_mutex_);
-		if (!lock) {
-			return nscapi::protobuf::functions::set_response_bad(*response, std::string("Failed to get lock"));
-		}
-		BOOST_FOREACH(const cache_type::value_type &c, cache_) {
-			str::format::append_list(data, c.first);
-		}
+	BOOST_FOREACH(const std::string &key, cache_.get_keys()) {
+		str::format::append_list(data, key);
 	}
 	response->add_lines()->set_message(data);
 	response->set_result(nscapi::protobuf::functions::nagios_status_to_gpb(nscapi::plugin_helper::translateReturn(not_found_msg_code)));
@@ -239,18 +276,9 @@ void SimpleCache::check_cache(const Plugin::QueryRequestMessage::Request &reques
 	if (key.empty())
 		return nscapi::program_options::invalid_syntax(desc, request.command(), "No key specified", *response);
 	NSC_DEBUG_MSG("Searching for index: " + key);
-	boost::optional<std::string> data;
-	{
-		boost::shared_lock<boost::shared_mutex> lock(cache_mutex_);
-		if (!lock) {
-			return nscapi::protobuf::functions::set_response_bad(*response, std::string("Failed to get lock"));
-		}
-		std::map<std::string, std::string>::const_iterator cit = cache_.find(key);
-		if (cit != cache_.end())
-			data = cit->second;
-	}
+	simple_cache::response_type data = cache_.get(key);
 	if (data) {
-		response->ParseFromString(*data);
+		response->CopyFrom(*data);
 	} else {
 		response->add_lines()->set_message(not_found_msg);
 		response->set_result(nscapi::protobuf::functions::nagios_status_to_gpb(nscapi::plugin_helper::translateReturn(not_found_msg_code)));
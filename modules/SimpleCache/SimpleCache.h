@@ -17,10 +17,11 @@
  * along with NSClient++.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include "result_cache.hpp"
+
 #include <nscapi/nscapi_protobuf.hpp>
 #include <nscapi/nscapi_plugin_impl.hpp>
 
-#include <boost/thread/shared_mutex.hpp>
 #include <boost/function.hpp>
 
 
@@ -40,15 +41,16 @@ private:
 	index_lookup_type index_lookup_;
 	command_lookup_type command_lookup_;
 
-	typedef std::map<std::string, std::string> cache_type;
-	cache_type cache_;
-	boost::shared_mutex cache_mutex_;
+	simple_cache::result_cache cache_;
+	bool persist_;
 
 public:
-	SimpleCache() {}
+	SimpleCache() : persist_(false) {}
 	virtual ~SimpleCache() {}
 	// Module calls
 	bool loadModuleEx(std::string alias, NSCAPI::moduleLoadMode mode);
+	bool unloadModule();
+	void fetchMetrics(Plugin::MetricsMessage::Response *response);
 
 	void handleNotification(const std::string &channel, const Plugin::QueryResponseMessage::Response &request, Plugin::SubmitResponseMessage::Response *response, const Plugin::SubmitRequestMessage &request_message);
 	void check_cache(const Plugin::QueryRequestMessage::Request &request, Plugin::QueryResponseMessage::Response *response);
@@ -0,0 +1,195 @@
+/*
+ * Copyright (C) 2004-2016 Michael Medin
+ *
+ * This file is part of NSClient++ - https://nsclient.org
+ *
+ * NSClient++ is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * NSClient++ is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with NSClient++.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "result_cache.hpp"
+
+#include <str/xtos.hpp>
+
+#include <boost/foreach.hpp>
+#include <boost/functional/hash.hpp>
+#include <boost/thread/locks.hpp>
+#include <boost/thread/thread_time.hpp>
+
+#include <algorithm>
+
+namespace simple_cache {
+
+	namespace pt = boost::posix_time;
+
+	inline pt::ptime now() {
+		return pt::second_clock::universal_time();
+	}
+	inline bool has_expired(const pt::ptime &expires, const pt::ptime &now) {
+		return !expires.is_not_a_date_time() && expires <= now;
+	}
+	inline long long to_epoch(const pt::ptime &time) {
+		if (time.is_not_a_date_time())
+			return 0;
+		return (time - pt::ptime(boost::gregorian::date(1970, 1, 1))).total_seconds();
+	}
+	inline pt::ptime from_epoch(long long epoch) {
+		if (epoch == 0)
+			return pt::ptime(pt::not_a_date_time);
+		return pt::ptime(boost::gregorian::date(1970, 1, 1)) + pt::seconds(static_cast<long>(epoch));
+	}
+
+	result_cache::result_cache(std::size_t stripes) : stripe_size_(0), ttl_(pt::seconds(0)) {
+		for (std::size_t i = 0; i < stripes; i++) {
+			stripes_.push_back(stripe_type(new stripe()));
+		}
+	}
+
+	void result_cache::configure(std::size_t max_entries, long ttl) {
+		stripe_size_ = max_entries == 0 ? 0 : std::max<std::size_t>(1, (max_entries + stripes_.size() - 1) / stripes_.size());
+		ttl_ = pt::seconds(ttl);
+	}
+
+	result_cache::stripe& result_cache::get_stripe(const std::string &key) {
+		return *stripes_[boost::hash<std::string>()(key) % stripes_.size()];
+	}
+
+	// Needs the stripe lock
+	void result_cache::insert(stripe &s, const std::string &key, const response_type &response, const pt::ptime &expires) {
+		index_type::iterator it = s.index.find(key);
+		if (it != s.index.end()) {
+			s.lru.erase(it->second);
+		}
+		entry e;
+		e.key = key;
+		e.response = response;
+		e.expires = expires;
+		s.lru.push_front(e);
+		s.index[key] = s.lru.begin();
+
+		pt::ptime current = now();
+		while (!s.lru.empty() && has_expired(s.lru.back().expires, current)) {
+			s.index.erase(s.lru.back().key);
+			s.lru.pop_back();
+			s.expired++;
+		}
+		while (stripe_size_ > 0 && s.lru.size() > stripe_size_) {
+			s.index.erase(s.lru.back().key);
+			s.lru.pop_back();
+			s.evictions++;
+		}
+	}
+
+	bool result_cache::put(const std::string &key, const response_type &response) {
+		stripe &s = get_stripe(key);
+		boost::unique_lock<boost::timed_mutex> lock(s.mutex, boost::get_system_time() + pt::seconds(5));
+		if (!lock.owns_lock()) {
+			return false;
+		}
+		insert(s, key, response, ttl_.total_seconds() > 0 ? now() + ttl_ : pt::ptime(pt::not_a_date_time));
+		return true;
+	}
+
+	response_type result_cache::get(const std::string &key) {
+		stripe &s = get_stripe(key);
+		boost::unique_lock<boost::timed_mutex> lock(s.mutex, boost::get_system_time() + pt::seconds(5));
+		if (!lock.owns_lock()) {
+			return response_type();
+		}
+		index_type::iterator it = s.index.find(key);
+		if (it == s.index.end()) {
+			s.misses++;
+			return response_type();
+		}
+		if (has_expired(it->second->expires, now())) {
+			s.lru.erase(it->second);
+			s.index.erase(it);
+			s.expired++;
+			s.misses++;
+			return response_type();
+		}
+		s.lru.splice(s.lru.begin(), s.lru, it->second);
+		s.hits++;
+		return it->second->response;
+	}
+
+	result_cache::key_list result_cache::get_keys() {
+		key_list ret;
+		pt::ptime current = now();
+		BOOST_FOREACH(stripe_type &s, stripes_) {
+			boost::unique_lock<boost::timed_mutex> lock(s->mutex, boost::get_system_time() + pt::seconds(5));
+			if (!lock.owns_lock()) {
+				continue;
+			}
+			BOOST_FOREACH(const entry &e, s->lru) {
+				if (!has_expired(e.expires, current))
+					ret.push_back(e.key);
+			}
+		}
+		ret.sort();
+		return ret;
+	}
+
+	cache_metrics result_cache::get_metrics() {
+		cache_metrics ret;
+		BOOST_FOREACH(stripe_type &s, stripes_) {
+			boost::unique_lock<boost::timed_mutex> lock(s->mutex, boost::get_system_time() + pt::seconds(5));
+			if (!lock.owns_lock()) {
+				continue;
+			}
+			ret.hits += s->hits;
+			ret.misses += s->misses;
+			ret.evictions += s->evictions;
+			ret.expired += s->expired;
+			ret.entries += s->lru.size();
+		}
+		return ret;
+	}
+
+	result_cache::map_type result_cache::save() {
+		map_type ret;
+		pt::ptime current = now();
+		BOOST_FOREACH(stripe_type &s, stripes_) {
+			boost::unique_lock<boost::timed_mutex> lock(s->mutex, boost::get_system_time() + pt::seconds(5));
+			if (!lock.owns_lock()) {
+				continue;
+			}
+			BOOST_FOREACH(const entry &e, s->lru) {
+				if (!has_expired(e.expires, current))
+					ret[e.key] = str::xtos(to_epoch(e.expires)) + ":" + e.response->SerializeAsString();
+			}
+		}
+		return ret;
+	}
+
+	void result_cache::load(const map_type &values) {
+		pt::ptime current = now();
+		BOOST_FOREACH(const map_type::value_type &v, values) {
+			std::string::size_type p = v.second.find(':');
+			if (p == std::string::npos)
+				continue;
+			pt::ptime expires = from_epoch(str::stox<long long>(v.second.substr(0, p), 0));
+			if (has_expired(expires, current))
+				continue;
+			boost::shared_ptr<Plugin::QueryResponseMessage::Response> response(new Plugin::QueryResponseMessage::Response());
+			if (!response->ParseFromString(v.second.substr(p + 1)))
+				continue;
+			stripe &s = get_stripe(v.first);
+			boost::unique_lock<boost::timed_mutex> lock(s.mutex, boost::get_system_time() + pt::seconds(5));
+			if (!lock.owns_lock()) {
+				continue;
+			}
+			insert(s, v.first, response, expires);
+		}
+	}
+}
@@ -0,0 +1,99 @@
+/*
+ * Copyright (C) 2004-2016 Michael Medin
+ *
+ * This file is part of NSClient++ - https://nsclient.org
+ *
+ * NSClient++ is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * NSClient++ is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with NSClient++.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <nscapi/nscapi_protobuf.hpp>
+
+#include <boost/shared_ptr.hpp>
+#include <boost/unordered_map.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/date_time/posix_time/posix_time.hpp>
+#include <boost/cstdint.hpp>
+
+#include <list>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace simple_cache {
+
+	// Cached results are parsed once and shared (never modified) between all lookups.
+	typedef boost::shared_ptr<const Plugin::QueryResponseMessage::Response> response_type;
+
+	struct cache_metrics {
+		boost::uint64_t hits;
+		boost::uint64_t misses;
+		boost::uint64_t evictions;
+		boost::uint64_t expired;
+		boost::uint64_t entries;
+		cache_metrics() : hits(0), misses(0), evictions(0), expired(0), entries(0) {}
+	};
+
+	// Results keyed on the primary index, split over a number of independently locked stripes.
+	// Each stripe keeps its entries in least recently used order and holds (roughly) its share of the size limit.
+	class result_cache {
+	public:
+		typedef std::map<std::string, std::string> map_type;
+		typedef std::list<std::string> key_list;
+
+	private:
+		struct entry {
+			std::string key;
+			response_type response;
+			boost::posix_time::ptime expires;
+		};
+		typedef std::list<entry> lru_type;
+		typedef boost::unordered_map<std::string, lru_type::iterator> index_type;
+		struct stripe {
+			boost::timed_mutex mutex;
+			lru_type lru;
+			index_type index;
+			boost::uint64_t hits;
+			boost::uint64_t misses;
+			boost::uint64_t evictions;
+			boost::uint64_t expired;
+			stripe() : hits(0), misses(0), evictions(0), expired(0) {}
+		};
+		typedef boost::shared_ptr<stripe> stripe_type;
+
+		std::vector<stripe_type> stripes_;
+		std::size_t stripe_size_;
+		boost::posix_time::time_duration ttl_;
+
+	public:
+		result_cache(std::size_t stripes = 16);
+
+		// max_entries and ttl of 0 means no limit.
+		void configure(std::size_t max_entries, long ttl);
+
+		bool put(const std::string &key, const response_type &response);
+		response_type get(const std::string &key);
+		key_list get_keys();
+		cache_metrics get_metrics();
+
+		// Entries are persisted as "expires:response" (the caller replaces all earlier saved entries).
+		map_type save();
+		void load(const map_type &values);
+
+	private:
+		stripe& get_stripe(const std::string &key);
+		void insert(stripe &s, const std::string &key, const response_type &response, const boost::posix_time::ptime &expires);
+	};
+}
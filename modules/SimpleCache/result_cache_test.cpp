@@ -0,0 +1,114 @@
+/*
+ * Copyright (C) 2004-2016 Michael Medin
+ *
+ * This file is part of NSClient++ - https://nsclient.org
+ *
+ * NSClient++ is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * NSClient++ is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with NSClient++.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "result_cache.hpp"
+
+#include <string>
+
+#include <str/xtos.hpp>
+
+#include <gtest/gtest.h>
+
+simple_cache::response_type make_response(const std::string &message) {
+	boost::shared_ptr<Plugin::QueryResponseMessage::Response> response(new Plugin::QueryResponseMessage::Response());
+	response->set_command("check_test");
+	response->set_result(Plugin::Common_ResultCode_OK);
+	response->add_lines()->set_message(message);
+	return response;
+}
+
+std::string get_message(simple_cache::result_cache &cache, const std::string &key) {
+	simple_cache::response_type response = cache.get(key);
+	if (!response)
+		return "";
+	return response->lines(0).message();
+}
+
+TEST(result_cache, put_and_get) {
+	simple_cache::result_cache cache;
+	cache.put("a", make_response("first"));
+	cache.put("b", make_response("second"));
+	cache.put("a", make_response("replaced"));
+	EXPECT_EQ("replaced", get_message(cache, "a"));
+	EXPECT_EQ("second", get_message(cache, "b"));
+	EXPECT_EQ("", get_message(cache, "c"));
+
+	simple_cache::cache_metrics metrics = cache.get_metrics();
+	EXPECT_EQ(2u, metrics.entries);
+	EXPECT_EQ(2u, metrics.hits);
+	EXPECT_EQ(1u, metrics.misses);
+}
+
+TEST(result_cache, evicts_least_recently_used) {
+	simple_cache::result_cache cache(1);
+	cache.configure(2, 0);
+	cache.put("a", make_response("a"));
+	cache.put("b", make_response("b"));
+	EXPECT_EQ("a", get_message(cache, "a"));
+	cache.put("c", make_response("c"));
+	EXPECT_EQ("a", get_message(cache, "a"));
+	EXPECT_EQ("", get_message(cache, "b"));
+	EXPECT_EQ("c", get_message(cache, "c"));
+	EXPECT_EQ(1u, cache.get_metrics().evictions);
+}
+
+TEST(result_cache, bounded_over_stripes) {
+	simple_cache::result_cache cache(4);
+	cache.configure(100, 0);
+	for (int i = 0; i < 1000; i++) {
+		cache.put("key-" + str::xtos(i), make_response("value"));
+	}
+	EXPECT_GE(100u + 4u, cache.get_metrics().entries);
+	EXPECT_EQ(1000u, cache.get_metrics().entries + cache.get_metrics().evictions);
+}
+
+TEST(result_cache, save_and_load) {
+	simple_cache::result_cache cache;
+	cache.put("a", make_response("a"));
+	cache.put("b", make_response("b"));
+	simple_cache::result_cache::map_type stored = cache.save();
+	EXPECT_EQ(2u, stored.size());
+
+	simple_cache::result_cache second;
+	second.load(stored);
+	EXPECT_EQ("a", get_message(second, "a"));
+	EXPECT_EQ("b", get_message(second, "b"));
+}
+
+TEST(result_cache, evicted_entries_are_not_saved) {
+	simple_cache::result_cache cache(1);
+	cache.configure(1, 0);
+	cache.put("a", make_response("a"));
+	cache.put("b", make_response("b"));
+	simple_cache::result_cache::map_type stored = cache.save();
+	EXPECT_EQ(1u, stored.size());
+	EXPECT_EQ(0u, stored.count("a"));
+}
+
+TEST(result_cache, expired_entries_are_not_loaded) {
+	simple_cache::result_cache::map_type stored;
+	stored["old"] = "1:" + make_response("old")->SerializeAsString();
+	stored["new"] = "0:" + make_response("new")->SerializeAsString();
+	stored["broken"] = "no expiry";
+	simple_cache::result_cache cache;
+	cache.load(stored);
+	EXPECT_EQ("", get_message(cache, "old"));
+	EXPECT_EQ("new", get_message(cache, "new"));
+	EXPECT_EQ("", get_message(cache, "broken"));
+}
@@ -28,6 +28,9 @@
 #include <settings/settings_core.hpp>
 #include <config.h>
 
+#include <str/xtos.hpp>
+
+#include <boost/bind.hpp>
 #include <boost/unordered_set.hpp>
 #include <boost/filesystem/operations.hpp>
 
@@ -297,7 +300,21 @@ bool NSClientT::boot_load_single_plugin(std::string plugin) {
 
 
 bool NSClientT::boot_start_plugins(bool boot) {
+	settings_manager::get_core()->register_key(0xffff, "/settings/core", "storage sync", settings::settings_core::key_string, "Storage sync policy", "When changes to the local storage (nsclient.db) are forced to disk: always (after each change), interval (on each storage maintenance) or never (leave it to the OS).", "interval", true, false);
+	storage_manager_->set_sync_policy(nsclient::core::storage_manager::parse_sync_policy(settings_manager::get_settings()->get_string("/settings/core", "storage sync", "interval")));
+	settings_manager::get_core()->register_key(0xffff, "/settings/core", "storage compact size", settings::settings_core::key_integer, "Storage compact size", "Size (in bytes) the storage journal has to grow past before it is folded into nsclient.db. The journal is never compacted before it is larger than nsclient.db itself.", "1048576", true, false);
+	storage_manager_->set_compact_size(std::max(0, settings_manager::get_settings()->get_int("/settings/core", "storage compact size", 1048576)));
 	storage_manager_->load();
+	if (boot) {
+		settings_manager::get_core()->register_key(0xffff, "/settings/core", "worker threads", settings::settings_core::key_integer, "Worker threads", "Number of threads in the shared worker pool modules can submit tasks to (0 means one per processor).", "0", true, false);
+		int workers = settings_manager::get_settings()->get_int("/settings/core", "worker threads", 0);
+		if (workers <= 0)
+			workers = std::max(2u, boost::thread::hardware_concurrency());
+		workers_.start(workers);
+		settings_manager::get_core()->register_key(0xffff, "/settings/core", "query timeout", settings::settings_core::key_integer, "Query timeout", "Seconds to wait for modules when a query is spread over several modules (0 means wait forever). Payloads from modules which have not answered in time are returned as UNKNOWN.", "60", true, false);
+		int query_timeout = settings_manager::get_settings()->get_int("/settings/core", "query timeout", 60);
+		plugins_->set_executor(boost::bind(&nscp_thread::work_stealing_pool::submit, &workers_, _1), boost::bind(&nscp_thread::work_stealing_pool::is_worker, &workers_), query_timeout);
+	}
 	try {
 		plugins_->start_plugins(boot ? NSCAPI::normalStart : NSCAPI::dontStart);
 	} catch (...) {
@@ -311,9 +328,15 @@ bool NSClientT::boot_start_plugins(bool boot) {
 		settings_manager::get_core()->register_key(0xffff, "/settings/core", "metrics interval", settings::settings_core::key_string, "Maintenance interval", "How often to fetch metrics from modules", "10s", true, false);
 		smi = settings_manager::get_settings()->get_string("/settings/core", "metrics interval", "10s");
 		scheduler_.add_task(task_scheduler::schedule_metadata::METRICS, smi);
+		settings_manager::get_core()->register_key(0xffff, "/settings/core", "storage maintenance interval", settings::settings_core::key_string, "Storage maintenance interval", "How often to sync and compact the local storage journal", "1m", true, false);
+		smi = settings_manager::get_settings()->get_string("/settings/core", "storage maintenance interval", "1m");
+		scheduler_.add_task(task_scheduler::schedule_metadata::STORAGE, smi);
 		settings_manager::get_core()->register_key(0xffff, "/settings/core", "settings maintenance threads", settings::settings_core::key_integer, "Maintenance thread count", "How many threads will run in the background to maintain the various core helper tasks.", "1", true, false);
 		int count = settings_manager::get_settings()->get_int("/settings/core", "settings maintenance threads", 1);
 		scheduler_.set_threads(count);
+		settings_manager::get_core()->register_key(0xffff, "/settings/core", "shared workers", settings::settings_core::key_bool, "Use shared workers", "Run the core helper tasks on the shared worker pool instead of dedicated threads.", "false", true, false);
+		if (settings_manager::get_settings()->get_bool("/settings/core", "shared workers", false))
+			scheduler_.set_executor(boost::bind(&nscp_thread::work_stealing_pool::submit, &workers_, _1));
 		scheduler_.start();
 	}
 	LOG_DEBUG_CORE(utf8::cvt<std::string>(APPLICATION_NAME " - " CURRENT_SERVICE_VERSION " Started!"));
@@ -332,6 +355,7 @@ bool NSClientT::stop_nsclient() {
 		LOG_ERROR_CORE("Unknown exception raised when unloading non msg plugins");
 	}
 	storage_manager_->save();
+	workers_.stop();
 #ifdef WIN32
 	LOG_DEBUG_CORE("Stopping: COM helper");
 	try {
@@ -495,6 +519,20 @@ Plugin::Common::MetricsBundle NSClientT::ownMetricsFetcher() {
 		m = bundle.add_value();
 		m->set_key("threads");
 		m->mutable_value()->set_int_data(threads);
+
+		std::vector<nscp_thread::work_stealing_pool::queue_metrics> queues = workers_.get_metrics();
+		for (std::size_t i = 0; i < queues.size(); i++) {
+			std::string prefix = "pool." + str::xtos(i) + ".";
+			m = bundle.add_value();
+			m->set_key(prefix + "depth");
+			m->mutable_value()->set_int_data(queues[i].depth);
+			m = bundle.add_value();
+			m->set_key(prefix + "executed");
+			m->mutable_value()->set_int_data(queues[i].executed);
+			m = bundle.add_value();
+			m->set_key(prefix + "stolen");
+			m->mutable_value()->set_int_data(queues[i].stolen);
+		}
 	} else {
 		Plugin::Common::Metric *m = bundle.add_value();
 		m->set_key("metrics.available");
@@ -27,6 +27,7 @@
 
 #include <nsclient/logger/logger.hpp>
 #include <service/system_service.hpp>
+#include <threads/work_stealing_pool.hpp>
 
 class NSClientT;
 typedef service_helper::impl<NSClientT>::system_service NSClient;
@@ -72,6 +73,7 @@ private:
 	nsclient::core::storage_manager_instance storage_manager_;
 
 	task_scheduler::scheduler scheduler_;
+	nscp_thread::work_stealing_pool workers_;
 
 public:
 	typedef std::multimap<std::string, std::string> plugin_alias_list_type;
@@ -119,6 +121,9 @@ public:
 	nsclient::core::storage_manager_instance get_storage_manager() override {
 		return storage_manager_;
 	}
+	bool submit_task(nscp_thread::work_stealing_pool::task_type task) {
+		return workers_.submit(task);
+	}
 
 
 	struct service_controller {
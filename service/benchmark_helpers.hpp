@@ -0,0 +1,57 @@
+/*
+ * Copyright (C) 2004-2016 Michael Medin
+ *
+ * This file is part of NSClient++ - https://nsclient.org
+ *
+ * NSClient++ is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * NSClient++ is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with NSClient++.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <nsclient/logger/logger.hpp>
+
+#include <iostream>
+#include <string>
+
+#include <boost/date_time/posix_time/posix_time.hpp>
+
+// Only errors are of interest in the benchmarks
+struct stderr_logger : public nsclient::logging::logger {
+	void trace(const std::string &, const char*, const int, const std::string &) {}
+	void debug(const std::string &, const char*, const int, const std::string &) {}
+	void info(const std::string &, const char*, const int, const std::string &) {}
+	void warning(const std::string &, const char*, const int, const std::string &message) { std::cerr << message << std::endl; }
+	void error(const std::string &, const char*, const int, const std::string &message) { std::cerr << message << std::endl; }
+	void critical(const std::string &, const char*, const int, const std::string &message) { std::cerr << message << std::endl; }
+	bool should_trace() const { return false; }
+	bool should_debug() const { return false; }
+	bool should_info() const { return false; }
+	bool should_warning() const { return true; }
+	bool should_error() const { return true; }
+	bool should_critical() const { return true; }
+	void raw(const std::string &message) { std::cerr << message << std::endl; }
+	void add_subscriber(nsclient::logging::logging_subscriber_instance) {}
+	void clear_subscribers() {}
+	bool startup() { return true; }
+	bool shutdown() { return true; }
+	void destroy() {}
+	void configure() {}
+	void set_log_level(std::string) {}
+	std::string get_log_level() const { return "error"; }
+	void set_backend(std::string) {}
+};
+
+inline long long elapsed_ms(const boost::posix_time::ptime &start) {
+	return (boost::posix_time::microsec_clock::universal_time() - start).total_milliseconds();
+}
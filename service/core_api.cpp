@@ -39,6 +39,8 @@
 #include "registry_query_handler.hpp"
 #include "storage_query_handler.hpp"
 
+#include <boost/bind.hpp>
+
 #define LOG_ERROR(core, msg) { core->get_logger()->error("core", __FILE__, __LINE__, msg); }
 
 extern NSClient *mainClient;	// Global core instance forward declaration.
@@ -89,6 +91,12 @@ NSCAPI::nagiosReturn NSAPIInject(const char *request_buffer, const unsigned int
 	}
 	return ret;
 }
+void NSAPIGetProtobufRuntime(const void **messages, const void **library) {
+	nscapi::protobuf::get_runtime(messages, library);
+}
+NSCAPI::nagiosReturn NSAPIInjectMessage(const void *request, void *response) {
+	return mainClient->get_plugin_manager()->execute_query(*static_cast<const Plugin::QueryRequestMessage*>(request), *static_cast<Plugin::QueryResponseMessage*>(response));
+}
 
 NSCAPI::nagiosReturn NSAPIExecCommand(const char* target, const char *request_buffer, const unsigned int request_buffer_len, char **response_buffer, unsigned int *response_buffer_len) {
 	std::string request(request_buffer, request_buffer_len), response;
@@ -188,6 +196,12 @@ NSCAPI::errorReturn NSCAPIStorageQuery(const char *request_buffer, const unsigne
 	return NSCAPI::api_return_codes::hasFailed;
 }
 
+NSCAPI::errorReturn NSAPISubmitTask(nscapi::core_api::lpNSAPITask task, void *data) {
+	if (!mainClient->submit_task(boost::bind(task, data)))
+		return NSCAPI::api_return_codes::hasFailed;
+	return NSCAPI::api_return_codes::isSuccess;
+}
+
 NSCAPI::errorReturn NSAPIReload(const char *module) {
 	return mainClient->reload(module);
 }
@@ -203,6 +217,10 @@ nscapi::core_api::FUNPTR NSAPILoader(const char* buffer) {
 		return reinterpret_cast<nscapi::core_api::FUNPTR>(&NSAPISimpleMessage);
 	if (strcmp(buffer, "NSAPIInject") == 0)
 		return reinterpret_cast<nscapi::core_api::FUNPTR>(&NSAPIInject);
+	if (strcmp(buffer, "NSAPIInjectMessage") == 0)
+		return reinterpret_cast<nscapi::core_api::FUNPTR>(&NSAPIInjectMessage);
+	if (strcmp(buffer, "NSAPIGetProtobufRuntime") == 0)
+		return reinterpret_cast<nscapi::core_api::FUNPTR>(&NSAPIGetProtobufRuntime);
 	if (strcmp(buffer, "NSAPIExecCommand") == 0)
 		return reinterpret_cast<nscapi::core_api::FUNPTR>(&NSAPIExecCommand);
 	if (strcmp(buffer, "NSAPICheckLogMessages") == 0)
@@ -229,6 +247,8 @@ nscapi::core_api::FUNPTR NSAPILoader(const char* buffer) {
 		return reinterpret_cast<nscapi::core_api::FUNPTR>(&NSCAPIEmitEvent);
 	if (strcmp(buffer, "NSAPIStorageQuery") == 0)
 		return reinterpret_cast<nscapi::core_api::FUNPTR>(&NSCAPIStorageQuery);
+	if (strcmp(buffer, "NSAPISubmitTask") == 0)
+		return reinterpret_cast<nscapi::core_api::FUNPTR>(&NSAPISubmitTask);
 	mainClient->get_logger()->critical("api", __FILE__, __LINE__, "Function not found: " + std::string(buffer));
 	return NULL;
 }
@@ -33,6 +33,8 @@ NSCAPI::errorReturn NSAPIGetApplicationVersionStr(char *buffer, unsigned int buf
 void NSAPIMessage(const char* data, unsigned int count);
 void NSAPISimpleMessage(const char* module, int loglevel, const char* file, int line, const char* message);
 NSCAPI::nagiosReturn NSAPIInject(const char *request_buffer, const unsigned int request_buffer_len, char **response_buffer, unsigned int *response_buffer_len);
+NSCAPI::nagiosReturn NSAPIInjectMessage(const void *request, void *response);
+void NSAPIGetProtobufRuntime(const void **messages, const void **library);
 NSCAPI::nagiosReturn NSAPIExecCommand(const char* target, const char *request_buffer, const unsigned int request_buffer_len, char **response_buffer, unsigned int *response_buffer_len);
 NSCAPI::boolReturn NSAPICheckLogMessages(int messageType);
 NSCAPI::errorReturn NSAPINotify(const char* channel, const char* buffer, unsigned int buffer_len, char ** result_buffer, unsigned int *result_buffer_len);
@@ -46,3 +48,4 @@ NSCAPI::errorReturn NSCAPIJson2Protobuf(const char* request_buffer, unsigned int
 NSCAPI::errorReturn NSCAPIProtobuf2Json(const char* object, const char* request_buffer, unsigned int request_buffer_len, char ** response_buffer, unsigned int *response_buffer_len);
 NSCAPI::errorReturn NSCAPIEmitEvent(const char *request_buffer, const unsigned int request_buffer_len);
 NSCAPI::errorReturn NSCAPIStorageQuery(const char *request_buffer, const unsigned int request_buffer_len, char **response_buffer, unsigned int *response_buffer_len);
+NSCAPI::errorReturn NSAPISubmitTask(nscapi::core_api::lpNSAPITask task, void *data);
@@ -23,6 +23,9 @@
 #include "NSCAPI.h"
 
 #include <str/xtos.hpp>
+#include <str/utils.hpp>
+
+#include <boost/foreach.hpp>
 
 /**
  * Default c-tor
@@ -45,7 +48,9 @@ nsclient::core::dll_plugin::dll_plugin(const unsigned int id, const boost::files
 	, fHasCommandHandler(NULL)
 	, fHasMessageHandler(NULL)
 	, fHandleCommand(NULL)
+	, fHandleCommandMessage(NULL)
 	, fHandleMessage(NULL)
+	, fGetMessageFilter(NULL)
 	, fDeleteBuffer(NULL)
 	, fUnLoadModule(NULL)
 	, fCommandLineExec(NULL)
@@ -256,6 +261,17 @@ NSCAPI::nagiosReturn nsclient::core::dll_plugin::handleCommand(const std::string
 	}
 	return ret;
 }
+NSCAPI::nagiosReturn nsclient::core::dll_plugin::handleCommand(const Plugin::QueryRequestMessage &request, Plugin::QueryResponseMessage &reply) {
+	if (fHandleCommandMessage == NULL)
+		return plugin_interface::handleCommand(request, reply);
+	if (!isLoaded() || !loaded_)
+		throw plugin_exception(get_alias_or_name(), "Library is not loaded");
+	try {
+		return fHandleCommandMessage(get_id(), &request, &reply);
+	} catch (...) {
+		throw plugin_exception(get_alias_or_name(), "Unhandled exception in handleCommand.");
+	}
+}
 
 NSCAPI::nagiosReturn nsclient::core::dll_plugin::handle_schedule(const char* dataBuffer, const unsigned int dataBuffer_len) {
 	if (!isLoaded() || fHandleSchedule == NULL)
@@ -384,6 +400,28 @@ void nsclient::core::dll_plugin::handleMessage(const char* data, unsigned int le
 		throw plugin_exception(get_alias_or_name(), "Unhandled exception in handleMessage.");
 	}
 }
+
+// Plug-ins without NSGetMessageFilter (or where it fails) are given all messages.
+nsclient::logging::log_filter nsclient::core::dll_plugin::get_log_filter() {
+	nsclient::logging::log_filter filter;
+	if (!fGetMessageFilter)
+		return filter;
+	try {
+		const char *modules = NULL;
+		fGetMessageFilter(get_id(), &filter.level, &modules);
+		if (modules != NULL) {
+			BOOST_FOREACH(const std::string &m, str::utils::split_lst(std::string(modules), std::string(","))) {
+				if (!m.empty())
+					filter.modules.insert(m);
+			}
+		}
+	} catch (...) {
+		std::string message = "Unhandled exception in getMessageFilter for " + get_alias_or_name() + ", it will be given all messages";
+		NSAPISimpleMessage("core", NSCAPI::log_level::error, __FILE__, __LINE__, message.c_str());
+		return nsclient::logging::log_filter();
+	}
+	return filter;
+}
 /**
  * Unload the plug in
  * @throws NSPluginException if the module is not loaded and/or cannot be unloaded (plug in remains loaded if so).
@@ -409,8 +447,10 @@ void nsclient::core::dll_plugin::unload_dll() {
 	fHasCommandHandler = NULL;
 	fHasMessageHandler = NULL;
 	fHandleCommand = NULL;
+	fHandleCommandMessage = NULL;
 	fDeleteBuffer = NULL;
 	fHandleMessage = NULL;
+	fGetMessageFilter = NULL;
 	fUnLoadModule = NULL;
 	fCommandLineExec = NULL;
 	fHasNotificationHandler = NULL;
@@ -485,6 +525,9 @@ void nsclient::core::dll_plugin::loadRemoteProcs_(void) {
 			throw plugin_exception(get_alias_or_name(), "Could not load NSHasMessageHandler");
 
 		fHandleCommand = (nscapi::plugin_api::lpHandleCommand)module_.load_proc("NSHandleCommand");
+		// Messages are only passed as objects when the plug-in uses the same protobuf runtime as we do.
+		if (nscapi::protobuf::is_same_runtime((nscapi::plugin_api::lpGetProtobufRuntime)module_.load_proc("NSGetProtobufRuntime")))
+			fHandleCommandMessage = (nscapi::plugin_api::lpHandleCommandMessage)module_.load_proc("NSHandleCommandMessage");
 
 		fDeleteBuffer = (nscapi::plugin_api::lpDeleteBuffer)module_.load_proc("NSDeleteBuffer");
 		if (!fDeleteBuffer)
@@ -493,6 +536,7 @@ void nsclient::core::dll_plugin::loadRemoteProcs_(void) {
 		fHandleMessage = (nscapi::plugin_api::lpHandleMessage)module_.load_proc("NSHandleMessage");
 		if (!fHandleMessage)
 			throw plugin_exception(get_alias_or_name(), "Could not load NSHandleMessage");
+		fGetMessageFilter = (nscapi::plugin_api::lpGetMessageFilter)module_.load_proc("NSGetMessageFilter");
 
 		fUnLoadModule = (nscapi::plugin_api::lpUnLoadModule)module_.load_proc("NSUnloadModule");
 		if (!fUnLoadModule)
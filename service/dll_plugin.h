@@ -74,8 +74,10 @@ namespace nsclient {
 			nscapi::plugin_api::lpHasCommandHandler fHasCommandHandler;
 			nscapi::plugin_api::lpHasMessageHandler fHasMessageHandler;
 			nscapi::plugin_api::lpHandleCommand fHandleCommand;
+			nscapi::plugin_api::lpHandleCommandMessage fHandleCommandMessage;
 			nscapi::plugin_api::lpHandleSchedule fHandleSchedule;
 			nscapi::plugin_api::lpHandleMessage fHandleMessage;
+			nscapi::plugin_api::lpGetMessageFilter fGetMessageFilter;
 			nscapi::plugin_api::lpDeleteBuffer fDeleteBuffer;
 			nscapi::plugin_api::lpUnLoadModule fUnLoadModule;
 			nscapi::plugin_api::lpCommandLineExec fCommandLineExec;
@@ -100,6 +102,7 @@ namespace nsclient {
 			bool hasNotificationHandler();
 			bool hasMessageHandler();
 			NSCAPI::nagiosReturn handleCommand(const std::string request, std::string &reply);
+			NSCAPI::nagiosReturn handleCommand(const Plugin::QueryRequestMessage &request, Plugin::QueryResponseMessage &reply);
 			NSCAPI::nagiosReturn handle_schedule(const std::string &request);
 			NSCAPI::nagiosReturn handleNotification(const char *channel, std::string &request, std::string &reply);
 			bool has_on_event();
@@ -136,6 +139,7 @@ namespace nsclient {
 			void on_log_message(std::string &payload) {
 				handleMessage(payload.c_str(), static_cast<unsigned int>(payload.size()));
 			}
+			nsclient::logging::log_filter get_log_filter();
 			std::string get_version();
 
 		private:
@@ -31,12 +31,14 @@
 #define FILE_BACKEND "file"
 #define DEFAULT_BACKEND THREADED_FILE_BACKEND
 
+const static int LOG_BATCH_SIZE = 100;
+
 void nsclient::logging::impl::nsclient_logger::set_backend(std::string backend) {
 	nsclient::logging::log_driver_instance tmp;
 	if (backend == CONSOLE_BACKEND) {
 		tmp = log_driver_instance(new simple_console_logger());
 	} else if (backend == THREADED_FILE_BACKEND) {
-		nsclient::logging::log_driver_instance inner = log_driver_instance(new simple_file_logger("nsclient.log"));
+		nsclient::logging::log_driver_instance inner = log_driver_instance(new simple_file_logger("nsclient.log", true));
 		tmp = log_driver_instance(new threaded_logger(this, inner));
 	} else if (backend == FILE_BACKEND) {
 		tmp = log_driver_instance(new simple_file_logger("nsclient.log"));
@@ -63,12 +65,75 @@ void nsclient::logging::impl::nsclient_logger::destroy() {
 }
 
 void nsclient::logging::impl::nsclient_logger::add_subscriber(nsclient::logging::logging_subscriber_instance subscriber) {
-	subscribers_.push_back(subscriber);
+	subscription s;
+	s.subscriber = subscriber;
+	s.filter = subscriber->get_log_filter();
+	boost::unique_lock<boost::timed_mutex> lock(mutex_, boost::get_system_time() + boost::posix_time::seconds(5));
+	if (!lock.owns_lock())
+		return;
+	subscribers_.push_back(s);
 }
 
 void nsclient::logging::impl::nsclient_logger::clear_subscribers() {
+	boost::unique_lock<boost::timed_mutex> lock(mutex_, boost::get_system_time() + boost::posix_time::seconds(5));
+	if (!lock.owns_lock())
+		return;
 	subscribers_.clear();
 }
+
+void nsclient::logging::impl::nsclient_logger::on_log_entry(const NSCAPI::log_level::level level, const std::string &sender, const std::string &file, const int line, const std::string &message) {
+	pending_type pending;
+	{
+		boost::unique_lock<boost::timed_mutex> lock(mutex_, boost::get_system_time() + boost::posix_time::seconds(5));
+		if (!lock.owns_lock())
+			return;
+		BOOST_FOREACH(subscription &s, subscribers_) {
+			if (!s.filter.matches(level, sender))
+				continue;
+			::Plugin::LogEntry::Entry *entry = s.batch.add_entry();
+			entry->set_level(static_cast< ::Plugin::LogEntry::Entry::Level>(level));
+			entry->set_sender(sender);
+			entry->set_file(file);
+			entry->set_line(line);
+			entry->set_message(message);
+			if (s.batch.entry_size() >= LOG_BATCH_SIZE)
+				take_batch(s, pending);
+		}
+	}
+	deliver(pending);
+}
+
+void nsclient::logging::impl::nsclient_logger::deliver_log_entries() {
+	pending_type pending;
+	{
+		boost::unique_lock<boost::timed_mutex> lock(mutex_, boost::get_system_time() + boost::posix_time::seconds(5));
+		if (!lock.owns_lock())
+			return;
+		BOOST_FOREACH(subscription &s, subscribers_) {
+			if (s.batch.entry_size() > 0)
+				take_batch(s, pending);
+		}
+	}
+	deliver(pending);
+}
+
+void nsclient::logging::impl::nsclient_logger::take_batch(subscription &s, pending_type &pending) {
+	pending.push_back(std::make_pair(s.subscriber, s.batch.SerializeAsString()));
+	s.batch.Clear();
+}
+
+void nsclient::logging::impl::nsclient_logger::deliver(pending_type &pending) {
+	typedef std::pair<nsclient::logging::logging_subscriber_instance, std::string> pending_entry;
+	BOOST_FOREACH(pending_entry &p, pending) {
+		try {
+			p.first->on_log_message(p.second);
+		} catch (const std::exception &e) {
+			nsclient::logging::logger_helper::log_fatal(std::string("Failed to deliver log messages: ") + e.what());
+		} catch (...) {
+			nsclient::logging::logger_helper::log_fatal("Failed to deliver log messages");
+		}
+	}
+}
 bool nsclient::logging::impl::nsclient_logger::startup() {
 	if (backend_) {
 		return backend_->startup();
@@ -93,4 +158,9 @@ void nsclient::logging::impl::nsclient_logger::do_log(const std::string data) {
 		backend_->do_log(data);
 	}
 }
+void nsclient::logging::impl::nsclient_logger::do_log(const ::Plugin::LogEntry::Entry::Level level, const std::string &module, const char* file, const int line, const std::string &message) {
+	if (backend_) {
+		backend_->do_log(level, module, file, line, message);
+	}
+}
 
@@ -21,6 +21,7 @@
 
 #include <list>
 #include <string>
+#include <utility>
 
 #include <boost/thread/mutex.hpp>
 #include <boost/shared_ptr.hpp>
@@ -32,10 +33,17 @@
 namespace nsclient {
 	namespace logging {
 		namespace impl {
-			class nsclient_logger : public nsclient::logging::logger_impl, nsclient::logging::logging_subscriber {
+			class nsclient_logger : public nsclient::logging::logger_impl, nsclient::logging::log_dispatcher {
 
-
-				typedef std::list<nsclient::logging::logging_subscriber_instance> subscribers_type;
+				// Entries matching the filter are collected and delivered as one message (with several entries).
+				struct subscription {
+					nsclient::logging::logging_subscriber_instance subscriber;
+					nsclient::logging::log_filter filter;
+					Plugin::LogEntry batch;
+				};
+				typedef std::list<subscription> subscribers_type;
+				// Batches taken out under the lock and delivered once it is released (so a slow plug-in does not block logging).
+				typedef std::list<std::pair<nsclient::logging::logging_subscriber_instance, std::string> > pending_type;
 
 
 				nsclient::logging::log_driver_instance backend_;
@@ -47,28 +55,33 @@ namespace nsclient {
 				nsclient_logger();
 				~nsclient_logger();
 
-				void add(nsclient::logging::logging_subscriber_instance subscriber) {
-					boost::unique_lock<boost::timed_mutex> lock(mutex_, boost::get_system_time() + boost::posix_time::seconds(5));
-					if (!lock.owns_lock())
-						return;
-					subscribers_.push_back(subscriber);
+				void on_log_entry(const NSCAPI::log_level::level level, const std::string &sender, const std::string &file, const int line, const std::string &message);
+				void deliver_log_entries();
+
+				// Entries are passed to the backend as they are (the threaded backend only creates messages for matching subscribers).
+				void trace(const std::string &module, const char* file, const int line, const std::string &message) {
+					if (should_trace())
+						do_log(::Plugin::LogEntry_Entry_Level_LOG_TRACE, module, file, line, message);
 				}
-				void clear() {
-					boost::unique_lock<boost::timed_mutex> lock(mutex_, boost::get_system_time() + boost::posix_time::seconds(5));
-					if (!lock.owns_lock())
-						return;
-					subscribers_.clear();
+				void debug(const std::string &module, const char* file, const int line, const std::string &message) {
+					if (should_debug())
+						do_log(::Plugin::LogEntry_Entry_Level_LOG_DEBUG, module, file, line, message);
 				}
-
-				void on_log_message(std::string &data) {
-					boost::unique_lock<boost::timed_mutex> lock(mutex_, boost::get_system_time() + boost::posix_time::seconds(5));
-					if (!lock.owns_lock())
-						return;
-					if (subscribers_.empty())
-						return;
-					BOOST_FOREACH(nsclient::logging::logging_subscriber_instance & s, subscribers_) {
-						s->on_log_message(data);
-					}
+				void info(const std::string &module, const char* file, const int line, const std::string &message) {
+					if (should_info())
+						do_log(::Plugin::LogEntry_Entry_Level_LOG_INFO, module, file, line, message);
+				}
+				void warning(const std::string &module, const char* file, const int line, const std::string &message) {
+					if (should_warning())
+						do_log(::Plugin::LogEntry_Entry_Level_LOG_WARNING, module, file, line, message);
+				}
+				void error(const std::string &module, const char* file, const int line, const std::string &message) {
+					if (should_error())
+						do_log(::Plugin::LogEntry_Entry_Level_LOG_ERROR, module, file, line, message);
+				}
+				void critical(const std::string &module, const char* file, const int line, const std::string &message) {
+					if (should_critical())
+						do_log(::Plugin::LogEntry_Entry_Level_LOG_CRITICAL, module, file, line, message);
 				}
 
 
@@ -84,6 +97,7 @@ namespace nsclient {
 
 
 				void do_log(const std::string data);
+				void do_log(const ::Plugin::LogEntry::Entry::Level level, const std::string &module, const char* file, const int line, const std::string &message);
 
 
 
@@ -97,6 +111,10 @@ namespace nsclient {
 				bool shutdown();
 				void configure();
 
+			private:
+				void take_batch(subscription &s, pending_type &pending);
+				void deliver(pending_type &pending);
+
 			};
 		}
 	}
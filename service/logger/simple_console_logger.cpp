@@ -46,6 +46,15 @@ namespace nsclient {
 							std::cout << m.second;
 					}
 				}
+				void simple_console_logger::do_log(const ::Plugin::LogEntry::Entry::Level level, const std::string &sender, const char* file, const int line, const std::string &message) {
+					if (is_console()) {
+						std::pair<bool, std::string> m = logger_helper::render_console_message(is_oneline(), level, sender, file, line, message);
+						if (!is_no_std_err() && m.first)
+							std::cerr << m.second;
+						else
+							std::cout << m.second;
+					}
+				}
 				simple_console_logger::config_data simple_console_logger::do_config() {
 					config_data ret;
 					try {
@@ -33,6 +33,7 @@ namespace nsclient {
 			public:
 				simple_console_logger();
 				void do_log(const std::string data);
+				void do_log(const ::Plugin::LogEntry::Entry::Level level, const std::string &sender, const char* file, const int line, const std::string &message);
 				struct config_data {
 					std::string format;
 				};
@@ -26,6 +26,7 @@
 
 #include <file_helpers.hpp>
 #include <str/format.hpp>
+#include <str/xtos.hpp>
 
 #include <boost/filesystem.hpp>
 
@@ -44,7 +45,9 @@ namespace nsclient {
 			namespace sh = nscapi::settings_helper;
 
 
-			simple_file_logger::simple_file_logger(std::string file) : max_size_(0), format_("%Y-%m-%d %H:%M:%S") {
+			const static std::size_t MAX_BUFFER_SIZE = 64 * 1024;
+
+			simple_file_logger::simple_file_logger(std::string file, bool buffered) : max_size_(0), rotate_count_(1), format_("%Y-%m-%d %H:%M:%S"), date_time_(0), buffered_(buffered), size_(0) {
 				file_ = base_path() + file;
 			}
 			std::string simple_file_logger::base_path() {
@@ -63,60 +66,22 @@ namespace nsclient {
 			}
 
 			void simple_file_logger::do_log(const std::string data) {
-				if (file_.empty())
-					return;
 				try {
-					if (max_size_ != 0 && boost::filesystem::exists(file_.c_str()) && boost::filesystem::file_size(file_.c_str()) > max_size_) {
-						int target_size = static_cast<int>(max_size_*0.7);
-						char *tmpBuffer = new char[target_size + 1];
-						try {
-							std::ifstream ifs(file_.c_str());
-							ifs.seekg(-target_size, std::ios_base::end);
-							ifs.read(tmpBuffer, target_size);
-							ifs.close();
-							std::ofstream ofs(file_.c_str(), std::ios::trunc);
-							ofs.write(tmpBuffer, target_size);
-						} catch (...) {
-							logger_helper::log_fatal("Failed to truncate log file: " + file_);
-						}
-						delete[] tmpBuffer;
-					}
-					if (!boost::filesystem::exists(file_.c_str())) {
-						boost::filesystem::path parent = file_helpers::meta::get_path(file_);
-						if (!boost::filesystem::exists(parent.string())) {
-							try {
-								boost::filesystem::create_directories(parent);
-							} catch (...) {
-								logger_helper::log_fatal("Failed to create directory: " + parent.string());
-							}
-						}
-					}
-					std::string date = nsclient::logging::logger_helper::get_formated_date(format_);
-
 					Plugin::LogEntry message;
 					if (!message.ParseFromString(data)) {
 						logger_helper::log_fatal("Failed to parse message: " + str::format::strip_ctrl_chars(data));
-					} else {
-						std::stringstream tmp;
-						for (int i = 0; i < message.entry_size(); i++) {
-							Plugin::LogEntry::Entry msg = message.entry(i);
-							tmp << date
-								<< (": ") << utf8::cvt<std::string>(logger_helper::render_log_level_long(msg.level()))
-								<< (":") << msg.file()
-								<< (":") << msg.line()
-								<< (": ") << msg.message() << "\n";
-						}
-						try {
-							std::ofstream stream(file_.c_str(), std::ios::out | std::ios::app | std::ios::ate);
-							if (!stream) {
-								logger_helper::log_fatal(file_ + " could not be opened, Discarding: " + tmp.str());
-							} else {
-								stream << tmp.str();
-							}
-						} catch (std::exception &e) {
-							logger_helper::log_fatal("Failed to write log: " + tmp.str() + ": " + e.what());
-						}
+						return;
+					}
+					boost::mutex::scoped_lock lock(mutex_);
+					if (file_.empty())
+						return;
+					const std::string date = nsclient::logging::logger_helper::get_formated_date(format_);
+					for (int i = 0; i < message.entry_size(); i++) {
+						const Plugin::LogEntry::Entry &msg = message.entry(i);
+						append_entry(date, msg.level(), msg.file().c_str(), msg.line(), msg.message());
 					}
+					if (!buffered_ || buffer_.size() >= MAX_BUFFER_SIZE)
+						write_buffer();
 				} catch (std::exception &e) {
 					logger_helper::log_fatal("Failed to parse data from: " + str::format::strip_ctrl_chars(data) + ": " + e.what());
 				} catch (...) {
@@ -124,6 +89,131 @@ namespace nsclient {
 				}
 			}
 
+			void simple_file_logger::do_log(const ::Plugin::LogEntry::Entry::Level level, const std::string &, const char* file, const int line, const std::string &message) {
+				try {
+					boost::mutex::scoped_lock lock(mutex_);
+					if (file_.empty())
+						return;
+					// The date only has second resolution so it is only rendered when it changes.
+					const std::time_t now = std::time(NULL);
+					if (now != date_time_ || date_.empty()) {
+						date_ = nsclient::logging::logger_helper::get_formated_date(format_);
+						date_time_ = now;
+					}
+					append_entry(date_, level, file, line, message);
+					if (!buffered_ || buffer_.size() >= MAX_BUFFER_SIZE)
+						write_buffer();
+				} catch (const std::exception &e) {
+					logger_helper::log_fatal(std::string("Failed to write log: ") + e.what());
+				} catch (...) {
+					logger_helper::log_fatal("Failed to write log");
+				}
+			}
+
+			void simple_file_logger::append_entry(const std::string &date, const ::Plugin::LogEntry::Entry::Level level, const char* file, const int line, const std::string &message) {
+				buffer_.append(date);
+				buffer_.append(": ");
+				buffer_.append(logger_helper::render_log_level_long(level));
+				buffer_.append(":");
+				buffer_.append(file);
+				buffer_.append(":");
+				buffer_.append(str::xtos(line));
+				buffer_.append(": ");
+				buffer_.append(message);
+				buffer_.append("\n");
+			}
+
+			void simple_file_logger::flush() {
+				try {
+					boost::mutex::scoped_lock lock(mutex_);
+					write_buffer();
+				} catch (const std::exception &e) {
+					logger_helper::log_fatal(std::string("Failed to write log: ") + e.what());
+				} catch (...) {
+					logger_helper::log_fatal("Failed to write log");
+				}
+			}
+
+			// Writes all buffered messages in one go (the caller holds the mutex).
+			void simple_file_logger::write_buffer() {
+				if (buffer_.empty())
+					return;
+				if (!stream_.is_open() && !open_file()) {
+					logger_helper::log_fatal(file_ + " could not be opened, Discarding: " + buffer_);
+					buffer_.clear();
+					return;
+				}
+				if (max_size_ != 0 && size_ > 0 && size_ + buffer_.size() > max_size_) {
+					rotate_file();
+					if (!stream_.is_open()) {
+						logger_helper::log_fatal(file_ + " could not be opened, Discarding: " + buffer_);
+						buffer_.clear();
+						return;
+					}
+				}
+				stream_.write(buffer_.c_str(), buffer_.size());
+				stream_.flush();
+				if (!stream_) {
+					logger_helper::log_fatal("Failed to write log: " + file_);
+					close_file();
+				} else {
+					size_ += buffer_.size();
+				}
+				buffer_.clear();
+			}
+
+			bool simple_file_logger::open_file() {
+				boost::filesystem::path parent = file_helpers::meta::get_path(file_);
+				if (!parent.empty() && !boost::filesystem::exists(parent)) {
+					try {
+						boost::filesystem::create_directories(parent);
+					} catch (...) {
+						logger_helper::log_fatal("Failed to create directory: " + parent.string());
+					}
+				}
+				boost::system::error_code ec;
+				size_ = boost::filesystem::file_size(file_, ec);
+				if (ec)
+					size_ = 0;
+				stream_.open(file_.c_str(), std::ios::out | std::ios::app);
+				return stream_.is_open();
+			}
+
+			void simple_file_logger::close_file() {
+				if (stream_.is_open())
+					stream_.close();
+				stream_.clear();
+				size_ = 0;
+			}
+
+			// Renames file.N-1 to file.N and so on down to file to file.1 (the oldest generation is dropped).
+			void simple_file_logger::rotate_file() {
+				close_file();
+				boost::system::error_code ec;
+				if (rotate_count_ == 0) {
+					boost::filesystem::remove(file_, ec);
+				} else {
+					boost::filesystem::remove(file_ + "." + str::xtos(rotate_count_), ec);
+					for (std::size_t i = rotate_count_; i > 1; i--) {
+						boost::system::error_code ignored;
+						boost::filesystem::rename(file_ + "." + str::xtos(i - 1), file_ + "." + str::xtos(i), ignored);
+					}
+					boost::filesystem::rename(file_, file_ + ".1", ec);
+				}
+				if (ec)
+					logger_helper::log_fatal("Failed to rotate log file: " + file_ + ": " + ec.message());
+				open_file();
+			}
+
+			bool simple_file_logger::shutdown() {
+				flush();
+				{
+					boost::mutex::scoped_lock lock(mutex_);
+					close_file();
+				}
+				return log_driver_interface_impl::shutdown();
+			}
+
 			simple_file_logger::config_data simple_file_logger::do_config(const bool log_fault) {
 				config_data ret;
 				try {
@@ -147,7 +237,10 @@ namespace nsclient {
 
 					settings.add_key_to_settings("log/file")
 						("max size", sh::size_key(&ret.max_size, 0),
-							"MAXIMUM FILE SIZE", "When file size reaches this it will be truncated to 50% if set to 0 (default) truncation will be disabled")
+							"MAXIMUM FILE SIZE", "When file size reaches this it will be rotated if set to 0 (default) rotation will be disabled")
+
+						("rotate count", sh::size_key(&ret.rotate_count, 1),
+							"ROTATED FILES", "Number of rotated log files (nsclient.log.1, nsclient.log.2 ...) to keep, if set to 0 the log file is truncated instead")
 						;
 
 					settings.register_all();
@@ -175,17 +268,26 @@ namespace nsclient {
 				try {
 					config_data config = do_config(false);
 
-					format_ = config.format;
-					max_size_ = config.max_size;
-					file_ = settings_manager::get_proxy()->expand_path(config.file);
-					if (file_.empty())
-						file_ = base_path() + "nsclient.log";
-					if (file_.find('\\') == std::string::npos && file_.find('/') == std::string::npos) {
-						file_ = base_path() + file_;
+					std::string file = settings_manager::get_proxy()->expand_path(config.file);
+					if (file.empty())
+						file = base_path() + "nsclient.log";
+					if (file.find('\\') == std::string::npos && file.find('/') == std::string::npos) {
+						file = base_path() + file;
+					}
+					if (file == "none") {
+						file = "";
 					}
-					if (file_ == "none") {
-						file_ = "";
+
+					boost::mutex::scoped_lock lock(mutex_);
+					if (file != file_) {
+						write_buffer();
+						close_file();
 					}
+					format_ = config.format;
+					date_.clear();
+					max_size_ = config.max_size;
+					rotate_count_ = config.rotate_count;
+					file_ = file;
 				} catch (const std::exception &e) {
 					// ignored, since this might be after shutdown...
 				} catch (...) {
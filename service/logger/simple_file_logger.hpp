@@ -21,6 +21,11 @@
 
 #include <nsclient/logger/base_logger_impl.hpp>
 
+#include <boost/thread/mutex.hpp>
+#include <boost/cstdint.hpp>
+
+#include <ctime>
+#include <fstream>
 #include <string>
 
 namespace nsclient {
@@ -29,22 +34,42 @@ namespace nsclient {
 			class simple_file_logger : public nsclient::logging::log_driver_interface_impl {
 				std::string file_;
 				std::size_t max_size_;
+				std::size_t rotate_count_;
 				std::string format_;
+				std::string date_;
+				std::time_t date_time_;
+
+				// When buffered messages are held until flush is called (or the buffer fills up).
+				bool buffered_;
+				boost::mutex mutex_;
+				std::ofstream stream_;
+				std::string buffer_;
+				boost::uintmax_t size_;
 
 			public:
-				simple_file_logger(std::string file);
+				simple_file_logger(std::string file, bool buffered = false);
 				std::string base_path();
 
 				void do_log(const std::string data);
+				void do_log(const ::Plugin::LogEntry::Entry::Level level, const std::string &sender, const char* file, const int line, const std::string &message);
+				void flush();
 				struct config_data {
 					std::string file;
 					std::string format;
 					std::size_t max_size;
+					std::size_t rotate_count;
 				};
 				config_data do_config(const bool log_fault);
 				void synch_configure();
 				void asynch_configure();
-				bool shutdown() { return true;  }
+				bool shutdown();
+
+			private:
+				void append_entry(const std::string &date, const ::Plugin::LogEntry::Entry::Level level, const char* file, const int line, const std::string &message);
+				void write_buffer();
+				bool open_file();
+				void close_file();
+				void rotate_file();
 			};
 
 		}
@@ -19,51 +19,180 @@
 
 #include "threaded_logger.hpp"
 
+#include <str/format.hpp>
+#include <str/xtos.hpp>
+
+#include <boost/foreach.hpp>
+
 #include <iostream>
 
-const static std::string QUIT_MESSAGE = "$$QUIT$$";
-const static std::string CONFIGURE_MESSAGE = "$$CONFIGURE$$";
-const static std::string SET_CONFIG_MESSAGE = "$$SET_CONFIG$$";
+const static std::size_t LOG_QUEUE_SIZE = 8192;
+const static boost::posix_time::milliseconds FLUSH_INTERVAL(1000);
+const static boost::posix_time::milliseconds IDLE_INTERVAL(5000);
 
 namespace nsclient {
 	namespace logging {
 		namespace impl {
-			threaded_logger::threaded_logger(logging_subscriber *subscriber_manager, log_driver_instance background_logger) : subscriber_manager_(subscriber_manager), background_logger_(background_logger) {}
+			threaded_logger::log_record::log_record() : level(::Plugin::LogEntry_Entry_Level_LOG_INFO), line(0) {}
+
+			threaded_logger::threaded_logger(log_dispatcher *subscriber_manager, log_driver_instance background_logger)
+				: ring_(LOG_QUEUE_SIZE)
+				, dropped_(0)
+				, control_quit_(false)
+				, control_configure_(false)
+				, control_flush_(false)
+				, control_pending_(false)
+				, waiting_(false)
+				, subscriber_manager_(subscriber_manager)
+				, background_logger_(background_logger) {}
 			threaded_logger::~threaded_logger() {
 				shutdown();
 			}
 
 			void threaded_logger::do_log(const std::string data) {
-				push(data);
+				try {
+					Plugin::LogEntry message;
+					if (!message.ParseFromString(data)) {
+						logger_helper::log_fatal("Failed to parse message: " + str::format::strip_ctrl_chars(data));
+						return;
+					}
+					for (int i = 0; i < message.entry_size(); i++) {
+						const Plugin::LogEntry::Entry &msg = message.entry(i);
+						push(msg.level(), msg.sender(), msg.file().c_str(), msg.line(), msg.message());
+					}
+				} catch (const std::exception &e) {
+					logger_helper::log_fatal(std::string("Failed to parse log message: ") + e.what());
+				} catch (...) {
+					logger_helper::log_fatal("Failed to parse log message");
+				}
 			}
-			void threaded_logger::push(const std::string &data) {
-				log_queue_.push(data);
+			void threaded_logger::do_log(const ::Plugin::LogEntry::Entry::Level level, const std::string &sender, const char* file, const int line, const std::string &message) {
+				push(level, sender, file, line, message);
+			}
+			void threaded_logger::push(const ::Plugin::LogEntry::Entry::Level level, const std::string &sender, const char* file, const int line, const std::string &message) {
+				std::size_t position;
+				log_record *record = ring_.claim(position);
+				if (record == NULL) {
+					dropped_++;
+					return;
+				}
+				record->level = level;
+				record->line = line;
+				try {
+					record->sender = sender;
+					record->file = file;
+					record->message = message;
+				} catch (...) {
+					// A claimed slot has to be published or the consumer would wait for it forever.
+					record->message.clear();
+				}
+				ring_.publish(position);
+				boost::atomic_thread_fence(boost::memory_order_seq_cst);
+				if (waiting_.load(boost::memory_order_relaxed))
+					wake();
+			}
+
+			void threaded_logger::wake() {
+				boost::mutex::scoped_lock lock(wait_mutex_);
+				wait_cond_.notify_one();
+			}
+
+			void threaded_logger::signal_control() {
+				control_pending_ = true;
+				wake();
+			}
+
+			void threaded_logger::process(const log_record &record) {
+				try {
+					if (!background_logger_ || background_logger_->is_console()) {
+						std::pair<bool, std::string> m = logger_helper::render_console_message(is_oneline(), record.level, record.sender, record.file.c_str(), record.line, record.message);
+						if (!is_no_std_err() && m.first)
+							std::cerr << m.second;
+						else
+							std::cout << m.second;
+					}
+					if (background_logger_)
+						background_logger_->do_log(record.level, record.sender, record.file.c_str(), record.line, record.message);
+					subscriber_manager_->on_log_entry(record.level, record.sender, record.file, record.line, record.message);
+				} catch (const std::exception &e) {
+					logger_helper::log_fatal(std::string("Failed to process log message: ") + e.what());
+				} catch (...) {
+					logger_helper::log_fatal("Failed to process log message");
+				}
 			}
 
 			void threaded_logger::thread_proc() {
-				std::string data;
+				// Messages are handed to the background logger as they arrive and written out at most one interval later.
+				bool pending = false;
+				boost::system_time flush_deadline;
+				boost::uint64_t reported_dropped = 0;
 				while (true) {
 					try {
-						log_queue_.wait_and_pop(data);
-						if (data == QUIT_MESSAGE) {
-							return;
-						} else if (data == CONFIGURE_MESSAGE) {
-							if (background_logger_)
+						// Bounded so control messages and flushing are not starved by a busy producer
+						log_record *record;
+						for (std::size_t i = 0; i < ring_.capacity() && (record = ring_.front()) != NULL; i++) {
+							process(*record);
+							ring_.pop();
+							if (!pending) {
+								pending = true;
+								flush_deadline = boost::get_system_time() + FLUSH_INTERVAL;
+							}
+						}
+						const boost::uint64_t dropped = dropped_;
+						if (dropped != reported_dropped) {
+							log_record overflow;
+							overflow.level = ::Plugin::LogEntry_Entry_Level_LOG_WARNING;
+							overflow.sender = "core";
+							overflow.file = __FILE__;
+							overflow.line = __LINE__;
+							overflow.message = "Log queue was full, " + str::xtos(dropped - reported_dropped) + " messages were dropped";
+							process(overflow);
+							reported_dropped = dropped;
+						}
+						subscriber_manager_->deliver_log_entries();
+
+						if (control_pending_.exchange(false)) {
+							bool quit, configure, flush;
+							std::list<std::string> config;
+							{
+								boost::mutex::scoped_lock lock(control_mutex_);
+								quit = control_quit_;
+								configure = control_configure_;
+								flush = control_flush_;
+								control_configure_ = control_flush_ = false;
+								config.swap(control_config_);
+							}
+							BOOST_FOREACH(const std::string &key, config) {
+								if (background_logger_)
+									background_logger_->set_config(key);
+							}
+							if (configure && background_logger_)
 								background_logger_->asynch_configure();
-						} else if (data.size() > SET_CONFIG_MESSAGE.size() && data.substr(0, SET_CONFIG_MESSAGE.size()) == SET_CONFIG_MESSAGE) {
-							background_logger_->set_config(data.substr(SET_CONFIG_MESSAGE.size()));
-						} else {
-							if (!background_logger_ || background_logger_->is_console()) {
-								std::pair<bool, std::string> m = logger_helper::render_console_message(is_oneline(), data);
-								if (!is_no_std_err() && m.first)
-									std::cerr << m.second;
-								else
-									std::cout << m.second;
+							if (quit) {
+								while ((record = ring_.front()) != NULL) {
+									process(*record);
+									ring_.pop();
+								}
+								subscriber_manager_->deliver_log_entries();
+								flush_background();
+								return;
+							}
+							if (flush) {
+								flush_background();
+								pending = false;
 							}
-							if (background_logger_)
-								background_logger_->do_log(data);
-							subscriber_manager_->on_log_message(data);
 						}
+						if (pending && boost::get_system_time() >= flush_deadline) {
+							flush_background();
+							pending = false;
+						}
+
+						boost::mutex::scoped_lock lock(wait_mutex_);
+						waiting_ = true;
+						boost::atomic_thread_fence(boost::memory_order_seq_cst);
+						if (ring_.front() == NULL && !control_pending_)
+							wait_cond_.timed_wait(lock, pending ? flush_deadline : boost::get_system_time() + IDLE_INTERVAL);
+						waiting_ = false;
 					} catch (const std::exception &e) {
 						logger_helper::log_fatal(std::string("Failed to process log message: ") + e.what());
 					} catch (...) {
@@ -72,8 +201,24 @@ namespace nsclient {
 				}
 			}
 
+			void threaded_logger::flush_background() {
+				if (background_logger_)
+					background_logger_->flush();
+			}
+
+			void threaded_logger::flush() {
+				{
+					boost::mutex::scoped_lock lock(control_mutex_);
+					control_flush_ = true;
+				}
+				signal_control();
+			}
 			void threaded_logger::asynch_configure() {
-				push(CONFIGURE_MESSAGE);
+				{
+					boost::mutex::scoped_lock lock(control_mutex_);
+					control_configure_ = true;
+				}
+				signal_control();
 			}
 			void threaded_logger::synch_configure() {
 				background_logger_->synch_configure();
@@ -81,6 +226,10 @@ namespace nsclient {
 			bool threaded_logger::startup() {
 				if (is_started())
 					return true;
+				{
+					boost::mutex::scoped_lock lock(control_mutex_);
+					control_quit_ = false;
+				}
 				thread_ = boost::thread(boost::bind(&threaded_logger::thread_proc, this));
 				return nsclient::logging::log_driver_interface_impl::startup();
 			}
@@ -88,7 +237,11 @@ namespace nsclient {
 				if (!is_started())
 					return true;
 				try {
-					push(QUIT_MESSAGE);
+					{
+						boost::mutex::scoped_lock lock(control_mutex_);
+						control_quit_ = true;
+					}
+					signal_control();
 					if (!thread_.timed_join(boost::posix_time::seconds(10))) {
 						logger_helper::log_fatal("Failed to exit log slave!");
 						nsclient::logging::log_driver_interface_impl::shutdown();
@@ -104,9 +257,12 @@ namespace nsclient {
 				return false;
 			}
 			void threaded_logger::set_config(const std::string &key) {
-				std::string message = SET_CONFIG_MESSAGE + key;
-				push(message);
+				{
+					boost::mutex::scoped_lock lock(control_mutex_);
+					control_config_.push_back(key);
+				}
+				signal_control();
 			}
 		}
 	}
-}
\ No newline at end of file
+}
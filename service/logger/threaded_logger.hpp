@@ -21,11 +21,14 @@
 
 #include <nsclient/logger/base_logger_impl.hpp>
 
-#include <concurrent_queue.hpp>
+#include <threads/mpsc_ring.hpp>
 
+#include <boost/atomic.hpp>
+#include <boost/cstdint.hpp>
 #include <boost/thread.hpp>
 #include <boost/shared_ptr.hpp>
 
+#include <list>
 #include <string>
 
 
@@ -33,22 +36,52 @@ namespace nsclient {
 	namespace logging {
 		namespace impl {
 			class threaded_logger : public nsclient::logging::log_driver_interface_impl {
-				concurrent_queue<std::string> log_queue_;
+				// A pre-allocated log entry, the strings keep their capacity so reusing a record does not allocate (once they have grown).
+				struct log_record {
+					::Plugin::LogEntry::Entry::Level level;
+					int line;
+					std::string sender;
+					std::string file;
+					std::string message;
+					log_record();
+				};
+
+				nscp_thread::mpsc_ring<log_record> ring_;
+				boost::atomic<boost::uint64_t> dropped_;
 				boost::thread thread_;
 
-				logging_subscriber *subscriber_manager_;
+				// Control messages are passed next to the ring (and are handled once the records already in the ring have been logged).
+				boost::mutex control_mutex_;
+				bool control_quit_;
+				bool control_configure_;
+				bool control_flush_;
+				std::list<std::string> control_config_;
+				boost::atomic<bool> control_pending_;
+
+				// The consumer only sleeps on the condition when the ring is empty (producers only wake it if it is).
+				boost::mutex wait_mutex_;
+				boost::condition_variable wait_cond_;
+				boost::atomic<bool> waiting_;
+
+				log_dispatcher *subscriber_manager_;
 				log_driver_instance background_logger_;
 
 			public:
 
-				threaded_logger(logging_subscriber *subscriber_manager, log_driver_instance background_logger);
+				threaded_logger(log_dispatcher *subscriber_manager, log_driver_instance background_logger);
 				virtual ~threaded_logger();
 
 				virtual void do_log(const std::string data);
-				void push(const std::string &data);
+				virtual void do_log(const ::Plugin::LogEntry::Entry::Level level, const std::string &sender, const char* file, const int line, const std::string &message);
+				void push(const ::Plugin::LogEntry::Entry::Level level, const std::string &sender, const char* file, const int line, const std::string &message);
+				boost::uint64_t get_dropped() const {
+					return dropped_;
+				}
 
 				void thread_proc();
+				void flush_background();
 
+				virtual void flush();
 				virtual void asynch_configure();
 				virtual void synch_configure();
 				virtual bool startup();
@@ -56,7 +89,12 @@ namespace nsclient {
 
 				//virtual void set_log_level(NSCAPI::log_level::level level);
 				virtual void set_config(const std::string &key);
+
+			private:
+				void signal_control();
+				void wake();
+				void process(const log_record &record);
 			};
 		}
 	}
-}
\ No newline at end of file
+}
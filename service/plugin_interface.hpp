@@ -2,6 +2,7 @@
 
 #include <NSCAPI.h>
 #include <nsclient/logger/logger.hpp>
+#include <nscapi/nscapi_protobuf.hpp>
 
 #include <string>
 
@@ -51,6 +52,14 @@ namespace nsclient {
 
       virtual bool hasCommandHandler() = 0;
       virtual NSCAPI::nagiosReturn handleCommand(const std::string request, std::string &reply) = 0;
+      // Plug-ins which cannot share message objects with the core are given the serialized request.
+      virtual NSCAPI::nagiosReturn handleCommand(const Plugin::QueryRequestMessage &request, Plugin::QueryResponseMessage &reply) {
+        std::string response;
+        NSCAPI::nagiosReturn ret = handleCommand(request.SerializeAsString(), response);
+        if (ret == NSCAPI::cmd_return_codes::isSuccess)
+          reply.ParseFromString(response);
+        return ret;
+      }
       virtual bool hasNotificationHandler() = 0;
       virtual NSCAPI::nagiosReturn handleNotification(const char *channel, std::string &request, std::string &reply) = 0;
       virtual NSCAPI::nagiosReturn handle_schedule(const std::string &request) = 0;
@@ -32,10 +32,77 @@
 #include <nscapi/nscapi_protobuf_functions.hpp>
 
 #include <boost/unordered_map.hpp>
+#include <boost/bind.hpp>
+#include <boost/make_shared.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/condition_variable.hpp>
+
+#include <algorithm>
+#include <functional>
 
 struct command_chunk {
 	nsclient::commands::plugin_type plugin;
 	Plugin::QueryRequestMessage request;
+	Plugin::QueryResponseMessage response;
+	// Position of each payload in the original request
+	std::vector<int> payloads;
+	NSCAPI::nagiosReturn result;
+	std::string error;
+
+	command_chunk() : result(NSCAPI::cmd_return_codes::hasFailed) {}
+};
+
+// The chunks of a query spread over several plug-ins.
+// Tasks hold a reference so a chunk which misses the deadline can still finish after the query has returned.
+struct query_fanout : public boost::noncopyable {
+	enum chunk_state { pending, running, done, cancelled };
+	std::vector<command_chunk> chunks;
+	std::vector<chunk_state> states;
+	boost::mutex mutex;
+	boost::condition_variable done_cond;
+
+	// Runs the chunk unless it has already been picked up (by a worker or the caller).
+	void run(std::size_t i) {
+		{
+			boost::unique_lock<boost::mutex> lock(mutex);
+			if (states[i] != pending)
+				return;
+			states[i] = running;
+		}
+		command_chunk &chunk = chunks[i];
+		try {
+			chunk.result = chunk.plugin->handleCommand(chunk.request, chunk.response);
+		} catch (const std::exception &e) {
+			chunk.error = utf8::utf8_from_native(e.what());
+		} catch (...) {
+			chunk.error = "Unknown exception";
+		}
+		{
+			boost::unique_lock<boost::mutex> lock(mutex);
+			states[i] = done;
+		}
+		done_cond.notify_all();
+	}
+	static void run_task(boost::shared_ptr<query_fanout> fanout, std::size_t i) {
+		fanout->run(i);
+	}
+
+	// Waits for all chunks until the deadline (if there is one), chunks which have not started by then are never run.
+	void wait(bool has_deadline, boost::system_time deadline) {
+		boost::unique_lock<boost::mutex> lock(mutex);
+		while (std::find_if(states.begin(), states.end(), std::bind2nd(std::not_equal_to<chunk_state>(), done)) != states.end()) {
+			if (!has_deadline) {
+				done_cond.wait(lock);
+			} else if (!done_cond.timed_wait(lock, deadline)) {
+				std::replace(states.begin(), states.end(), pending, cancelled);
+				return;
+			}
+		}
+	}
+	bool is_done(std::size_t i) {
+		boost::unique_lock<boost::mutex> lock(mutex);
+		return states[i] == done;
+	}
 };
 
 bool nsclient::core::plugin_manager::contains_plugin(nsclient::core::plugin_manager::plugin_alias_list_type &ret, std::string alias, std::string plugin) {
@@ -57,6 +124,7 @@ nsclient::core::plugin_manager::plugin_manager(nsclient::core::path_instance pat
 	, metrics_submitetrs_(log_instance_)
 	, plugin_cache_(log_instance_)
 	, event_subscribers_(log_instance_)
+	, query_timeout_(60)
 {
 }
 
@@ -416,89 +484,151 @@ nsclient::core::plugin_manager::plugin_type nsclient::core::plugin_manager::find
 
 ::Plugin::QueryResponseMessage nsclient::core::plugin_manager::execute_query(const ::Plugin::QueryRequestMessage &req) {
 	::Plugin::QueryResponseMessage resp;
-	std::string buffer;
-	if (execute_query(req.SerializeAsString(), buffer) == NSCAPI::cmd_return_codes::isSuccess) {
-		resp.ParseFromString(buffer);
-	}
+	execute_query(req, resp);
 	return resp;
 }
+NSCAPI::nagiosReturn nsclient::core::plugin_manager::execute_query(const std::string &request, std::string &response) {
+	Plugin::QueryRequestMessage request_message;
+	Plugin::QueryResponseMessage response_message;
+	request_message.ParseFromString(request);
+	NSCAPI::nagiosReturn ret = execute_query(request_message, response_message);
+	if (ret == NSCAPI::cmd_return_codes::isSuccess)
+		response = response_message.SerializeAsString();
+	return ret;
+}
 /**
  * Inject a command into the plug-in stack.
+ * When all commands are handled by the same plug-in the request is passed on as-is, otherwise it is split per plug-in.
  *
- * @param command Command to inject
- * @param argLen Length of argument buffer
- * @param **argument Argument buffer
- * @param *returnMessageBuffer Message buffer
- * @param returnMessageBufferLen Length of returnMessageBuffer
- * @param *returnPerfBuffer Performance data buffer
- * @param returnPerfBufferLen Length of returnPerfBuffer
+ * @param request_message The query to execute
+ * @param response_message The (merged) response from all plug-ins
  * @return The command status
  */
-NSCAPI::nagiosReturn nsclient::core::plugin_manager::execute_query(const std::string &request, std::string &response) {
+NSCAPI::nagiosReturn nsclient::core::plugin_manager::execute_query(const Plugin::QueryRequestMessage &request_message, Plugin::QueryResponseMessage &response_message) {
 	try {
-		Plugin::QueryRequestMessage request_message;
-		Plugin::QueryResponseMessage response_message;
-		request_message.ParseFromString(request);
-
-		typedef boost::unordered_map<int, command_chunk> command_chunk_type;
-		command_chunk_type command_chunks;
+		boost::shared_ptr<query_fanout> fanout = boost::make_shared<query_fanout>();
+		boost::unordered_map<unsigned int, std::size_t> chunk_index;
+		nsclient::commands::plugin_type single_plugin;
 
 		std::string missing_commands;
 
 		if (request_message.header().has_command()) {
 			std::string command = request_message.header().command();
-			nsclient::commands::plugin_type plugin = commands_.get(command);
-			if (plugin) {
-				unsigned int id = plugin->get_id();
-				command_chunks[id].plugin = plugin;
-				command_chunks[id].request.CopyFrom(request_message);
-			} else {
+			single_plugin = commands_.get(command);
+			if (!single_plugin) {
 				str::format::append_list(missing_commands, command);
 			}
 		} else {
+			std::vector<std::string> keys;
+			std::vector<nsclient::commands::plugin_type> plugins;
+			bool is_single = true;
 			for (int i = 0; i < request_message.payload_size(); i++) {
-				::Plugin::QueryRequestMessage::Request *payload = request_message.mutable_payload(i);
-				payload->set_command(commands_.make_key(payload->command()));
-				nsclient::commands::plugin_type plugin = commands_.get(payload->command());
-				if (plugin) {
-					unsigned int id = plugin->get_id();
-					if (command_chunks.find(id) == command_chunks.end()) {
-						command_chunks[id].plugin = plugin;
-						command_chunks[id].request.mutable_header()->CopyFrom(request_message.header());
+				const std::string &command = request_message.payload(i).command();
+				keys.push_back(commands_.make_key(command));
+				plugins.push_back(commands_.get(keys.back()));
+				if (!plugins.back()) {
+					str::format::append_list(missing_commands, keys.back());
+					is_single = false;
+				} else if (keys.back() != command || (i > 0 && plugins.back()->get_id() != plugins.front()->get_id())) {
+					is_single = false;
+				}
+			}
+			if (is_single && !plugins.empty()) {
+				single_plugin = plugins.front();
+			} else {
+				for (int i = 0; i < request_message.payload_size(); i++) {
+					if (!plugins[i])
+						continue;
+					unsigned int id = plugins[i]->get_id();
+					if (chunk_index.find(id) == chunk_index.end()) {
+						chunk_index[id] = fanout->chunks.size();
+						fanout->chunks.push_back(command_chunk());
+						fanout->chunks.back().plugin = plugins[i];
+						fanout->chunks.back().request.mutable_header()->CopyFrom(request_message.header());
 					}
-					command_chunks[id].request.add_payload()->CopyFrom(*payload);
-				} else {
-					str::format::append_list(missing_commands, payload->command());
+					command_chunk &chunk = fanout->chunks[chunk_index[id]];
+					::Plugin::QueryRequestMessage::Request *payload = chunk.request.add_payload();
+					payload->CopyFrom(request_message.payload(i));
+					payload->set_command(keys[i]);
+					chunk.payloads.push_back(i);
 				}
 			}
 		}
 
-		if (command_chunks.size() == 0) {
+		if (!single_plugin && fanout->chunks.size() == 0) {
 			LOG_ERROR_CORE("Unknown command(s): " + missing_commands + " available commands: " + commands_.to_string());
 			Plugin::QueryResponseMessage::Response *payload = response_message.add_payload();
 			payload->set_command(missing_commands);
 			nscapi::protobuf::functions::set_response_bad(*payload, "Unknown command(s): " + missing_commands);
-			response = response_message.SerializeAsString();
 			return NSCAPI::cmd_return_codes::isSuccess;
 		}
 
-		BOOST_FOREACH(command_chunk_type::value_type &v, command_chunks) {
-			std::string local_response;
-			int ret = v.second.plugin->handleCommand(v.second.request.SerializeAsString(), local_response);
-			if (ret != NSCAPI::cmd_return_codes::isSuccess) {
+		if (single_plugin) {
+			if (single_plugin->handleCommand(request_message, response_message) != NSCAPI::cmd_return_codes::isSuccess) {
 				LOG_ERROR_CORE("Failed to execute command");
+				response_message.Clear();
+			}
+			return NSCAPI::cmd_return_codes::isSuccess;
+		}
+
+		fanout->states.resize(fanout->chunks.size(), query_fanout::pending);
+		boost::system_time deadline = boost::get_system_time() + boost::posix_time::seconds(query_timeout_);
+		// Queries made from a worker run inline so a worker never waits for tasks queued behind itself.
+		std::vector<std::size_t> local;
+		executor_type executor = executor_;
+		bool use_executor = executor && !(is_worker_ && is_worker_());
+		for (std::size_t i = 0; i < fanout->chunks.size(); i++) {
+			if (!use_executor || !executor(boost::bind(&query_fanout::run_task, fanout, i)))
+				local.push_back(i);
+		}
+		BOOST_FOREACH(std::size_t i, local) {
+			if (query_timeout_ > 0 && boost::get_system_time() >= deadline)
+				break;
+			fanout->run(i);
+		}
+		fanout->wait(query_timeout_ > 0, deadline);
+
+		// Payloads are returned in the order they were requested (chunk, payload) where -1 means all payloads of the chunk.
+		std::vector<std::pair<int, int> > order(request_message.payload_size(), std::make_pair(-1, -1));
+		// Chunks without a response (timed out or failed) get an UNKNOWN payload in the position of each of their payloads.
+		std::vector<std::string> failed(fanout->chunks.size());
+		for (std::size_t c = 0; c < fanout->chunks.size(); c++) {
+			command_chunk &chunk = fanout->chunks[c];
+			if (!fanout->is_done(c)) {
+				LOG_ERROR_CORE("Timeout waiting for: " + chunk.plugin->get_alias_or_name());
+				failed[c] = "UNKNOWN: timeout";
+			} else if (!chunk.error.empty()) {
+				LOG_ERROR_CORE("Failed to execute command: " + chunk.error);
+				failed[c] = "UNKNOWN: " + chunk.error;
+			} else if (chunk.result != NSCAPI::cmd_return_codes::isSuccess) {
+				LOG_ERROR_CORE("Failed to execute command");
+				failed[c] = "UNKNOWN: Failed to execute command";
+			} else if (!response_message.has_header()) {
+				response_message.mutable_header()->Swap(chunk.response.mutable_header());
+			}
+			if (!failed[c].empty() || chunk.response.payload_size() == static_cast<int>(chunk.payloads.size())) {
+				for (std::size_t j = 0; j < chunk.payloads.size(); j++)
+					order[chunk.payloads[j]] = std::make_pair(static_cast<int>(c), static_cast<int>(j));
 			} else {
-				Plugin::QueryResponseMessage local_response_message;
-				local_response_message.ParseFromString(local_response);
-				if (!response_message.has_header()) {
-					response_message.mutable_header()->CopyFrom(local_response_message.header());
-				}
-				for (int i = 0; i < local_response_message.payload_size(); i++) {
-					response_message.add_payload()->CopyFrom(local_response_message.payload(i));
-				}
+				order[chunk.payloads.front()] = std::make_pair(static_cast<int>(c), -1);
+			}
+		}
+		for (std::size_t i = 0; i < order.size(); i++) {
+			if (order[i].first < 0)
+				continue;
+			command_chunk &chunk = fanout->chunks[order[i].first];
+			if (!failed[order[i].first].empty()) {
+				// A timed out chunk is still running so we must not touch it
+				Plugin::QueryResponseMessage::Response *payload = response_message.add_payload();
+				payload->set_command(request_message.payload(static_cast<int>(i)).command());
+				nscapi::protobuf::functions::set_response_bad(*payload, failed[order[i].first]);
+			} else if (order[i].second < 0) {
+				for (int j = 0; j < chunk.response.payload_size(); j++)
+					response_message.add_payload()->Swap(chunk.response.mutable_payload(j));
+			} else {
+				response_message.add_payload()->Swap(chunk.response.mutable_payload(order[i].second));
 			}
 		}
-		response = response_message.SerializeAsString();
 	} catch (const std::exception &e) {
 		LOG_ERROR_CORE("Failed to process command: " + utf8::utf8_from_native(e.what()));
 		return NSCAPI::cmd_return_codes::hasFailed;
@@ -509,6 +639,12 @@ NSCAPI::nagiosReturn nsclient::core::plugin_manager::execute_query(const std::st
 	return NSCAPI::cmd_return_codes::isSuccess;
 }
 
+void nsclient::core::plugin_manager::set_executor(executor_type executor, worker_check_type is_worker, int query_timeout) {
+	executor_ = executor;
+	is_worker_ = is_worker;
+	query_timeout_ = query_timeout;
+}
+
 int nsclient::core::plugin_manager::load_and_run(std::string module, run_function fun, std::list<std::string> &errors) {
 	if (!module.empty()) {
 		plugin_type match = plugin_list_.find_by_module(module);
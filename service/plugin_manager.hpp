@@ -33,6 +33,7 @@
 #include <settings/settings_core.hpp>
 
 #include <boost/shared_ptr.hpp>
+#include <boost/function.hpp>
 #include <boost/filesystem/path.hpp>
 #include <boost/optional.hpp>
 #include <boost/algorithm/string.hpp>
@@ -82,6 +83,8 @@ namespace nsclient {
 		class plugin_manager : public boost::enable_shared_from_this<plugin_manager> {
 		public:
 			typedef boost::shared_ptr<nsclient::core::plugin_interface> plugin_type;
+			typedef boost::function<bool(boost::function<void()>)> executor_type;
+			typedef boost::function<bool()> worker_check_type;
 		private:
 
 			boost::filesystem::path plugin_path_;
@@ -95,6 +98,11 @@ namespace nsclient {
 			nsclient::event_subscribers event_subscribers_;
 			nsclient::core::master_plugin_list plugin_list_;
 			nsclient::core::path_instance path_;
+			// Queries spanning several plug-ins are spread over the executor (when set).
+			executor_type executor_;
+			// True when called from one of the executor's own threads.
+			worker_check_type is_worker_;
+			int query_timeout_;
 
 		public:
 			plugin_manager(nsclient::core::path_instance path_, nsclient::logging::logger_instance log_instance);
@@ -133,7 +141,9 @@ namespace nsclient {
 			int load_and_run(std::string module, run_function fun, std::list<std::string> &errors);
 			NSCAPI::errorReturn send_notification(const char* channel, std::string &request, std::string &response);
 			NSCAPI::nagiosReturn execute_query(const std::string &request, std::string &response);
+			NSCAPI::nagiosReturn execute_query(const ::Plugin::QueryRequestMessage &request, ::Plugin::QueryResponseMessage &response);
 			::Plugin::QueryResponseMessage execute_query(const ::Plugin::QueryRequestMessage &);
+			void set_executor(executor_type executor, worker_check_type is_worker, int query_timeout);
 			std::wstring execute(std::wstring password, std::wstring cmd, std::list<std::wstring> args);
 			int simple_exec(std::string command, std::vector<std::string> arguments, std::list<std::string> &resp);
 			int simple_query(std::string module, std::string command, std::vector<std::string> arguments, std::list<std::string> &resp);
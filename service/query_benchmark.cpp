@@ -0,0 +1,208 @@
+/*
+ * Copyright (C) 2004-2016 Michael Medin
+ *
+ * This file is part of NSClient++ - https://nsclient.org
+ *
+ * NSClient++ is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * NSClient++ is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with NSClient++.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "plugin_manager.hpp"
+#include "registry_query_handler.hpp"
+#include "core_api.h"
+#include "benchmark_helpers.hpp"
+#include "../libs/settings_manager/settings_manager_impl.h"
+
+#include <nscapi/nscapi_protobuf_functions.hpp>
+
+#include <iostream>
+#include <string>
+#include <cstring>
+#include <cstdlib>
+
+#include <boost/filesystem.hpp>
+#include <boost/date_time/posix_time/posix_time.hpp>
+
+namespace pt = boost::posix_time;
+
+struct benchmark_settings_provider : public settings_manager::provider_interface {
+	nsclient::logging::logger_instance logger;
+	benchmark_settings_provider(nsclient::logging::logger_instance logger) : logger(logger) {}
+	std::string expand_path(std::string file) { return file; }
+	nsclient::logging::logger_instance get_logger() const { return logger; }
+};
+
+namespace {
+	nsclient::logging::logger_instance log_instance;
+	nsclient::core::plugin_mgr_instance plugins;
+	nsclient::core::path_instance no_path;
+}
+
+//////////////////////////////////////////////////////////////////////////
+// The parts of the core API (core_api.cpp) used by the plug-in and the benchmark.
+// The real ones go through NSClient++ itself so they are wired to the benchmark's plug-in manager here.
+//
+
+void NSAPISimpleMessage(const char* module, int loglevel, const char* file, int line, const char* message) {
+	if (loglevel == NSCAPI::log_level::critical || loglevel == NSCAPI::log_level::error)
+		log_instance->error(module, file, line, message);
+	else if (loglevel == NSCAPI::log_level::warning)
+		log_instance->warning(module, file, line, message);
+}
+void NSAPIMessage(const char* data, unsigned int count) {
+	log_instance->raw(std::string(data, count));
+}
+NSCAPI::nagiosReturn NSAPIInject(const char *request_buffer, const unsigned int request_buffer_len, char **response_buffer, unsigned int *response_buffer_len) {
+	std::string request(request_buffer, request_buffer_len), response;
+	NSCAPI::nagiosReturn ret = plugins->execute_query(request, response);
+	*response_buffer_len = static_cast<unsigned int>(response.size());
+	if (response.empty())
+		*response_buffer = NULL;
+	else {
+		*response_buffer = new char[*response_buffer_len + 10];
+		memcpy(*response_buffer, response.c_str(), *response_buffer_len);
+	}
+	return ret;
+}
+void NSAPIGetProtobufRuntime(const void **messages, const void **library) {
+	nscapi::protobuf::get_runtime(messages, library);
+}
+NSCAPI::nagiosReturn NSAPIInjectMessage(const void *request, void *response) {
+	return plugins->execute_query(*static_cast<const Plugin::QueryRequestMessage*>(request), *static_cast<Plugin::QueryResponseMessage*>(response));
+}
+NSCAPI::errorReturn NSAPIRegistryQuery(const char *request_buffer, const unsigned int request_buffer_len, char **response_buffer, unsigned int *response_buffer_len) {
+	Plugin::RegistryRequestMessage request;
+	Plugin::RegistryResponseMessage response;
+	request.ParseFromArray(request_buffer, request_buffer_len);
+	nsclient::core::registry_query_handler rqh(no_path, plugins, log_instance, request);
+	rqh.parse(response);
+	*response_buffer_len = response.ByteSize();
+	*response_buffer = new char[*response_buffer_len + 10];
+	response.SerializeToArray(*response_buffer, *response_buffer_len);
+	return NSCAPI::api_return_codes::isSuccess;
+}
+void NSAPIDestroyBuffer(char**buffer) {
+	delete[] * buffer;
+}
+NSCAPI::log_level::level NSAPIGetLoglevel() {
+	return NSCAPI::log_level::error;
+}
+nscapi::core_api::FUNPTR NSAPILoader(const char* buffer) {
+	if (strcmp(buffer, "NSAPIMessage") == 0)
+		return reinterpret_cast<nscapi::core_api::FUNPTR>(&NSAPIMessage);
+	if (strcmp(buffer, "NSAPISimpleMessage") == 0)
+		return reinterpret_cast<nscapi::core_api::FUNPTR>(&NSAPISimpleMessage);
+	if (strcmp(buffer, "NSAPIInject") == 0)
+		return reinterpret_cast<nscapi::core_api::FUNPTR>(&NSAPIInject);
+	if (strcmp(buffer, "NSAPIInjectMessage") == 0)
+		return reinterpret_cast<nscapi::core_api::FUNPTR>(&NSAPIInjectMessage);
+	if (strcmp(buffer, "NSAPIGetProtobufRuntime") == 0)
+		return reinterpret_cast<nscapi::core_api::FUNPTR>(&NSAPIGetProtobufRuntime);
+	if (strcmp(buffer, "NSAPIRegistryQuery") == 0)
+		return reinterpret_cast<nscapi::core_api::FUNPTR>(&NSAPIRegistryQuery);
+	if (strcmp(buffer, "NSAPIDestroyBuffer") == 0)
+		return reinterpret_cast<nscapi::core_api::FUNPTR>(&NSAPIDestroyBuffer);
+	if (strcmp(buffer, "NSAPIGetLoglevel") == 0)
+		return reinterpret_cast<nscapi::core_api::FUNPTR>(&NSAPIGetLoglevel);
+	return NULL;
+}
+
+void report(const std::string &label, long long queries, long long ms, long long ok) {
+	std::cout << "  " << label << ms << "ms, " << (ms > 0 ? queries * 1000 / ms : 0) << " queries/s";
+	if (ok != queries)
+		std::cout << " (" << queries - ok << " failed)";
+	std::cout << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+	long long queries = 100000;
+	if (argc > 1)
+		queries = std::atol(argv[1]);
+	boost::filesystem::path module_path = argc > 2 ? argv[2] : "modules";
+
+	log_instance.reset(new stderr_logger());
+	benchmark_settings_provider provider(log_instance);
+	if (!settings_manager::init_settings(&provider, "dummy://")) {
+		std::cerr << "Failed to initialize settings" << std::endl;
+		return 1;
+	}
+	plugins.reset(new nsclient::core::plugin_manager(no_path, log_instance));
+	plugins->set_path(module_path);
+	if (!plugins->load_single_plugin("CheckHelpers", "", true)) {
+		std::cerr << "Failed to load CheckHelpers from: " << module_path.string() << std::endl;
+		return 1;
+	}
+
+	Plugin::QueryRequestMessage request;
+	Plugin::QueryRequestMessage::Request *payload = request.add_payload();
+	payload->set_command("check_ok");
+	payload->add_arguments("message=Everything is fine");
+
+	nscapi::core_api::lpNSAPIInject inject = reinterpret_cast<nscapi::core_api::lpNSAPIInject>(NSAPILoader("NSAPIInject"));
+	nscapi::core_api::lpNSAPIInjectMessage inject_message = reinterpret_cast<nscapi::core_api::lpNSAPIInjectMessage>(NSAPILoader("NSAPIInjectMessage"));
+
+	std::cout << "Running " << queries << " check_ok queries against CheckHelpers" << std::endl;
+
+	// What a plug-in which does not share our protobuf runtime pays (and what every query used to)
+	long long ok = 0;
+	pt::ptime start = pt::microsec_clock::universal_time();
+	for (long long i = 0; i < queries; i++) {
+		std::string request_buffer = request.SerializeAsString();
+		char *buffer = NULL;
+		unsigned int len = 0;
+		if (inject(request_buffer.c_str(), static_cast<unsigned int>(request_buffer.size()), &buffer, &len) != NSCAPI::cmd_return_codes::isSuccess)
+			continue;
+		Plugin::QueryResponseMessage response;
+		response.ParseFromArray(buffer, len);
+		NSAPIDestroyBuffer(&buffer);
+		if (response.payload_size() == 1 && response.payload(0).result() == Plugin::Common_ResultCode_OK)
+			ok++;
+	}
+	report("NSAPIInject (serialized path):       ", queries, elapsed_ms(start), ok);
+
+	ok = 0;
+	start = pt::microsec_clock::universal_time();
+	for (long long i = 0; i < queries; i++) {
+		Plugin::QueryResponseMessage response;
+		if (inject_message(&request, &response) != NSCAPI::cmd_return_codes::isSuccess)
+			continue;
+		if (response.payload_size() == 1 && response.payload(0).result() == Plugin::Common_ResultCode_OK)
+			ok++;
+	}
+	report("NSAPIInjectMessage (message path):   ", queries, elapsed_ms(start), ok);
+
+	// The plug-in hop on its own: NSHandleCommand (serialized) vs NSHandleCommandMessage
+	nsclient::commands::plugin_type plugin = plugins->get_commands()->get("check_ok");
+	ok = 0;
+	start = pt::microsec_clock::universal_time();
+	for (long long i = 0; i < queries; i++) {
+		Plugin::QueryResponseMessage response;
+		if (plugin->plugin_interface::handleCommand(request, response) == NSCAPI::cmd_return_codes::isSuccess && response.payload_size() == 1)
+			ok++;
+	}
+	report("plug-in hop, NSHandleCommand:        ", queries, elapsed_ms(start), ok);
+
+	ok = 0;
+	start = pt::microsec_clock::universal_time();
+	for (long long i = 0; i < queries; i++) {
+		Plugin::QueryResponseMessage response;
+		if (plugin->handleCommand(request, response) == NSCAPI::cmd_return_codes::isSuccess && response.payload_size() == 1)
+			ok++;
+	}
+	report("plug-in hop, NSHandleCommandMessage: ", queries, elapsed_ms(start), ok);
+
+	plugins->stop_plugins();
+	plugins.reset();
+	settings_manager::destroy_settings();
+	return 0;
+}
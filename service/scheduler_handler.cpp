@@ -49,6 +49,9 @@ namespace task_scheduler {
 	void scheduler::handle_metrics() {
 		mainClient->process_metrics();
 	}
+	void scheduler::handle_storage() {
+		mainClient->get_storage_manager()->maintain();
+	}
 
 	void scheduler::start() {
 		tasks.set_handler(this);
@@ -84,6 +87,9 @@ namespace task_scheduler {
 		} else if (metadata.source == schedule_metadata::METRICS) {
 			handle_metrics();
 			return true;
+		} else if (metadata.source == schedule_metadata::STORAGE) {
+			handle_storage();
+			return true;
 		} else if (metadata.source == schedule_metadata::RELOAD) {
 			handle_reload(metadata);
 			return false;
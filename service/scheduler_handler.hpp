@@ -29,6 +29,7 @@ namespace task_scheduler {
 			MODULE,
 			SETTINGS,
 			METRICS,
+			STORAGE,
 			RELOAD
 		};
 		int plugin_id;
@@ -47,6 +48,7 @@ namespace task_scheduler {
 		void handle_reload(const schedule_metadata &metadata);
 		void handle_settings();
 		void handle_metrics();
+		void handle_storage();
 
 		const simple_scheduler::scheduler& get_scheduler() {
 			return tasks;
@@ -61,5 +63,8 @@ namespace task_scheduler {
 		virtual void on_error(const char* file, int line, std::string error);
 		virtual void on_trace(const char* file, int line, std::string error);
 		void set_threads(int count);
+		void set_executor(simple_scheduler::scheduler::executor_type executor) {
+			tasks.set_executor(executor);
+		}
 	};
 }
\ No newline at end of file
@@ -0,0 +1,141 @@
+/*
+ * Copyright (C) 2004-2016 Michael Medin
+ *
+ * This file is part of NSClient++ - https://nsclient.org
+ *
+ * NSClient++ is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * NSClient++ is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with NSClient++.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "storage_manager.hpp"
+#include "benchmark_helpers.hpp"
+
+#include <iostream>
+#include <string>
+#include <cstdlib>
+#include <algorithm>
+
+#include <boost/filesystem.hpp>
+#include <boost/thread.hpp>
+#include <boost/bind.hpp>
+#include <boost/algorithm/string/predicate.hpp>
+#include <boost/date_time/posix_time/posix_time.hpp>
+
+#include <str/xtos.hpp>
+
+namespace pt = boost::posix_time;
+
+Plugin::Storage_Entry make_entry(const std::string &context, long long i) {
+	Plugin::Storage_Entry entry;
+	entry.set_context(context);
+	entry.set_key("key-" + str::xtos(i));
+	entry.mutable_value()->set_string_data("value-" + str::xtos(i * 7919));
+	return entry;
+}
+
+// How get() used to find entries (a scan of all keys)
+std::size_t legacy_get(const nsclient::core::storage_manager::storage_type &storage, const std::string &prefix) {
+	std::size_t count = 0;
+	for (nsclient::core::storage_manager::storage_type::const_iterator it = storage.begin(); it != storage.end(); ++it) {
+		if (boost::algorithm::starts_with(it->first, prefix))
+			count++;
+	}
+	return count;
+}
+
+int main(int argc, char* argv[]) {
+	long long keys = 1000000;
+	if (argc > 1)
+		keys = std::atol(argv[1]);
+	boost::filesystem::path data_path = argc > 2 ? argv[2] : "storage_benchmark.data";
+	const long long contexts = 1000;
+	const long long batch = 100;
+
+	boost::filesystem::remove_all(data_path);
+	nsclient::logging::logger_instance logger(new stderr_logger());
+	nsclient::core::path_instance no_path;
+
+	std::cout << "Storing " << keys << " keys in " << contexts << " contexts" << std::endl;
+	{
+		nsclient::core::storage_manager storage(no_path, logger);
+		storage.set_sync_policy(nsclient::core::storage_manager::sync_never);
+		storage.load(data_path.string());
+
+		pt::ptime start = pt::microsec_clock::universal_time();
+		for (long long i = 0; i < keys; i++)
+			storage.put("bench", make_entry("context-" + str::xtos(i % contexts), i));
+		long long ms = elapsed_ms(start);
+		std::cout << "  put (one at a time):  " << ms << "ms, " << (ms > 0 ? keys * 1000 / ms : 0) << " keys/s" << std::endl;
+
+		start = pt::microsec_clock::universal_time();
+		for (long long i = 0; i < keys; i += batch) {
+			nsclient::core::storage_manager::entry_list entries;
+			for (long long j = i; j < i + batch && j < keys; j++)
+				entries.push_back(make_entry("context-" + str::xtos(j % contexts), j));
+			storage.put("bench", entries);
+		}
+		ms = elapsed_ms(start);
+		std::cout << "  put (batches of " << batch << "): " << ms << "ms, " << (ms > 0 ? keys * 1000 / ms : 0) << " keys/s" << std::endl;
+		std::cout << "  journal:              " << boost::filesystem::file_size(data_path / "nsclient.journal") / 1024 / 1024 << "MB" << std::endl;
+
+		const long long lookups = 100;
+		std::size_t found = 0;
+		start = pt::microsec_clock::universal_time();
+		for (long long i = 0; i < lookups; i++)
+			found += storage.get("bench", "context-" + str::xtos(i * 7 % contexts)).size();
+		ms = elapsed_ms(start);
+		std::cout << "  get (range scan):     " << ms * 1000 / lookups << "us per context (" << found / lookups << " entries)" << std::endl;
+
+		nsclient::core::storage_manager::storage_type legacy;
+		for (long long i = 0; i < keys; i++) {
+			Plugin::Storage_Entry entry = make_entry("context-" + str::xtos(i % contexts), i);
+			legacy["bench." + entry.context() + "." + entry.key()] = nsclient::core::storage_item("bench", entry);
+		}
+		found = 0;
+		start = pt::microsec_clock::universal_time();
+		for (long long i = 0; i < lookups; i++)
+			found += legacy_get(legacy, "bench.context-" + str::xtos(i * 7 % contexts) + ".");
+		ms = elapsed_ms(start);
+		std::cout << "  get (full scan):      " << ms * 1000 / lookups << "us per context (" << found / lookups << " entries)" << std::endl;
+
+		start = pt::microsec_clock::universal_time();
+		storage.save();
+		std::cout << "  compact:              " << elapsed_ms(start) << "ms, " << boost::filesystem::file_size(data_path / "nsclient.db") / 1024 / 1024 << "MB" << std::endl;
+
+		// Puts made while the snapshot is written only wait for the entries to be copied
+		long long during = 0, worst = 0;
+		boost::thread compaction(boost::bind(&nsclient::core::storage_manager::save, &storage));
+		while (!compaction.timed_join(pt::milliseconds(0))) {
+			start = pt::microsec_clock::universal_time();
+			storage.put("bench", make_entry("during-compact", during++));
+			worst = std::max(worst, elapsed_ms(start));
+		}
+		std::cout << "  put (during compact): " << during << " keys, " << worst << "ms at most" << std::endl;
+
+		const long long synced = 1000;
+		storage.set_sync_policy(nsclient::core::storage_manager::sync_always);
+		start = pt::microsec_clock::universal_time();
+		for (long long i = 0; i < synced; i++)
+			storage.put("bench", make_entry("synced", i));
+		ms = elapsed_ms(start);
+		std::cout << "  put (sync always):    " << ms * 1000 / synced << "us per key" << std::endl;
+	}
+	{
+		nsclient::core::storage_manager storage(no_path, logger);
+		pt::ptime start = pt::microsec_clock::universal_time();
+		storage.load(data_path.string());
+		std::cout << "  load (snapshot+journal): " << elapsed_ms(start) << "ms, " << storage.get("bench", "context-1").size() << " entries in context-1" << std::endl;
+	}
+	boost::filesystem::remove_all(data_path);
+	return 0;
+}
@@ -5,60 +5,255 @@
 
 #include <boost/thread/locks.hpp>
 #include <boost/foreach.hpp>
-#include <boost/algorithm/string/predicate.hpp>
+#include <boost/filesystem.hpp>
 
 #include <google/protobuf/io/zero_copy_stream.h>
 #include <google/protobuf/io/zero_copy_stream_impl.h>
 #include <google/protobuf/io/coded_stream.h>
 
 #include <fstream>
+#include <algorithm>
+#include <cstdio>
 
+#ifdef WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#include <fcntl.h>
+#endif
+
+// The separator sorts before any printable character so all keys for a given owner and context form a single range.
 std::string mk_key(const std::string &plugin_name, const std::string &context, const std::string key = "") {
-	return plugin_name + "." + context + "." + key;
+	return plugin_name + '\0' + context + '\0' + key;
 }
 
 template<typename T>
-bool read_chunk(::google::protobuf::io::CodedInputStream &stream, T &obj) {
+bool read_chunk(::google::protobuf::io::ZeroCopyInputStream &raw, T &obj) {
+	::google::protobuf::io::CodedInputStream stream(&raw);
 	uint32_t size = 0;
-	stream.ReadVarint32(&size);
 	std::string tmp;
-	stream.ReadString(&tmp, size);
-	obj.ParseFromString(tmp);
+	if (!stream.ReadVarint32(&size) || !stream.ReadString(&tmp, size))
+		return false;
+	return obj.ParseFromString(tmp);
+}
+
+template<typename T>
+bool write_chunk(::google::protobuf::io::CodedOutputStream &stream, const T &obj) {
+	std::string tmp;
+	obj.SerializeToString(&tmp);
+	stream.WriteVarint32(tmp.size());
+	stream.WriteString(tmp);
+	return !stream.HadError();
+}
+
+class file_output_stream : public google::protobuf::io::CopyingOutputStream {
+	FILE *file_;
+public:
+	file_output_stream(FILE *file) : file_(file) {}
+	bool Write(const void *buffer, int size) {
+		return std::fwrite(buffer, 1, size, file_) == static_cast<std::size_t>(size);
+	}
+};
+
+void erase_entries(nsclient::core::storage_manager::storage_type &storage, const std::string &owner, const ::Plugin::Storage::Entry &entry) {
+	if (entry.has_key()) {
+		storage.erase(mk_key(owner, entry.context(), entry.key()));
+		return;
+	}
+	std::string key = mk_key(owner, entry.context());
+	nsclient::core::storage_manager::storage_type::iterator first = storage.lower_bound(key), last = first;
+	while (last != storage.end() && last->first.compare(0, key.size(), key) == 0)
+		++last;
+	storage.erase(first, last);
+}
+
+void load_block(nsclient::core::storage_manager::storage_type &storage, ::Plugin::Storage::Block &block) {
+	if (block.removed()) {
+		erase_entries(storage, block.owner(), block.entry());
+		return;
+	}
+	nsclient::core::storage_item &item = storage[mk_key(block.owner(), block.entry().context(), block.entry().key())];
+	item.owner = block.owner();
+	item.entry.Swap(block.mutable_entry());
+}
+
+bool sync_file(FILE *file) {
+	if (std::fflush(file) != 0)
+		return false;
+#ifdef WIN32
+	return _commit(_fileno(file)) == 0;
+#else
+	return fsync(fileno(file)) == 0;
+#endif
+}
+
+// Makes a rename in the folder durable (on Windows the rename itself is)
+bool sync_directory(const std::string &path) {
+#ifdef WIN32
 	return true;
+#else
+	int fd = open(path.c_str(), O_RDONLY);
+	if (fd < 0)
+		return false;
+	bool ok = fsync(fd) == 0;
+	close(fd);
+	return ok;
+#endif
+}
+
+bool append_file(const std::string &source, const std::string &target) {
+	FILE *in = std::fopen(source.c_str(), "rb");
+	if (in == NULL)
+		return false;
+	FILE *out = std::fopen(target.c_str(), "ab");
+	if (out == NULL) {
+		std::fclose(in);
+		return false;
+	}
+	bool ok = true;
+	char buffer[64 * 1024];
+	std::size_t len;
+	while (ok && (len = std::fread(buffer, 1, sizeof(buffer), in)) > 0)
+		ok = std::fwrite(buffer, 1, len, out) == len;
+	ok = !std::ferror(in) && sync_file(out) && ok;
+	std::fclose(in);
+	std::fclose(out);
+	return ok;
+}
+
+nsclient::core::storage_manager::storage_manager(nsclient::core::path_instance path_, nsclient::logging::logger_instance logger)
+	: path_(path_)
+	, logger_(logger)
+	, has_read_(false)
+	, journal_(NULL)
+	, journal_size_(0)
+	, snapshot_size_(0)
+	, compact_size_(1024 * 1024)
+	, journal_dirty_(false)
+	, sync_policy_(sync_interval) {}
+
+nsclient::core::storage_manager::~storage_manager() {
+	close_journal();
 }
-void nsclient::core::storage_manager::load() {
-	std::string file = get_filename();
 
-	std::ifstream in(file.c_str(), std::ios::in | std::ios::binary);
+nsclient::core::storage_manager::sync_policy nsclient::core::storage_manager::parse_sync_policy(const std::string &policy) {
+	if (policy == "always")
+		return sync_always;
+	if (policy == "never")
+		return sync_never;
+	return sync_interval;
+}
 
-	typedef boost::shared_ptr<google::protobuf::io::ZeroCopyInputStream> istr_type;
-	typedef boost::shared_ptr<google::protobuf::io::CodedInputStream> codedstr_type;
-	istr_type raw_in = istr_type(new ::google::protobuf::io::IstreamInputStream(&in));
-	codedstr_type coded_in = codedstr_type(new ::google::protobuf::io::CodedInputStream(raw_in.get()));
+void nsclient::core::storage_manager::load() {
+	load(path_->expand_path("${data-path}"));
+}
 
-	::Plugin::Storage::File header;
-	if (!read_chunk(*coded_in, header)) {
-		LOG_ERROR_CORE("Failed to read storage.");
+void nsclient::core::storage_manager::load(const std::string &data_path) {
+	boost::unique_lock<boost::shared_mutex> writeLock(m_mutexRW, boost::get_system_time() + boost::posix_time::seconds(5));
+	if (!writeLock.owns_lock()) {
+		LOG_ERROR_CORE("FATAL ERROR: Could not get write-mutex.");
 		return;
 	}
-	for (long long i = 0; i < header.entries(); i++) {
-		::Plugin::Storage::Block block;
-		if (!read_chunk(*coded_in, block)) {
-			LOG_ERROR_CORE("Failed to read block " + str::xtos(i) + " from storage.");
-			continue;
+	close_journal();
+	storage_.clear();
+	data_path_ = data_path;
+	snapshot_size_ = 0;
+	journal_size_ = 0;
+
+	std::string file = get_filename();
+	if (file_helpers::checks::is_file(file)) {
+		std::ifstream in(file.c_str(), std::ios::in | std::ios::binary);
+		::google::protobuf::io::IstreamInputStream raw_in(&in);
+
+		::Plugin::Storage::File header;
+		if (!read_chunk(raw_in, header)) {
+			LOG_ERROR_CORE("Failed to read storage.");
+		} else {
+			for (long long i = 0; i < header.entries(); i++) {
+				::Plugin::Storage::Block block;
+				if (!read_chunk(raw_in, block)) {
+					LOG_ERROR_CORE("Failed to read block " + str::xtos(i) + " from storage.");
+					break;
+				}
+				load_block(storage_, block);
+			}
+			snapshot_size_ = raw_in.ByteCount();
 		}
-		storage_[mk_key(block.owner(), block.entry().context(), block.entry().key())] = storage_item(block.owner(), block.entry());
 	}
+
+	// Replay puts made after the snapshot was written: first a journal moved aside by an unfinished compaction, then the current one.
+	journal_size_ = replay_journal(get_oldjournalname());
+	journal_size_ += replay_journal(get_journalname());
+	open_journal();
+}
+
+// Needs the write lock, returns the size of the records replayed (a torn record at the end, from a crash, is dropped).
+boost::uintmax_t nsclient::core::storage_manager::replay_journal(const std::string &journal) {
+	if (!file_helpers::checks::is_file(journal))
+		return 0;
+	boost::uintmax_t size = 0;
+	std::ifstream in(journal.c_str(), std::ios::in | std::ios::binary);
+	::google::protobuf::io::IstreamInputStream raw_in(&in);
+	::Plugin::Storage::Block block;
+	long long count = 0;
+	while (read_chunk(raw_in, block)) {
+		load_block(storage_, block);
+		size = raw_in.ByteCount();
+		count++;
+	}
+	in.close();
+	boost::system::error_code ec;
+	if (boost::filesystem::file_size(journal, ec) != size && !ec) {
+		LOG_ERROR_CORE("Discarding incomplete record at the end of " + journal);
+		boost::filesystem::resize_file(journal, size, ec);
+	}
+	if (count > 0) {
+		LOG_DEBUG_CORE("Replayed " + str::xtos(count) + " entries from " + journal);
+	}
+	return size;
 }
 
 void nsclient::core::storage_manager::put(std::string plugin_name, const ::Plugin::Storage_Entry& entry) {
+	entry_list entries;
+	entries.push_back(entry);
+	put(plugin_name, entries);
+}
+
+void nsclient::core::storage_manager::put(std::string plugin_name, const entry_list &entries) {
+	boost::unique_lock<boost::shared_mutex> writeLock(m_mutexRW, boost::get_system_time() + boost::posix_time::seconds(5));
+	if (!writeLock.owns_lock()) {
+		LOG_ERROR_CORE("FATAL ERROR: Could not get write-mutex.");
+		return;
+	}
+	append_journal(plugin_name, entries);
+	BOOST_FOREACH(const ::Plugin::Storage_Entry &entry, entries) {
+		storage_[mk_key(plugin_name, entry.context(), entry.key())] = storage_item(plugin_name, entry);
+	}
+}
+
+void nsclient::core::storage_manager::remove(std::string plugin_name, std::string context) {
+	::Plugin::Storage_Entry entry;
+	entry.set_context(context);
+	remove(plugin_name, entry);
+}
+
+void nsclient::core::storage_manager::remove(std::string plugin_name, std::string context, std::string key) {
+	::Plugin::Storage_Entry entry;
+	entry.set_context(context);
+	entry.set_key(key);
+	remove(plugin_name, entry);
+}
+
+void nsclient::core::storage_manager::remove(const std::string &plugin_name, const ::Plugin::Storage_Entry &entry) {
 	boost::unique_lock<boost::shared_mutex> writeLock(m_mutexRW, boost::get_system_time() + boost::posix_time::seconds(5));
 	if (!writeLock.owns_lock()) {
 		LOG_ERROR_CORE("FATAL ERROR: Could not get write-mutex.");
 		return;
 	}
-	std::string key = mk_key(plugin_name, entry.context(), entry.key());
-	storage_[key] = storage_item(plugin_name, entry);
+	entry_list entries;
+	entries.push_back(entry);
+	append_journal(plugin_name, entries, true);
+	erase_entries(storage_, plugin_name, entry);
 }
 
 nsclient::core::storage_manager::entry_list nsclient::core::storage_manager::get(std::string plugin_name, std::string context) {
@@ -69,68 +264,239 @@ nsclient::core::storage_manager::entry_list nsclient::core::storage_manager::get
 		return ret;
 	}
 	std::string key = mk_key(plugin_name, context);
-	BOOST_FOREACH(const storage_type::value_type &v, storage_) {
-		if (boost::algorithm::starts_with(v.first, key)) {
-			ret.push_back(v.second.entry);
-		}
+	for (storage_type::const_iterator it = storage_.lower_bound(key); it != storage_.end() && it->first.compare(0, key.size(), key) == 0; ++it) {
+		ret.push_back(it->second.entry);
 	}
 	return ret;
 }
 
-template<typename T> 
-bool write_chunk(::google::protobuf::io::CodedOutputStream &stream, const T &obj) {
-	std::string tmp;
-	obj.SerializeToString(&tmp);
-	stream.WriteVarint32(tmp.size());
-	stream.WriteString(tmp);
+boost::optional<Plugin::Storage_Entry> nsclient::core::storage_manager::get(std::string plugin_name, std::string context, std::string key) {
+	boost::shared_lock<boost::shared_mutex> readLock(m_mutexRW, boost::get_system_time() + boost::posix_time::seconds(5));
+	if (!readLock.owns_lock()) {
+		LOG_ERROR_CORE("FATAL ERROR: Could not get read-mutex.");
+		return boost::optional<Plugin::Storage_Entry>();
+	}
+	storage_type::const_iterator it = storage_.find(mk_key(plugin_name, context, key));
+	if (it == storage_.end())
+		return boost::optional<Plugin::Storage_Entry>();
+	return it->second.entry;
+}
+
+// Needs the write lock
+bool nsclient::core::storage_manager::append_journal(const std::string &owner, const entry_list &entries, bool removed) {
+	if (journal_ == NULL)
+		return false;
+	std::string buffer;
+	{
+		::google::protobuf::io::StringOutputStream raw_out(&buffer);
+		::google::protobuf::io::CodedOutputStream coded_out(&raw_out);
+		::Plugin::Storage::Block block;
+		block.set_owner(owner);
+		if (removed)
+			block.set_removed(true);
+		BOOST_FOREACH(const ::Plugin::Storage_Entry &entry, entries) {
+			block.mutable_entry()->CopyFrom(entry);
+			write_chunk(coded_out, block);
+		}
+	}
+	if (std::fwrite(buffer.c_str(), 1, buffer.size(), journal_) != buffer.size() || std::fflush(journal_) != 0) {
+		LOG_ERROR_CORE("Failed to write to " + get_journalname() + ", changes will be kept in memory until the storage is saved.");
+		close_journal();
+		return false;
+	}
+	journal_size_ += buffer.size();
+	if (sync_policy_ == sync_always)
+		return sync_journal();
+	journal_dirty_ = true;
 	return true;
 }
 
-void nsclient::core::storage_manager::save() {
+// Needs the write lock
+bool nsclient::core::storage_manager::sync_journal() {
+	journal_dirty_ = false;
+	if (journal_ == NULL || sync_file(journal_))
+		return true;
+	LOG_ERROR_CORE("Failed to sync " + get_journalname());
+	return false;
+}
+
+bool nsclient::core::storage_manager::open_journal() {
+	try {
+		std::string file = get_journalname();
+		std::string path = file_helpers::meta::get_path(file);
+		if (!path.empty() && !file_helpers::checks::is_directory(path)) {
+			boost::filesystem::create_directories(path);
+		}
+		journal_ = std::fopen(file.c_str(), "ab");
+		if (journal_ == NULL) {
+			LOG_ERROR_CORE("Failed to open " + file + ", changes will be kept in memory until the storage is saved.");
+			return false;
+		}
+		return true;
+	} catch (const std::exception &e) {
+		LOG_ERROR_CORE("Failed to open storage journal: " + utf8::utf8_from_native(e.what()));
+	}
+	return false;
+}
+
+void nsclient::core::storage_manager::close_journal() {
+	if (journal_ != NULL) {
+		if (journal_dirty_ && sync_policy_ != sync_never)
+			sync_journal();
+		std::fclose(journal_);
+		journal_ = NULL;
+	}
+}
+
+void nsclient::core::storage_manager::maintain() {
+	{
+		boost::unique_lock<boost::shared_mutex> writeLock(m_mutexRW, boost::get_system_time() + boost::posix_time::seconds(5));
+		if (!writeLock.owns_lock()) {
+			LOG_ERROR_CORE("FATAL ERROR: Could not get write-mutex.");
+			return;
+		}
+		if (journal_dirty_ && sync_policy_ != sync_never)
+			sync_journal();
+		if (journal_size_ <= std::max(compact_size_, snapshot_size_))
+			return;
+	}
+	compact();
+}
+
+// Writes a new snapshot and removes the journal.
+// The journal is moved aside under the write lock, the entries are then serialized a few at a time under short read locks
+// and written with no lock held. Puts made meanwhile may or may not end up in the snapshot but are always in the new journal.
+bool nsclient::core::storage_manager::compact() {
+	boost::unique_lock<boost::timed_mutex> compactLock(compact_mutex_, boost::get_system_time() + boost::posix_time::seconds(5));
+	if (!compactLock.owns_lock()) {
+		LOG_ERROR_CORE("FATAL ERROR: Could not get compact-mutex.");
+		return false;
+	}
 	try {
 		{
-			std::string file = get_tmpname();
-			std::string path = file_helpers::meta::get_path(file);
-			if (!file_helpers::checks::is_file(path)) {
-				boost::filesystem::create_directories(path);
+			boost::unique_lock<boost::shared_mutex> writeLock(m_mutexRW, boost::get_system_time() + boost::posix_time::seconds(5));
+			if (!writeLock.owns_lock()) {
+				LOG_ERROR_CORE("FATAL ERROR: Could not get write-mutex.");
+				return false;
 			}
-			std::ofstream out(file.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
-
-			typedef boost::shared_ptr<google::protobuf::io::ZeroCopyOutputStream> istr_type;
-			typedef boost::shared_ptr<google::protobuf::io::CodedOutputStream> codedstr_type;
-			istr_type raw_out = istr_type(new ::google::protobuf::io::OstreamOutputStream(&out));
-			codedstr_type coded_out = codedstr_type(new ::google::protobuf::io::CodedOutputStream(raw_out.get()));
-
-			::Plugin::Storage::File header;
-			header.set_version(1);
-			header.set_entries(storage_.size());
-			if (!write_chunk<>(*coded_out, header)) {
-				LOG_ERROR_CORE("Failed to write header to storage.");
-				return;
+			if (!rotate_journal())
+				return false;
+		}
+
+		std::string buffer;
+		long long count = 0;
+		std::string last_key;
+		bool done = false;
+		while (!done) {
+			boost::shared_lock<boost::shared_mutex> readLock(m_mutexRW, boost::get_system_time() + boost::posix_time::seconds(5));
+			if (!readLock.owns_lock()) {
+				LOG_ERROR_CORE("FATAL ERROR: Could not get read-mutex.");
+				return false;
 			}
+			::google::protobuf::io::StringOutputStream raw_out(&buffer);
+			::google::protobuf::io::CodedOutputStream coded_out(&raw_out);
+			::Plugin::Storage::Block block;
+			storage_type::const_iterator it = count == 0 ? storage_.begin() : storage_.upper_bound(last_key);
+			for (int i = 0; i < 1000 && it != storage_.end(); i++, ++it) {
+				block.set_owner(it->second.owner);
+				block.mutable_entry()->CopyFrom(it->second.entry);
+				write_chunk(coded_out, block);
+				last_key = it->first;
+				count++;
+			}
+			done = it == storage_.end();
+		}
 
-			BOOST_FOREACH(const storage_type::value_type &v, storage_) {
-				::Plugin::Storage::Block block;
-				block.set_owner(v.second.owner);
-				block.mutable_entry()->CopyFrom(v.second.entry);
-				if (!write_chunk(*coded_out, block)) {
-					LOG_ERROR_CORE("Failed to write block to storage.");
-					return;
-				}
+		std::string file = get_tmpname();
+		FILE *out = std::fopen(file.c_str(), "wb");
+		if (out == NULL) {
+			LOG_ERROR_CORE("Failed to open " + file);
+			return false;
+		}
+		bool ok = true;
+		{
+			file_output_stream stream(out);
+			::google::protobuf::io::CopyingOutputStreamAdaptor raw_out(&stream);
+			{
+				::google::protobuf::io::CodedOutputStream coded_out(&raw_out);
+				::Plugin::Storage::File header;
+				header.set_version(1);
+				header.set_entries(count);
+				ok = write_chunk<>(coded_out, header);
+				coded_out.WriteRaw(buffer.data(), static_cast<int>(buffer.size()));
+				ok = !coded_out.HadError() && ok;
 			}
+			ok = raw_out.Flush() && ok;
+		}
+		ok = sync_file(out) && ok;
+		std::fclose(out);
+		if (!ok) {
+			LOG_ERROR_CORE("Failed to write storage to " + file);
+			return false;
 		}
 		boost::filesystem::rename(get_tmpname(), get_filename());
+		if (!sync_directory(data_path_)) {
+			LOG_ERROR_CORE("Failed to sync " + data_path_ + ", keeping " + get_oldjournalname());
+			return false;
+		}
+		boost::uintmax_t size = boost::filesystem::file_size(get_filename());
+
+		// Everything in the old journal is now in the snapshot
+		boost::filesystem::remove(get_oldjournalname());
+		boost::unique_lock<boost::shared_mutex> writeLock(m_mutexRW);
+		snapshot_size_ = size;
+		return true;
 	} catch (const std::exception &e) {
-		LOG_ERROR_CORE("Failed to save settings: " + utf8::utf8_from_native(e.what()));
+		LOG_ERROR_CORE("Failed to save storage: " + utf8::utf8_from_native(e.what()));
 	} catch (...) {
-		LOG_ERROR_CORE("Failed to save settings: UNKNOWN EXCEPTION");
+		LOG_ERROR_CORE("Failed to save storage: UNKNOWN EXCEPTION");
 	}
+	return false;
+}
 
+// Needs the write lock.
+// Moves the journal aside (appending it to one left by a failed compaction) and starts a new one.
+bool nsclient::core::storage_manager::rotate_journal() {
+	std::string path = data_path_;
+	if (!path.empty() && !file_helpers::checks::is_directory(path)) {
+		boost::filesystem::create_directories(path);
+	}
+	close_journal();
+	std::string journal = get_journalname();
+	std::string old = get_oldjournalname();
+	if (file_helpers::checks::is_file(journal)) {
+		if (!file_helpers::checks::is_file(old)) {
+			boost::filesystem::rename(journal, old);
+		} else if (!append_file(journal, old)) {
+			LOG_ERROR_CORE("Failed to append " + journal + " to " + old);
+			open_journal();
+			return false;
+		}
+	}
+	journal_ = std::fopen(journal.c_str(), "wb");
+	journal_size_ = 0;
+	journal_dirty_ = false;
+	if (journal_ == NULL) {
+		LOG_ERROR_CORE("Failed to open " + journal + ", changes will be kept in memory until the storage is saved.");
+	}
+	return true;
+}
+
+void nsclient::core::storage_manager::save() {
+	if (data_path_.empty())
+		data_path_ = path_->expand_path("${data-path}");
+	compact();
 }
 
 std::string nsclient::core::storage_manager::get_filename() {
-	return path_->expand_path("${data-path}/nsclient.db");
+	return data_path_ + "/nsclient.db";
 }
 std::string nsclient::core::storage_manager::get_tmpname() {
-	return path_->expand_path("${data-path}/nsclient.tmp");
+	return data_path_ + "/nsclient.tmp";
+}
+std::string nsclient::core::storage_manager::get_journalname() {
+	return data_path_ + "/nsclient.journal";
+}
+std::string nsclient::core::storage_manager::get_oldjournalname() {
+	return data_path_ + "/nsclient.journal.old";
 }
@@ -7,10 +7,12 @@
 #include <nscapi/nscapi_protobuf.hpp>
 
 #include <boost/thread/shared_mutex.hpp>
+#include <boost/thread/mutex.hpp>
 #include <boost/optional.hpp>
 
 #include <string>
 #include <list>
+#include <cstdio>
 
 namespace nsclient {
 	namespace core {
@@ -44,33 +46,77 @@ namespace nsclient {
 			}
 		};
 
+		// Entries are kept in an ordered map (keyed on owner, context and key) backed by a snapshot (nsclient.db)
+		// and an append-only journal of puts (and removals) made since the snapshot was written.
+		// The journal is folded into a new snapshot (compacted) once it outgrows the snapshot.
+		// While compacting the journal is moved aside (nsclient.journal.old) until the new snapshot is in place.
 		class storage_manager {
 		public:
 			typedef std::map<std::string, storage_item> storage_type;
-			typedef std::list<std::string> key_list_type;
 			typedef std::list<Plugin::Storage_Entry> entry_list;
 
+			enum sync_policy {
+				sync_never,		// Leave it to the OS to write the journal to disk
+				sync_interval,	// Sync the journal from maintain()
+				sync_always		// Sync the journal after each put
+			};
+
 		private:
 			nsclient::core::path_instance path_;
 			nsclient::logging::logger_instance logger_;
 			storage_type storage_;
-			key_list_type deleted_;
 			bool has_read_;
 			boost::shared_mutex m_mutexRW;
-			
+			boost::timed_mutex compact_mutex_;
+
+			std::string data_path_;
+			FILE *journal_;
+			boost::uintmax_t journal_size_;
+			boost::uintmax_t snapshot_size_;
+			boost::uintmax_t compact_size_;
+			bool journal_dirty_;
+			sync_policy sync_policy_;
+
 		public:
-			storage_manager(nsclient::core::path_instance path_, nsclient::logging::logger_instance logger) : path_(path_), logger_(logger), has_read_(false) {}
+			storage_manager(nsclient::core::path_instance path_, nsclient::logging::logger_instance logger);
+			~storage_manager();
+
+			void set_sync_policy(sync_policy policy) {
+				sync_policy_ = policy;
+			}
+			static sync_policy parse_sync_policy(const std::string &policy);
+			void set_compact_size(boost::uintmax_t size) {
+				compact_size_ = size;
+			}
+
 			void load();
+			void load(const std::string &data_path);
 			void put(std::string plugin_name, const ::Plugin::Storage_Entry& entry);
+			void put(std::string plugin_name, const entry_list &entries);
+			void remove(std::string plugin_name, std::string context);
+			void remove(std::string plugin_name, std::string context, std::string key);
 			entry_list get(std::string plugin_name, std::string context);
+			boost::optional<Plugin::Storage_Entry> get(std::string plugin_name, std::string context, std::string key);
+			void maintain();
 			void save();
 
 		private:
 			nsclient::logging::logger_instance get_logger() {
 				return logger_;
 			}
+			void remove(const std::string &plugin_name, const ::Plugin::Storage_Entry &entry);
+			bool append_journal(const std::string &owner, const entry_list &entries, bool removed = false);
+			bool sync_journal();
+			bool open_journal();
+			void close_journal();
+			bool compact();
+			bool rotate_journal();
+			boost::uintmax_t replay_journal(const std::string &journal);
+
 			std::string get_filename();
 			std::string get_tmpname();
+			std::string get_journalname();
+			std::string get_oldjournalname();
 		};
 		typedef boost::shared_ptr<storage_manager> storage_manager_instance;
 
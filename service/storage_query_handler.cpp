@@ -22,37 +22,66 @@ namespace nsclient {
 
 
 		void storage_query_handler::parse(Plugin::StorageResponseMessage &response) {
-
+			// Consecutive puts from the same plugin are written as one batch.
+			long long put_id = 0;
+			nsclient::core::storage_manager::entry_list puts;
 			BOOST_FOREACH(const Plugin::StorageRequestMessage::Request &r, request_.payload()) {
+				if (r.has_put()) {
+					if (!puts.empty() && r.id() != put_id) {
+						parse_puts(put_id, puts);
+					}
+					put_id = r.id();
+					puts.push_back(r.put().entry());
+					continue;
+				}
+				if (!puts.empty()) {
+					parse_puts(put_id, puts);
+				}
 				if (r.has_get()) {
 					parse_get(r.id(), r.get(), response);
-				} else if (r.has_put()) {
-					parse_put(r.id(), r.put(), response);
+				} else if (r.has_remove()) {
+					parse_remove(r.id(), r.remove());
 				} else {
 					LOG_ERROR_CORE("Storage query: Unsupported action");
 				}
 			}
+			if (!puts.empty()) {
+				parse_puts(put_id, puts);
+			}
 		}
 
-		void storage_query_handler::parse_get(const long long plugin_id, const Plugin::StorageRequestMessage::Request::Get &q, Plugin::StorageResponseMessage &response) {
-			Plugin::StorageResponseMessage::Response *payload = response.add_payload();
-			std::string plugin_name = "";
+		std::string storage_query_handler::get_plugin_name(const long long plugin_id) {
 			nsclient::core::plugin_manager::plugin_type plugin = plugins_->find_plugin(plugin_id);
 			if (plugin) {
-				plugin_name = plugin->get_alias_or_name();
+				return plugin->get_alias_or_name();
+			}
+			return "";
+		}
+
+		void storage_query_handler::parse_get(const long long plugin_id, const Plugin::StorageRequestMessage::Request::Get &q, Plugin::StorageResponseMessage &response) {
+			Plugin::StorageResponseMessage::Response *payload = response.add_payload();
+			std::string plugin_name = get_plugin_name(plugin_id);
+			if (q.has_key()) {
+				boost::optional<Plugin::Storage_Entry> e = storage_->get(plugin_name, q.context(), q.key());
+				if (e) {
+					payload->mutable_get()->add_entry()->CopyFrom(*e);
+				}
+				return;
 			}
 			BOOST_FOREACH(const ::Plugin::Storage_Entry &e, storage_->get(plugin_name, q.context())) {
 				payload->mutable_get()->add_entry()->CopyFrom(e);
 			}
 		}
-		void storage_query_handler::parse_put(const long long plugin_id, const Plugin::StorageRequestMessage::Request::Put &q, Plugin::StorageResponseMessage &response) {
-			std::string plugin_name = "";
-			nsclient::core::plugin_manager::plugin_type plugin = plugins_->find_plugin(plugin_id);
-			if (plugin) {
-				plugin_name = plugin->get_alias_or_name();
-			}
-			storage_->put(plugin_name, q.entry());
+		void storage_query_handler::parse_puts(const long long plugin_id, nsclient::core::storage_manager::entry_list &entries) {
+			storage_->put(get_plugin_name(plugin_id), entries);
+			entries.clear();
+		}
 
+		void storage_query_handler::parse_remove(const long long plugin_id, const Plugin::StorageRequestMessage::Request::Remove &q) {
+			if (q.has_key())
+				storage_->remove(get_plugin_name(plugin_id), q.context(), q.key());
+			else
+				storage_->remove(get_plugin_name(plugin_id), q.context());
 		}
 
 		plugin_cache_item storage_query_handler::inventory_plugin_on_disk(nsclient::core::plugin_cache::plugin_cache_list_type &list, std::string plugin) {
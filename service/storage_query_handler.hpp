@@ -27,7 +27,8 @@ namespace nsclient {
 			void parse(Plugin::StorageResponseMessage &response);
 
 			void parse_get(const long long plugin_id, const Plugin::StorageRequestMessage::Request::Get &q, Plugin::StorageResponseMessage &response);
-			void parse_put(const long long plugin_id, const Plugin::StorageRequestMessage::Request::Put &q, Plugin::StorageResponseMessage &response);
+			void parse_puts(const long long plugin_id, nsclient::core::storage_manager::entry_list &entries);
+			void parse_remove(const long long plugin_id, const Plugin::StorageRequestMessage::Request::Remove &q);
 
 			//void find_plugins_on_disk(boost::unordered_set<std::string> &unique_instances, const Plugin::StorageRequestMessage::Request::Inventory &q, Plugin::StorageResponseMessage::Response* rp);
 
@@ -35,6 +36,7 @@ namespace nsclient {
 			nsclient::logging::logger_instance get_logger() const {
 				return logger_;
 			}
+			std::string get_plugin_name(const long long plugin_id);
 			void add_module(Plugin::StorageResponseMessage::Response* rp, const plugin_cache_item &plugin);
 			plugin_cache_item inventory_plugin_on_disk(nsclient::core::plugin_cache::plugin_cache_list_type &list, std::string plugin);
 
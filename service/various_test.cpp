@@ -19,6 +19,9 @@
 
 #include <str/format.hpp>
 #include <str/utils.hpp>
+#include <threads/mpsc_ring.hpp>
+
+#include <boost/thread.hpp>
 
 #include <vector>
 #include <string>
@@ -155,3 +158,71 @@ TEST(format, format_date) {
 	boost::posix_time::ptime time(boost::gregorian::date(2002, 3, 4), boost::posix_time::time_duration(5, 6, 7));
 	EXPECT_EQ(str::format::format_date(time), "2002-03-04 05:06:07");
 }
+
+TEST(mpsc_ring, fifo_and_full) {
+	nscp_thread::mpsc_ring<int> ring(4);
+	std::size_t pos;
+	for (int i = 0; i < 4; i++) {
+		int *v = ring.claim(pos);
+		ASSERT_TRUE(v != NULL);
+		*v = i;
+		ring.publish(pos);
+	}
+	EXPECT_TRUE(ring.claim(pos) == NULL);
+	for (int i = 0; i < 10; i++) {
+		ASSERT_TRUE(ring.front() != NULL);
+		EXPECT_EQ(*ring.front(), i);
+		ring.pop();
+		int *v = ring.claim(pos);
+		ASSERT_TRUE(v != NULL);
+		*v = i + 4;
+		ring.publish(pos);
+	}
+}
+
+TEST(mpsc_ring, unpublished_blocks_consumer) {
+	nscp_thread::mpsc_ring<int> ring(4);
+	std::size_t first, second;
+	*ring.claim(first) = 1;
+	*ring.claim(second) = 2;
+	ring.publish(second);
+	EXPECT_TRUE(ring.front() == NULL);
+	ring.publish(first);
+	ASSERT_TRUE(ring.front() != NULL);
+	EXPECT_EQ(*ring.front(), 1);
+	ring.pop();
+	ASSERT_TRUE(ring.front() != NULL);
+	EXPECT_EQ(*ring.front(), 2);
+}
+
+void mpsc_ring_producer(nscp_thread::mpsc_ring<int> *ring, int count) {
+	for (int i = 1; i <= count; i++) {
+		std::size_t pos;
+		int *v;
+		while ((v = ring->claim(pos)) == NULL)
+			boost::this_thread::yield();
+		*v = i;
+		ring->publish(pos);
+	}
+}
+
+TEST(mpsc_ring, many_producers) {
+	nscp_thread::mpsc_ring<int> ring(64);
+	boost::thread_group producers;
+	for (int i = 0; i < 4; i++)
+		producers.create_thread(boost::bind(&mpsc_ring_producer, &ring, 10000));
+	long long sum = 0;
+	for (int received = 0; received < 40000;) {
+		int *v = ring.front();
+		if (v == NULL) {
+			boost::this_thread::yield();
+			continue;
+		}
+		sum += *v;
+		ring.pop();
+		received++;
+	}
+	producers.join_all();
+	EXPECT_EQ(sum, 4 * (10000LL * 10001 / 2));
+	EXPECT_TRUE(ring.front() == NULL);
+}